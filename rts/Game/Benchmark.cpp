@@ -0,0 +1,233 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Benchmark.h"
+#include "Game/CommandMessage.h"
+#include "Game/GlobalUnsynced.h"
+#include "Net/Protocol/NetProtocol.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/SpringExitCode.h"
+#include "System/StringUtil.h"
+#include "System/TimeProfiler.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/Misc.h"
+
+// number of frames requested from the server per skip; large enough
+// to keep the client busy, small enough to not buffer the whole demo
+static constexpr int SKIP_CHUNK_FRAMES = 300;
+
+CBenchmark benchmark;
+
+
+
+static float Percentile(const std::vector<float>& sortedTimes, float p)
+{
+	if (sortedTimes.empty())
+		return 0.0f;
+
+	// nearest-rank
+	const size_t rank = std::max(size_t(1), static_cast<size_t>(p * sortedTimes.size() + 0.999f));
+	return sortedTimes[std::min(rank, sortedTimes.size()) - 1];
+}
+
+static void WriteJSONString(FILE* file, const std::string& str)
+{
+	fputc('"', file);
+
+	for (const char c: str) {
+		if (c == '"' || c == '\\')
+			fputc('\\', file);
+
+		fputc(c, file);
+	}
+
+	fputc('"', file);
+}
+
+
+
+bool CBenchmark::Init(const std::string& reportFileName, const std::string& limitsStr)
+{
+	Kill();
+
+	if (!ParseLimits(limitsStr))
+		return false;
+
+	reportFile = reportFileName;
+	frameTimes.reserve(GAME_SPEED * 60 * 60);
+
+	startTime = spring_gettime();
+	enabled = true;
+
+	// per-timer totals are only collected for every timer while enabled
+	profiler.SetEnabled(true);
+
+	LOG("[Benchmark::%s] writing report to \"%s\"", __func__, reportFile.c_str());
+	return true;
+}
+
+void CBenchmark::Kill()
+{
+	reportFile.clear();
+	limits.clear();
+	frameTimes.clear();
+
+	firstFrame = -1;
+	requestedFrame = 0;
+
+	enabled = false;
+	demoEnded = false;
+}
+
+bool CBenchmark::ParseLimits(const std::string& limitsStr)
+{
+	static const char* validKeys[] = {"mean", "p50", "p90", "p99", "max"};
+
+	size_t beg = 0;
+
+	while (beg < limitsStr.size()) {
+		size_t end = limitsStr.find(',', beg);
+
+		if (end == std::string::npos)
+			end = limitsStr.size();
+
+		const std::string pair = limitsStr.substr(beg, end - beg);
+		const size_t sep = pair.find('=');
+
+		beg = end + 1;
+
+		if (pair.empty())
+			continue;
+
+		const std::string key = StringToLower(pair.substr(0, sep));
+		const auto keyPred = [&](const char* k) { return (key == k); };
+
+		if (sep == std::string::npos || std::find_if(std::begin(validKeys), std::end(validKeys), keyPred) == std::end(validKeys)) {
+			LOG_L(L_ERROR, "[Benchmark::%s] invalid limit \"%s\" (expected key=msecs with key one of mean,p50,p90,p99,max)", __func__, pair.c_str());
+			return false;
+		}
+
+		limits.push_back({key, std::strtof(pair.c_str() + sep + 1, nullptr)});
+	}
+
+	return true;
+}
+
+
+bool CBenchmark::Update(int frameNum)
+{
+	if (!enabled)
+		return true;
+
+	if (demoEnded)
+		return (Finish(frameNum));
+
+	if ((frameNum + SKIP_CHUNK_FRAMES / 2) < requestedFrame)
+		return true;
+
+	// ask the server to stream the next chunk of the demo without
+	// pacing; it silently ignores requests until the game started
+	// so keep re-requesting once the client has caught up
+	requestedFrame = std::max(frameNum, 0) + SKIP_CHUNK_FRAMES;
+
+	CommandMessage pckt("skip f" + IntToString(requestedFrame), gu->myPlayerNum);
+	clientNet->Send(pckt.Pack());
+	return true;
+}
+
+void CBenchmark::AddSimFrame(int frameNum, spring_time frameTime)
+{
+	if (!enabled)
+		return;
+
+	if (firstFrame < 0)
+		firstFrame = frameNum;
+
+	frameTimes.push_back(frameTime.toMilliSecsf());
+}
+
+
+bool CBenchmark::Finish(int frameNum)
+{
+	enabled = false;
+
+	std::vector<float> sortedTimes = frameTimes;
+	std::sort(sortedTimes.begin(), sortedTimes.end());
+
+	float totalTime = 0.0f;
+
+	for (const float t: frameTimes) {
+		totalTime += t;
+	}
+
+	const auto GetStat = [&](const std::string& key) {
+		if (key == "mean") return (totalTime / std::max(size_t(1), frameTimes.size()));
+		if (key == "p50") return (Percentile(sortedTimes, 0.50f));
+		if (key == "p90") return (Percentile(sortedTimes, 0.90f));
+		if (key == "p99") return (Percentile(sortedTimes, 0.99f));
+		if (key == "max") return (sortedTimes.empty()? 0.0f: sortedTimes.back());
+		return 0.0f;
+	};
+
+	bool passed = true;
+
+	for (const Limit& limit: limits) {
+		if (GetStat(limit.key) <= limit.value)
+			continue;
+
+		LOG_L(L_ERROR, "[Benchmark::%s] %s frame-time %.3fms exceeds limit %.3fms", __func__, limit.key.c_str(), GetStat(limit.key), limit.value);
+		passed = false;
+	}
+
+	// resort so timers first hit during the replay are included
+	profiler.Update();
+
+	FILE* file = fopen(reportFile.c_str(), "w");
+
+	if (file == nullptr) {
+		LOG_L(L_ERROR, "[Benchmark::%s] could not open \"%s\" for writing", __func__, reportFile.c_str());
+	} else {
+		fprintf(file, "{\n");
+		fprintf(file, "\t\"firstFrame\": %d,\n", firstFrame);
+		fprintf(file, "\t\"lastFrame\": %d,\n", frameNum);
+		fprintf(file, "\t\"numFrames\": %u,\n", unsigned(frameTimes.size()));
+		fprintf(file, "\t\"wallTime\": %.3f,\n", (spring_gettime() - startTime).toSecsf());
+		fprintf(file, "\t\"peakMemoryMB\": %.1f,\n", Platform::GetPeakMemoryUsage() / (1024.0f * 1024.0f));
+		fprintf(file, "\t\"simTime\": {\"total\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+			totalTime, GetStat("mean"), GetStat("p50"), GetStat("p90"), GetStat("p99"), GetStat("max"));
+
+		fprintf(file, "\t\"limits\": {");
+		for (size_t i = 0; i < limits.size(); i++) {
+			fprintf(file, "%s\"%s\": %.3f", (i > 0)? ", ": "", limits[i].key.c_str(), limits[i].value);
+		}
+		fprintf(file, "},\n");
+		fprintf(file, "\t\"passed\": %s,\n", passed? "true": "false");
+
+		fprintf(file, "\t\"timers\": {");
+		for (const auto& p: profiler.GetSortedProfiles()) {
+			fprintf(file, "%s\n\t\t", (&p != &profiler.GetSortedProfiles().front())? ",": "");
+			WriteJSONString(file, p.first);
+			fprintf(file, ": %.3f", p.second.total.toMilliSecsf());
+		}
+		fprintf(file, "\n\t},\n");
+
+		fprintf(file, "\t\"frameTimes\": [");
+		for (size_t i = 0; i < frameTimes.size(); i++) {
+			fprintf(file, "%s%s%.3f", (i > 0)? ",": "", ((i % 16) == 0)? "\n\t\t": " ", frameTimes[i]);
+		}
+		fprintf(file, "\n\t]\n");
+		fprintf(file, "}\n");
+		fclose(file);
+	}
+
+	LOG("[Benchmark::%s] %u frames, mean=%.3fms p50=%.3fms p99=%.3fms max=%.3fms (%s)", __func__,
+		unsigned(frameTimes.size()), GetStat("mean"), GetStat("p50"), GetStat("p99"), GetStat("max"), passed? "passed": "FAILED");
+
+	if (!passed || file == nullptr)
+		spring::exitCode = spring::EXIT_CODE_REGRESS;
+
+	return false;
+}
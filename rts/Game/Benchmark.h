@@ -0,0 +1,66 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+#include "System/Misc/SpringTime.h"
+
+/**
+ * Demo-replay benchmark, meant for spring-headless on CI machines.
+ *
+ * While a demo is being replayed this requests it from the (local) server
+ * in skip-chunks so frames are simulated at unlimited speed, records the
+ * duration of every SimFrame and writes a JSON report with per-frame times,
+ * percentiles, peak memory and per-timer totals when the demo ends. If any
+ * limit is exceeded the engine exits with EXIT_CODE_REGRESS.
+ */
+class CBenchmark
+{
+public:
+	/**
+	 * @param reportFile path the JSON report is written to
+	 * @param limits comma-separated "key=msecs" pairs where key is one of
+	 *   mean, p50, p90, p99 or max, e.g. "p50=5,p99=20,max=100"
+	 */
+	bool Init(const std::string& reportFile, const std::string& limits);
+	void Kill();
+
+	/// returns false once the report has been written and the game should exit
+	bool Update(int frameNum);
+
+	void AddSimFrame(int frameNum, spring_time frameTime);
+	void DemoEnded() { demoEnded = true; }
+
+	bool IsEnabled() const { return enabled; }
+
+private:
+	bool Finish(int frameNum);
+	bool ParseLimits(const std::string& limits);
+
+private:
+	struct Limit {
+		std::string key;
+		float value;
+	};
+
+	std::string reportFile;
+
+	std::vector<Limit> limits;
+	/// sim-time of each frame in milliseconds, indexed by frameNum - firstFrame
+	std::vector<float> frameTimes;
+
+	spring_time startTime;
+
+	int firstFrame = -1;
+	int requestedFrame = 0;
+
+	bool enabled = false;
+	bool demoEnded = false;
+};
+
+extern CBenchmark benchmark;
+
+#endif // BENCHMARK_H
@@ -19,6 +19,8 @@ CONFIG(int, HostPortDefault).defaultValue(8452).minimumValue(0).maximumValue(655
 ClientSetup::ClientSetup()
 	: hostIP(configHandler->GetString("HostIPDefault"))
 	, hostPort(configHandler->GetInt("HostPortDefault"))
+	, autohostIP(configHandler->GetString("AutohostIP"))
+	, autohostPort(configHandler->GetInt("AutohostPort"))
 	, isHost(false)
 {
 }
@@ -59,17 +61,13 @@ void ClientSetup::LoadFromStartScript(const std::string& setup)
 
 	// FIXME WTF
 	std::string sourceport;
-	std::string autohostip;
-	std::string autohostport;
 
 	if (file.SGetValue(sourceport, "GAME\\SourcePort"))
 		configHandler->SetString("SourcePort", sourceport, true);
 
-	if (file.SGetValue(autohostip, "GAME\\AutohostIP"))
-		configHandler->SetString("AutohostIP", autohostip, true);
-
-	if (file.SGetValue(autohostport, "GAME\\AutohostPort"))
-		configHandler->SetString("AutohostPort", autohostport, true);
+	// kept out of the config, a dedicated server can host several games
+	file.GetDef(autohostIP,   autohostIP, "GAME\\AutohostIP");
+	file.GetDef(autohostPort, IntToString(autohostPort), "GAME\\AutohostPort");
 
 	file.GetDef(saveFile, "", "GAME\\SaveFile");
 	file.GetDef(demoFile, "", "GAME\\DemoFile");
@@ -27,6 +27,10 @@ public:
 	//! if this client is the server player, the port over which we accept incoming connections
 	int hostPort;
 
+	//! if this client is the server player, where to find the autohost (if any)
+	std::string autohostIP;
+	int autohostPort;
+
 	bool isHost;
 };
 
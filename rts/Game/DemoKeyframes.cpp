@@ -0,0 +1,198 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <zlib.h>
+
+#include "DemoKeyframes.h"
+#include "Game/CommandMessage.h"
+#include "Game/GameSetup.h"
+#include "Game/GlobalUnsynced.h"
+#include "Game/Players/Player.h"
+#include "Game/Players/PlayerHandler.h"
+#include "Net/Protocol/NetProtocol.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/StringUtil.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/LoadSave/CregLoadSaveHandler.h"
+#include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/DemoRecorder.h"
+#include "System/Log/ILog.h"
+
+// reloading costs about as much as simulating this many frames
+static constexpr int MIN_SEEK_FRAMES = GAME_SPEED * 60;
+
+CDemoKeyframes demoKeyframes;
+
+
+
+static bool InflateKeyframe(const std::vector<std::uint8_t>& data, std::string& state)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+
+	// +32 accepts the gzip header written by CDemoRecorder::AddKeyframe
+	if (inflateInit2(&zs, 15 + 32) != Z_OK)
+		return false;
+
+	char buffer[64 * 1024];
+	int ret = Z_OK;
+
+	zs.next_in = const_cast<Bytef*>(data.data());
+	zs.avail_in = data.size();
+
+	while (ret == Z_OK) {
+		zs.next_out = reinterpret_cast<Bytef*>(buffer);
+		zs.avail_out = sizeof(buffer);
+
+		ret = inflate(&zs, Z_NO_FLUSH);
+		state.append(buffer, sizeof(buffer) - zs.avail_out);
+	}
+
+	inflateEnd(&zs);
+	return (ret == Z_STREAM_END);
+}
+
+/**
+ * Keyframes are made while recording, so the setup-script saved in them is
+ * that of the original game. Loading one has to restart the demo instead,
+ * so swap in the script of the game which is replaying it.
+ */
+static bool WriteKeyframeSave(const std::string& saveFile, const std::vector<std::uint8_t>& data)
+{
+	std::string state;
+
+	if (!InflateKeyframe(data, state))
+		return false;
+
+	// header is the engine version followed by the script (see CCregLoadSaveHandler::SaveGameData)
+	const size_t scriptBeg = state.find('\0') + 1;
+	const size_t scriptEnd = state.find('\0', scriptBeg);
+
+	if (scriptBeg == 0 || scriptEnd == std::string::npos)
+		return false;
+
+	state.replace(scriptBeg, scriptEnd - scriptBeg, gameSetup->setupText);
+
+	gzFile file = gzopen(dataDirsAccess.LocateFile(saveFile, FileQueryFlags::WRITE).c_str(), "wb1");
+
+	if (file == nullptr)
+		return false;
+
+	const bool ret = (gzwrite(file, state.data(), state.size()) == int(state.size()));
+	return ((gzclose(file) == Z_OK) && ret);
+}
+
+
+
+void CDemoKeyframes::Init(const std::string& demoFile, int keyframeInterval)
+{
+	Kill();
+
+	demoName = demoFile;
+	interval = keyframeInterval;
+}
+
+void CDemoKeyframes::Kill()
+{
+	// seekFrameNum is kept on purpose, it has to survive the reload
+	demoName.clear();
+
+	interval = 0;
+}
+
+
+void CDemoKeyframes::Update(int frameNum)
+{
+	if (seekFrameNum >= 0) {
+		// first frame after reloading from a keyframe, skip the rest of the way
+		if (seekFrameNum > frameNum) {
+			CommandMessage pckt("skip f" + IntToString(seekFrameNum), gu->myPlayerNum);
+			clientNet->Send(pckt.Pack());
+		}
+
+		seekFrameNum = -1;
+	}
+
+	if (interval <= 0 || (frameNum % interval) != 0)
+		return;
+
+	CDemoRecorder* record = clientNet->GetDemoRecorder();
+
+	if (!record->IsValid())
+		return;
+
+	// has to be made synchronously so the state is exactly that after <frameNum>,
+	// which is also the last packet recorded; the recorder compresses it later
+	CCregLoadSaveHandler ls;
+	std::stringstream oss;
+
+	ls.SaveInfo(gameSetup->mapName, gameSetup->modName);
+
+	if (!ls.SaveGameData(oss)) {
+		LOG_L(L_WARNING, "[DemoKeyframes::%s] could not save keyframe %d, disabling keyframes", __func__, frameNum);
+		interval = 0;
+		return;
+	}
+
+	record->AddKeyframe(frameNum, oss.str());
+}
+
+
+bool CDemoKeyframes::Seek(int curFrameNum, int frameNum)
+{
+	if (demoName.empty())
+		return false;
+
+	std::vector<std::uint8_t> data;
+	const std::string saveFile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + "demokeyframe.ssf";
+
+	int keyframe = 0;
+
+	try {
+		// a second reader, the server's is used by its own thread
+		CDemoReader reader(demoName, 0.0f);
+		reader.LoadKeyframeIndex();
+
+		const auto& index = reader.GetKeyframeIndex();
+		const auto pred = [](int f, const DemoKeyframeIndexEntry& e) { return (f < e.frameNum); };
+		const auto iter = std::upper_bound(index.begin(), index.end(), frameNum, pred);
+
+		if (iter == index.begin())
+			return false;
+
+		keyframe = (iter - 1)->frameNum;
+
+		// going forward, only reload when it saves enough simulation
+		if (frameNum >= curFrameNum && keyframe < (curFrameNum + MIN_SEEK_FRAMES))
+			return false;
+
+		if (!reader.LoadKeyframe((iter - 1) - index.begin(), data))
+			return false;
+	} catch (const std::exception& ex) {
+		LOG_L(L_WARNING, "[DemoKeyframes::%s] could not read keyframes of \"%s\" (%s)", __func__, demoName.c_str(), ex.what());
+		return false;
+	}
+
+	if (!WriteKeyframeSave(saveFile, data)) {
+		LOG_L(L_WARNING, "[DemoKeyframes::%s] could not extract keyframe %d to \"%s\"", __func__, keyframe, saveFile.c_str());
+		return false;
+	}
+
+	LOG("[DemoKeyframes::%s] reloading from keyframe %d to seek to frame %d", __func__, keyframe, frameNum);
+
+	// the server resumes the demo after <keyframe> (see CGameServer::PostLoad)
+	gameSetup->reloadScript  = "[GAME]\n{\n";
+	gameSetup->reloadScript += "\tSaveFile=" + saveFile + ";\n";
+	gameSetup->reloadScript += "\tIsHost=1;\n";
+	gameSetup->reloadScript += "\tMyPlayerName=" + playerHandler.Player(gu->myPlayerNum)->name + ";\n";
+	gameSetup->reloadScript += "}\n";
+	gu->globalReload = true;
+
+	seekFrameNum = frameNum;
+	return true;
+}
@@ -0,0 +1,42 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_KEYFRAMES_H
+#define DEMO_KEYFRAMES_H
+
+#include <string>
+
+/**
+ * Keyframes for seeking in a replay without re-simulating it from the start.
+ *
+ * While a demo is recorded with DemoKeyframeInterval > 0, a creg save-state
+ * is made every <interval> frames and handed to the demo recorder, which
+ * compresses it in the background and stores it with a frame-to-offset
+ * index after the stats (see DemoKeyframeIndexEntry).
+ * Seeking to a frame while replaying that demo then reloads the game from the
+ * closest keyframe before it (which also works backwards); the server resumes
+ * the demo right after that frame and the remainder is skipped as usual.
+ */
+class CDemoKeyframes
+{
+public:
+	void Init(const std::string& demoName, int interval);
+	void Kill();
+
+	/// called after each SimFrame
+	void Update(int frameNum);
+
+	/// returns false if no keyframe is closer to <frameNum> than the current frame
+	bool Seek(int curFrameNum, int frameNum);
+
+private:
+	/// demo being replayed, if any
+	std::string demoName;
+
+	int interval = 0;
+	/// frame to skip to once the game has been reloaded from a keyframe
+	int seekFrameNum = -1;
+};
+
+extern CDemoKeyframes demoKeyframes;
+
+#endif // DEMO_KEYFRAMES_H
@@ -3,11 +3,13 @@
 #include "Rendering/GL/myGL.h"
 
 #include "Game.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "CameraHandler.h"
 #include "ChatMessage.h"
 #include "CommandMessage.h"
 #include "ConsoleHistory.h"
+#include "DemoKeyframes.h"
 #include "GameHelper.h"
 #include "GameSetup.h"
 #include "GlobalUnsynced.h"
@@ -114,6 +116,8 @@
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
@@ -140,6 +144,11 @@ CONFIG(bool, ShowSpeed).defaultValue(false).description("Displays current game s
 CONFIG(int, ShowPlayerInfo).defaultValue(1).headlessValue(0);
 CONFIG(float, GuiOpacity).defaultValue(0.8f).minimumValue(0.0f).maximumValue(1.0f).description("Sets the opacity of the built-in Spring UI. Generally has no effect on LuaUI widgets. Can be set in-game using shift+, to decrease and shift+. to increase.");
 CONFIG(std::string, InputTextGeo).defaultValue("");
+CONFIG(std::string, ProfilerTraceFile).defaultValue("").description("If set, every profiler timer scope of a game is streamed to this file (relative to the write-dir) in Chrome trace-event JSON format, viewable in chrome://tracing or ui.perfetto.dev.");
+CONFIG(std::string, BenchmarkReportFile).defaultValue("").description("If set when replaying a demo, the demo is simulated at unlimited speed and a JSON report of per-frame sim-times, peak memory and profiler totals is written to this file (relative to the write-dir) before exiting.");
+CONFIG(std::string, BenchmarkLimits).defaultValue("").description("Comma-separated frame-time limits in milliseconds for BenchmarkReportFile, e.g. \"p50=5,p99=20,max=100\" (keys: mean, p50, p90, p99, max). Exceeding any makes the engine exit with a non-zero code.");
+CONFIG(int, SyncChecksumInterval).defaultValue(GAME_SPEED * 2).minimumValue(0).description("Every this many frames the client sends per-subsystem checksums of the sim state (units, features, projectiles, pathing, teams, RNG, Lua rules-params) to the server, which uses them to name the subsystem and frame in which a desync started. 0 disables.");
+CONFIG(int, DemoKeyframeInterval).defaultValue(0).minimumValue(0).description("If greater than 0, a save-state is stored in the recorded demo every this many frames (kept in memory until the game ends), which /demoseek uses to jump to a frame of the replay without re-simulating it from the start.");
 
 
 CGame* game = nullptr;
@@ -245,6 +254,21 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 	showSpeed = configHandler->GetBool("ShowSpeed");
 
 	speedControl = configHandler->GetInt("SpeedControl");
+	syncChecksumInterval = configHandler->GetInt("SyncChecksumInterval");
+
+	const std::string& traceFile = configHandler->GetString("ProfilerTraceFile");
+
+	if (!traceFile.empty())
+		profiler.StartTrace(dataDirsAccess.LocateFile(traceFile, FileQueryFlags::WRITE));
+
+	const std::string& benchmarkFile = configHandler->GetString("BenchmarkReportFile");
+
+	if (gameSetup->hostDemo && !benchmarkFile.empty()) {
+		if (!benchmark.Init(dataDirsAccess.LocateFile(benchmarkFile, FileQueryFlags::WRITE), configHandler->GetString("BenchmarkLimits")))
+			throw content_error("[Game] invalid BenchmarkLimits \"" + configHandler->GetString("BenchmarkLimits") + "\"");
+	}
+
+	demoKeyframes.Init(gameSetup->hostDemo? gameSetup->demoName: "", configHandler->GetInt("DemoKeyframeInterval"));
 
 	playerRoster.SetSortTypeByCode((PlayerRoster::SortType)configHandler->GetInt("ShowPlayerInfo"));
 
@@ -286,6 +310,10 @@ CGame::~CGame()
 	ENTER_SYNCED_CODE();
 	LOG("[Game::%s][1]", __func__);
 
+	profiler.StopTrace();
+	benchmark.Kill();
+	demoKeyframes.Kill();
+
 	KillLua(true);
 	KillMisc();
 	KillRendering();
@@ -1114,6 +1142,9 @@ bool CGame::Update()
 
 	LEAVE_SYNCED_CODE();
 
+	if (playing && !benchmark.Update(gs->frameNum))
+		gu->globalQuit = true;
+
 	{
 		SLuaAllocError error = {};
 
@@ -1522,6 +1553,8 @@ void CGame::SimFrame() {
 	gs->frameNum += 1;
 	lastFrameTime = spring_gettime();
 
+	profiler.SetTraceFrame(gs->frameNum);
+
 #if 0
 	if (globalRendering->timeOffset > 1.0)
 		lastFrameTime += spring_time::fromNanoSecs(static_cast<int64_t>((globalRendering->timeOffset - 1.0f) / globalRendering->weightedSpeedFactor * std::int64_t(1e6)));
@@ -1596,9 +1629,10 @@ void CGame::SimFrame() {
 	gu->avgSimFrameTime = std::max(gu->avgSimFrameTime, 0.01f);
 
 	eventHandler.DbgTimingInfo(TIMING_SIM, lastFrameTime, lastSimFrameTime);
+	benchmark.AddSimFrame(gs->frameNum, lastSimFrameTime - lastFrameTime);
 
 	#ifdef HEADLESS
-	{
+	if (!benchmark.IsEnabled()) {
 		const float msecMaxSimFrameTime = 1000.0f / (GAME_SPEED * gs->wantedSpeedFactor);
 		const float msecDifSimFrameTime = (lastSimFrameTime - lastFrameTime).toMilliSecsf();
 		// multiply by 0.5 to give unsynced code some execution time (50% of our sleep-budget)
@@ -1613,6 +1647,8 @@ void CGame::SimFrame() {
 	// useful for desync-debugging (enter instead of -1 start & end frame of the range you want to debug)
 	DumpState(-1, -1, 1);
 
+	demoKeyframes.Update(gs->frameNum);
+
 	ASSERT_SYNCED(gsRNG.GetGenState());
 	LEAVE_SYNCED_CODE();
 }
@@ -206,6 +206,9 @@ public:
 	 */
 	int speedControl = -1;
 
+	/// frames between two NETMSG_SYNCCHECKSUMS, 0 if not sent
+	int syncChecksumInterval = 0;
+
 	// 0 := 1/f rate, 1 := 30/s rate
 	int luaGCControl = 0;
 
@@ -37,7 +37,10 @@
 #include "Sim/Weapons/Weapon.h"
 #include "System/EventHandler.h"
 #include "System/SpringMath.h"
+#include "System/StringHash.h"
+#include "System/TimeProfiler.h"
 #include "System/Sound/ISoundChannels.h"
+#include "System/Threading/ThreadPool.h"
 
 
 static CGameHelper gGameHelper;
@@ -632,6 +635,137 @@ namespace {
 
 
 
+static float GetWeaponTargetScanRadius(const CWeapon* weapon)
+{
+	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
+
+	// find theoretical maximum range based on height above lowest point on map
+	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
+	return (weapon->range + weapon->autoTargetRangeBoost + (weapon->aimFromPos.y - minMapHeight) * weapon->weaponDef->heightmod);
+}
+
+// cheap guess whether CWeapon::AutoTarget will run in the weapon's next
+// SlowUpdate (the real test calls Lua); a wrong guess only means a list
+// is gathered needlessly or on demand
+static bool PredictWeaponAutoTarget(const CWeapon* weapon)
+{
+	if (weapon->weaponDef->noAutoTarget || weapon->noAutoTarget)
+		return false;
+	if (weapon->slavedTo != nullptr || weapon->weaponDef->interceptor)
+		return false;
+	if (weapon->owner->fireState < FIRESTATE_FIREATWILL)
+		return false;
+
+	return (!weapon->HaveTarget() || weapon->avoidTarget || gs->frameNum > (weapon->lastTargetRetry + 65));
+}
+
+
+void CGameHelper::GatherTargetCandidates(TargetCandidates& tc)
+{
+	// quad indices are visited row by row, so these are sorted
+	assert(std::is_sorted(tc.quads.begin(), tc.quads.end()));
+
+	tc.units.clear();
+	tc.offsets.clear();
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		tc.offsets.push_back(tc.units.size());
+
+		for (const int qi: tc.quads) {
+			for (CUnit* unit: quadField.GetQuad(qi).teamUnits[t]) {
+				// units overlapping several quads are listed in each of them; keep
+				// the first occurrence like a tempNum-check would (without writing
+				// to the unit so this can run concurrently)
+				const auto seenPred = [&](int uqi) { return (uqi < qi && std::binary_search(tc.quads.begin(), tc.quads.end(), uqi)); };
+
+				if (unit->quads.size() > 1 && std::find_if(unit->quads.begin(), unit->quads.end(), seenPred) != unit->quads.end())
+					continue;
+
+				tc.units.push_back(unit);
+			}
+		}
+	}
+
+	tc.offsets.push_back(tc.units.size());
+}
+
+void CGameHelper::ResetTargetCandidates()
+{
+	if (targetCandidatesFrame == gs->frameNum && targetCandidatesGen == quadField.GetUnitsGeneration())
+		return;
+
+	targetCandidatesMap.clear();
+
+	numTargetCandidates = 0;
+	targetCandidatesGen = quadField.GetUnitsGeneration();
+	targetCandidatesFrame = gs->frameNum;
+}
+
+std::pair<unsigned int, bool> CGameHelper::AddTargetCandidates(const std::vector<int>& quads)
+{
+	const uint32_t hash = HashString(reinterpret_cast<const char*>(quads.data()), quads.size() * sizeof(int));
+	const auto iter = targetCandidatesMap.find(hash);
+
+	if (iter != targetCandidatesMap.end() && targetCandidates[iter->second].quads == quads)
+		return {iter->second, false};
+
+	if (numTargetCandidates == targetCandidates.size())
+		targetCandidates.emplace_back();
+
+	// on a hash collision the new entry is simply not shared
+	if (iter == targetCandidatesMap.end())
+		targetCandidatesMap.emplace(hash, numTargetCandidates);
+
+	targetCandidates[numTargetCandidates].quads = quads;
+	return {numTargetCandidates++, true};
+}
+
+const CGameHelper::TargetCandidates& CGameHelper::GetTargetCandidates(const float3& pos, float radius)
+{
+	ResetTargetCandidates();
+
+	targetCandidateQuads.clear();
+	quadField.VisitQuads(pos, radius, [&](int qi) { targetCandidateQuads.push_back(qi); });
+
+	const auto entry = AddTargetCandidates(targetCandidateQuads);
+
+	if (entry.second)
+		GatherTargetCandidates(targetCandidates[entry.first]);
+
+	return targetCandidates[entry.first];
+}
+
+
+void CGameHelper::PrepareWeaponTargets(const std::vector<CUnit*>& units, size_t idxBeg, size_t idxEnd)
+{
+	SCOPED_TIMER("Sim::Unit::Weapon::PrepareTargets");
+	ResetTargetCandidates();
+
+	const unsigned int numGathered = numTargetCandidates;
+
+	// group weapons by the quads they will scan; positions can still change
+	// during SlowUpdate, in which case the prepared list is simply not used
+	for (size_t i = idxBeg; i < idxEnd; ++i) {
+		for (const CWeapon* weapon: units[i]->weapons) {
+			if (!PredictWeaponAutoTarget(weapon))
+				continue;
+
+			targetCandidateQuads.clear();
+			quadField.VisitQuads(weapon->owner->pos, GetWeaponTargetScanRadius(weapon), [&](int qi) { targetCandidateQuads.push_back(qi); });
+
+			AddTargetCandidates(targetCandidateQuads);
+		}
+	}
+
+	if (numGathered == numTargetCandidates)
+		return;
+
+	for_mt(numGathered, numTargetCandidates, [&](const int i) {
+		GatherTargetCandidates(targetCandidates[i]);
+	});
+}
+
+
 size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
 {
 	const CUnit*  weaponOwner = weapon->owner;
@@ -644,7 +778,6 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 	const float3 testPos;
 
 	const float aimPosHeight = weapon->aimFromPos.y;
-	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
 
 	// how much damage the weapon deals over 1 second
 	const float secDamage = weaponDmg->GetDefault() * weapon->salvoSize / weapon->reloadTime * GAME_SPEED;
@@ -652,97 +785,81 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 	const float  baseRange = weapon->range;
 	const float rangeBoost = weapon->autoTargetRangeBoost;
-	// find theoretical maximum range based on height above lowest point on map
-	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
-	const float scanRadius = baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod;
+	const float scanRadius = GetWeaponTargetScanRadius(weapon);
 
 	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
 	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
 
 	const bool paralyzer = (weaponDmg->paralyzeDamageTime != 0);
 
-	// copy on purpose since the below calls lua
-	QuadFieldQuery qfQuery;
-	quadField.GetQuads(qfQuery, ownerPos, scanRadius);
+	// shared with other weapons scanning the same quads; this is a snapshot
+	// which is not changed by the below Lua calls (and not re-entered)
+	const TargetCandidates& candidates = helper->GetTargetCandidates(ownerPos, scanRadius);
 
 	targets.clear();
 	targets.reserve(32);
 
-	const int tempNum = gs->GetTempNum();
-
 	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
 		if (teamHandler.Ally(weaponOwner->allyteam, t))
 			continue;
 
-		for (const int qi: *qfQuery.quads) {
-			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
-
-			for (CUnit* targetUnit: allyTeamUnits) {
-				if (targetUnit->tempNum == tempNum)
-					continue;
-
-				targetUnit->tempNum = tempNum;
-
-				if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
-					continue;
-
-				const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
+		for (unsigned int i = candidates.offsets[t], n = candidates.offsets[t + 1]; i < n; i++) {
+			CUnit* targetUnit = candidates.units[i];
 
-				float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
-				float3 targetPos;
+			if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
+				continue;
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPos = targetUnit->aimPos;
-				} else if (targetLOSState & LOS_INRADAR) {
-					targetPos = weapon->GetUnitPositionWithError(targetUnit);
-					targetPriority *= tgtPriorityMults[1];
-				} else {
-					continue;
-				}
+			const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
 
-				const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
-				const float sqDist2D = ownerPos.SqDistance2D(targetPos);
+			float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
+			float3 targetPos;
 
-				if (sqDist2D > Square(modRange))
-					continue;
+			if (targetLOSState & LOS_INLOS) {
+				targetPos = targetUnit->aimPos;
+			} else if (targetLOSState & LOS_INRADAR) {
+				targetPos = weapon->GetUnitPositionWithError(targetUnit);
+				targetPriority *= tgtPriorityMults[1];
+			} else {
+				continue;
+			}
 
-				const float dist2D = math::sqrt(sqDist2D);
-				const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
-				const float damageMul = weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple;
+			const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
+			const float sqDist2D = ownerPos.SqDistance2D(targetPos);
 
-				targetPriority *= rangeMul;
-				targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
+			if (sqDist2D > Square(modRange))
+				continue;
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPriority *= (secDamage + targetUnit->health);
+			const float dist2D = math::sqrt(sqDist2D);
+			const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
+			const float damageMul = weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple;
 
-					if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
-						targetPriority *= tgtPriorityMults[5];
+			targetPriority *= rangeMul;
+			targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
 
-					if (weapon->hasTargetWeight)
-						targetPriority *= weapon->TargetWeight(targetUnit);
+			if (targetLOSState & LOS_INLOS) {
+				targetPriority *= (secDamage + targetUnit->health);
 
-				} else {
-					targetPriority *= (secDamage + 10000.0f);
-				}
+				if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
+					targetPriority *= tgtPriorityMults[5];
 
-				if (targetLOSState & LOS_PREVLOS) {
-					targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
-					targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
-					targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
-					targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
-				}
+				if (weapon->hasTargetWeight)
+					targetPriority *= weapon->TargetWeight(targetUnit);
 
-				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
+			} else {
+				targetPriority *= (secDamage + 10000.0f);
+			}
 
-				// Lua call may have changed tempNum, so needs to be set again
-				targetUnit->tempNum = tempNum;
+			if (targetLOSState & LOS_PREVLOS) {
+				targetPriority /= (damageMul * targetUnit->power * (0.7f + gsRNG.NextFloat() * 0.6f));
+				targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
+				targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
+				targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
+			}
 
-				if (!allowTarget)
-					continue;
+			if (!eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority))
+				continue;
 
-				targets.emplace_back(targetPriority, targetUnit);
-			}
+			targets.emplace_back(targetPriority, targetUnit);
 		}
 	}
 
@@ -8,6 +8,7 @@
 #include "Sim/Units/CommandAI/Command.h"
 #include "System/float3.h"
 #include "System/type2.h"
+#include "System/UnorderedMap.hpp"
 
 #include <array>
 #include <vector>
@@ -133,6 +134,13 @@ public:
 	);
 
 	static size_t GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
+	/**
+	 * Gathers (in parallel) the candidate enemy units for each weapon of
+	 * units[idxBeg, idxEnd) that will likely AutoTarget in this SlowUpdate.
+	 * Weapons whose scan areas cover the same quads share one list, which
+	 * GenerateWeaponTargets reuses until a unit changes quads.
+	 */
+	void PrepareWeaponTargets(const std::vector<CUnit*>& units, size_t idxBeg, size_t idxEnd);
 
 	void Init();
 	void Update();
@@ -185,9 +193,35 @@ private:
 		float3 impulse;
 	};
 
+	// enemy units in range of a set of quads, for GenerateWeaponTargets
+	struct TargetCandidates {
+		std::vector<int> quads;
+		// units of allyteam t are [offsets[t], offsets[t + 1]), in the
+		// order a scan over <quads> visits them
+		std::vector<CUnit*> units;
+		std::vector<unsigned int> offsets;
+	};
+
+	void ResetTargetCandidates();
+	std::pair<unsigned int, bool> AddTargetCandidates(const std::vector<int>& quads);
+	const TargetCandidates& GetTargetCandidates(const float3& pos, float radius);
+
+	static void GatherTargetCandidates(TargetCandidates& tc);
+
+private:
 	// note: size must be a power of two
 	std::array<std::vector<WaitingDamage>, 128> waitingDamages;
 
+	// entries [0, numTargetCandidates) are valid while the frame and the
+	// QuadField unit-generation they were gathered in are current
+	std::vector<TargetCandidates> targetCandidates;
+	spring::unordered_map<uint32_t, unsigned int> targetCandidatesMap;
+	std::vector<int> targetCandidateQuads;
+
+	unsigned int numTargetCandidates = 0;
+	unsigned int targetCandidatesGen = 0;
+	int targetCandidatesFrame = -1;
+
 public:
 	std::vector<int> targetUnitIDs; // GetEnemyUnits{NoLosTest}
 	std::vector<std::pair<float, CUnit*>> targetPairs; // GenerateWeaponTargets
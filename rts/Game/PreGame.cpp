@@ -223,6 +223,8 @@ void CPreGame::AddModArchivesToVFS(const CGameSetup* setup)
 
 	// load game archive
 	vfsHandler->AddArchiveWithDeps(setup->modName, false);
+	// the Lua handlers and def-parsers read nearly all of these while loading
+	vfsHandler->PrefetchFiles("*.lua", CVFSHandler::Section::Mod);
 
 	modFileName = archiveScanner->ArchiveFromName(setup->modName);
 }
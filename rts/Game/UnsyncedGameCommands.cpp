@@ -9,6 +9,7 @@
 #include "Action.h"
 #include "CameraHandler.h"
 #include "ConsoleHistory.h"
+#include "DemoKeyframes.h"
 #include "CommandMessage.h"
 #include "Game.h"
 #include "GameSetup.h"
@@ -99,6 +100,8 @@
 #include "System/TimeProfiler.h"
 #include "System/Log/ILog.h"
 #include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
@@ -3353,6 +3356,51 @@ public:
 };
 
 
+class ProfilerTraceActionExecutor : public IUnsyncedActionExecutor {
+public:
+	ProfilerTraceActionExecutor() : IUnsyncedActionExecutor(
+		"ProfilerTrace",
+		"Start streaming all profiler timers to the given file (Chrome trace-event JSON), or stop if no file is given"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		const std::string& args = action.GetArgs();
+
+		if (args.empty()) {
+			profiler.StopTrace();
+			return true;
+		}
+
+		profiler.StartTrace(dataDirsAccess.LocateFile(args, FileQueryFlags::WRITE));
+		return true;
+	}
+};
+
+class DemoSeekActionExecutor : public IUnsyncedActionExecutor {
+public:
+	DemoSeekActionExecutor() : IUnsyncedActionExecutor(
+		"DemoSeek",
+		"Jump to the given frame of the replayed demo, reloading from the nearest keyframe if there is one"
+	) {
+	}
+
+	bool Execute(const UnsyncedAction& action) const final {
+		if (!gameSetup->hostDemo || action.GetArgs().empty())
+			return false;
+
+		const int frameNum = StringToInt(action.GetArgs());
+
+		if (demoKeyframes.Seek(gs->frameNum, frameNum))
+			return true;
+
+		// no useful keyframe, simulate up to <frameNum> instead
+		CommandMessage pckt("skip f" + IntToString(frameNum), gu->myPlayerNum);
+		clientNet->Send(pckt.Pack());
+		return true;
+	}
+};
+
 class DebugInfoActionExecutor : public IUnsyncedActionExecutor {
 public:
 	DebugInfoActionExecutor() : IUnsyncedActionExecutor(
@@ -3751,6 +3799,8 @@ void UnsyncedGameCommands::AddDefaultActionExecutors()
 	AddActionExecutor(AllocActionExecutor<ReloadShadersActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<ReloadTexturesActionExecutor>());
 	AddActionExecutor(AllocActionExecutor<DebugInfoActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<ProfilerTraceActionExecutor>());
+	AddActionExecutor(AllocActionExecutor<DemoSeekActionExecutor>());
 
 	// XXX are these redirects really required?
 	AddActionExecutor(AllocActionExecutor<RedirectToSyncedActionExecutor>("ATM"));
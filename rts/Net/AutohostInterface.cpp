@@ -3,14 +3,23 @@
 #include "AutohostInterface.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Net/Socket.h"
+#include "System/Platform/Threading.h"
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
 #include <vector>
 #include <cinttypes>
 
 
+CONFIG(int, AutohostMaxQueuedEvents).defaultValue(1024).minimumValue(16).description("Number of events that may wait to be sent to the autohost before informational ones (chat, messages, Lua messages, telemetry) are dropped.");
+CONFIG(bool, AutohostBatchEvents).defaultValue(false).description("Send events queued for the autohost together in SERVER_EVENTS datagrams rather than one datagram each; the autohost has to understand SERVER_EVENTS.");
+CONFIG(bool, AutohostTelemetry).defaultValue(false).description("Send PLAYER_INFO (cpu-usage and ping of each player) and SERVER_FRAMETIMING (server update times) events to the autohost every 2 seconds.");
+
+
 #define LOG_SECTION_AUTOHOST_INTERFACE "AutohostInterface"
 LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_AUTOHOST_INTERFACE)
 
@@ -48,6 +57,24 @@ enum EVENT
 	/// Server gave out a warning (string warningmessage)
 	SERVER_WARNING = 5,
 
+	/**
+	 * @brief Server load since the last one of these (every 2 seconds)
+	 *
+	 * (int32 frameNum, float speedFactor, float avgUpdateTime,
+	 * float maxUpdateTime), times in milliseconds
+	 * Only sent if AutohostTelemetry is enabled.
+	 */
+	SERVER_FRAMETIMING = 6,
+
+	/**
+	 * @brief Several events in one datagram
+	 *
+	 * (uint16 size, uchar[size] event)* repeated up to the end of the
+	 * datagram, where each event is laid out as if sent on its own.
+	 * Only sent if AutohostBatchEvents is enabled.
+	 */
+	SERVER_EVENTS = 7,
+
 	/// Player has joined the game (uchar playernumber, string name)
 	PLAYER_JOINED = 10,
 
@@ -79,6 +106,14 @@ enum EVENT
 	/// Player has been defeated (uchar playernumber)
 	PLAYER_DEFEATED = 14,
 
+	/**
+	 * @brief Load of a player that is ingame (every 2 seconds)
+	 *
+	 * (uchar playernumber, float cpuUsage, int32 ping), ping in milliseconds
+	 * Only sent if AutohostTelemetry is enabled.
+	 */
+	PLAYER_INFO = 15,
+
 	/**
 	 * @brief Message sent by lua script
 	 *
@@ -94,6 +129,30 @@ enum EVENT
 	 */
 	GAME_TEAMSTAT = NETMSG_TEAMSTAT, // should be 60
 };
+
+
+/// milliseconds between two runs of the worker thread
+static constexpr int EVENT_INTERVAL = 10;
+/// largest SERVER_EVENTS datagram, single events above this go out on their own
+static constexpr size_t MAX_BATCH_SIZE = 8192;
+
+static bool IsDroppableEvent(std::uint8_t event)
+{
+	switch (event) {
+		case SERVER_MESSAGE:
+		case SERVER_WARNING:
+		case SERVER_FRAMETIMING:
+		case PLAYER_CHAT:
+		case PLAYER_INFO:
+		case GAME_LUAMSG: {
+			return true;
+		} break;
+		default: {
+		} break;
+	}
+
+	return false;
+}
 }
 
 using namespace asio;
@@ -108,7 +167,29 @@ AutohostInterface::AutohostInterface(const std::string& remoteIP, int remotePort
 		initialized = true;
 	} else {
 		LOG_L(L_ERROR, "Failed to open socket: %s", errorMsg.c_str());
+		return;
+	}
+
+	maxQueuedEvents = configHandler->GetInt("AutohostMaxQueuedEvents");
+	batchEvents = configHandler->GetBool("AutohostBatchEvents");
+	sendTelemetry = configHandler->GetBool("AutohostTelemetry");
+
+	eventThread = std::move(spring::thread(std::bind(&AutohostInterface::UpdateLoop, this)));
+}
+
+AutohostInterface::~AutohostInterface()
+{
+	if (!eventThread.joinable())
+		return;
+
+	{
+		std::lock_guard<spring::mutex> lock(eventMutex);
+		quitThread = true;
 	}
+
+	// the worker sends whatever is still queued (e.g. SERVER_QUIT) before it exits
+	eventCond.notify_all();
+	eventThread.join();
 }
 
 std::string AutohostInterface::TryBindSocket(
@@ -175,14 +256,14 @@ void AutohostInterface::SendStart()
 {
 	uchar msg = SERVER_STARTED;
 
-	Send(asio::buffer(&msg, sizeof(uchar)));
+	PushEvent(&msg, sizeof(uchar));
 }
 
 void AutohostInterface::SendQuit()
 {
 	uchar msg = SERVER_QUIT;
 
-	Send(asio::buffer(&msg, sizeof(uchar)));
+	PushEvent(&msg, sizeof(uchar));
 }
 
 void AutohostInterface::SendStartPlaying(const unsigned char* gameID, const std::string& demoName)
@@ -211,7 +292,7 @@ void AutohostInterface::SendStartPlaying(const unsigned char* gameID, const std:
 	strncpy((char*)(&buffer[pos]), demoName.c_str(), demoName.size());
 	assert(int(pos + demoName.size()) == int(msgsize));
 
-	Send(asio::buffer(buffer));
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::SendGameOver(uchar playerNum, const std::vector<uchar>& winningAllyTeams)
@@ -225,115 +306,241 @@ void AutohostInterface::SendGameOver(uchar playerNum, const std::vector<uchar>&
 	for (unsigned int i = 0; i < winningAllyTeams.size(); i++) {
 		buffer[3 + i] = winningAllyTeams[i];
 	}
-	Send(asio::buffer(buffer));
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::SendPlayerJoined(uchar playerNum, const std::string& name)
 {
-	if (autohost.is_open()) {
-		unsigned msgsize = 2 * sizeof(uchar) + name.size();
-		std::vector<std::uint8_t> buffer(msgsize);
-		buffer[0] = PLAYER_JOINED;
-		buffer[1] = playerNum;
-		strncpy((char*)(&buffer[2]), name.c_str(), name.size());
+	const unsigned msgsize = 2 * sizeof(uchar) + name.size();
+	std::vector<std::uint8_t> buffer(msgsize);
+	buffer[0] = PLAYER_JOINED;
+	buffer[1] = playerNum;
+	strncpy((char*)(&buffer[2]), name.c_str(), name.size());
 
-		Send(asio::buffer(buffer));
-	}
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::SendPlayerLeft(uchar playerNum, uchar reason)
 {
 	uchar msg[3] = {PLAYER_LEFT, playerNum, reason};
 
-	Send(asio::buffer(&msg, 3 * sizeof(uchar)));
+	PushEvent(&msg, 3 * sizeof(uchar));
 }
 
 void AutohostInterface::SendPlayerReady(uchar playerNum, uchar readyState)
 {
 	uchar msg[3] = {PLAYER_READY, playerNum, readyState};
 
-	Send(asio::buffer(&msg, 3 * sizeof(uchar)));
+	PushEvent(&msg, 3 * sizeof(uchar));
 }
 
 void AutohostInterface::SendPlayerChat(uchar playerNum, uchar destination, const std::string& chatmsg)
 {
-	if (autohost.is_open()) {
-		const unsigned msgsize = 3 * sizeof(uchar) + chatmsg.size();
-		std::vector<std::uint8_t> buffer(msgsize);
-		buffer[0] = PLAYER_CHAT;
-		buffer[1] = playerNum;
-		buffer[2] = destination;
-		strncpy((char*)(&buffer[3]), chatmsg.c_str(), chatmsg.size());
-
-		Send(asio::buffer(buffer));
-	}
+	const unsigned msgsize = 3 * sizeof(uchar) + chatmsg.size();
+	std::vector<std::uint8_t> buffer(msgsize);
+	buffer[0] = PLAYER_CHAT;
+	buffer[1] = playerNum;
+	buffer[2] = destination;
+	strncpy((char*)(&buffer[3]), chatmsg.c_str(), chatmsg.size());
+
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::SendPlayerDefeated(uchar playerNum)
 {
 	uchar msg[2] = {PLAYER_DEFEATED, playerNum};
 
-	Send(asio::buffer(&msg, 2 * sizeof(uchar)));
+	PushEvent(&msg, 2 * sizeof(uchar));
+}
+
+void AutohostInterface::SendPlayerInfo(uchar playerNum, float cpuUsage, std::int32_t ping)
+{
+	std::uint8_t msg[2 * sizeof(uchar) + sizeof(cpuUsage) + sizeof(ping)];
+	msg[0] = PLAYER_INFO;
+	msg[1] = playerNum;
+	memcpy(&msg[2], &cpuUsage, sizeof(cpuUsage));
+	memcpy(&msg[2 + sizeof(cpuUsage)], &ping, sizeof(ping));
+
+	PushEvent(&msg, sizeof(msg));
+}
+
+void AutohostInterface::SendFrameTiming(std::int32_t frameNum, float speedFactor, float avgUpdateTime, float maxUpdateTime)
+{
+	const float times[] = {speedFactor, avgUpdateTime, maxUpdateTime};
+
+	std::uint8_t msg[sizeof(uchar) + sizeof(frameNum) + sizeof(times)];
+	msg[0] = SERVER_FRAMETIMING;
+	memcpy(&msg[1], &frameNum, sizeof(frameNum));
+	memcpy(&msg[1 + sizeof(frameNum)], &times[0], sizeof(times));
+
+	PushEvent(&msg, sizeof(msg));
 }
 
 void AutohostInterface::Message(const std::string& message)
 {
-	if (autohost.is_open()) {
-		const unsigned msgsize = sizeof(uchar) + message.size();
-		std::vector<std::uint8_t> buffer(msgsize);
-		buffer[0] = SERVER_MESSAGE;
-		strncpy((char*)(&buffer[1]), message.c_str(), message.size());
+	const unsigned msgsize = sizeof(uchar) + message.size();
+	std::vector<std::uint8_t> buffer(msgsize);
+	buffer[0] = SERVER_MESSAGE;
+	strncpy((char*)(&buffer[1]), message.c_str(), message.size());
 
-		Send(asio::buffer(buffer));
-	}
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::Warning(const std::string& message)
 {
-	if (autohost.is_open()) {
-		const unsigned msgsize = sizeof(uchar) + message.size();
-		std::vector<std::uint8_t> buffer(msgsize);
-		buffer[0] = SERVER_WARNING;
-		strncpy((char*)(&buffer[1]), message.c_str(), message.size());
+	const unsigned msgsize = sizeof(uchar) + message.size();
+	std::vector<std::uint8_t> buffer(msgsize);
+	buffer[0] = SERVER_WARNING;
+	strncpy((char*)(&buffer[1]), message.c_str(), message.size());
 
-		Send(asio::buffer(buffer));
-	}
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::SendLuaMsg(const std::uint8_t* msg, size_t msgSize)
 {
-	if (autohost.is_open()) {
-		std::vector<std::uint8_t> buffer(msgSize+1);
-		buffer[0] = GAME_LUAMSG;
-		std::copy(msg, msg + msgSize, buffer.begin() + 1);
+	std::vector<std::uint8_t> buffer(msgSize+1);
+	buffer[0] = GAME_LUAMSG;
+	std::copy(msg, msg + msgSize, buffer.begin() + 1);
 
-		Send(asio::buffer(buffer));
-	}
+	PushEvent(buffer.data(), buffer.size());
 }
 
 void AutohostInterface::Send(const std::uint8_t* msg, size_t msgSize)
 {
-	if (autohost.is_open()) {
-		std::vector<std::uint8_t> buffer(msgSize);
-		std::copy(msg, msg + msgSize, buffer.begin());
+	PushEvent(msg, msgSize);
+}
+
+std::string AutohostInterface::GetChatMessage()
+{
+	std::lock_guard<spring::mutex> lock(eventMutex);
+
+	if (chatMessages.empty())
+		return "";
+
+	const std::string message = std::move(chatMessages.front());
+	chatMessages.pop_front();
+	return message;
+}
+
+
+void AutohostInterface::PushEvent(const void* event, size_t size)
+{
+	if (!eventThread.joinable() || size == 0)
+		return;
+
+	const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(event);
 
-		Send(asio::buffer(buffer));
+	std::lock_guard<spring::mutex> lock(eventMutex);
+
+	if (queuedEvents.sizes.size() >= maxQueuedEvents && IsDroppableEvent(bytes[0])) {
+		numDroppedEvents += 1;
+		return;
 	}
+
+	queuedEvents.data.insert(queuedEvents.data.end(), bytes, bytes + size);
+	queuedEvents.sizes.push_back(size);
 }
 
-std::string AutohostInterface::GetChatMessage()
+void AutohostInterface::SendEvents(EventQueue& events)
 {
-	if (autohost.is_open()) {
+	const auto SendBatch = [&]() {
+		if (batchBuffer.size() > 1)
+			Send(asio::buffer(batchBuffer));
+
+		batchBuffer.clear();
+		batchBuffer.push_back(SERVER_EVENTS);
+	};
+
+	size_t pos = 0;
+
+	batchBuffer.clear();
+	batchBuffer.push_back(SERVER_EVENTS);
+
+	for (const std::uint32_t size: events.sizes) {
+		std::uint8_t* event = &events.data[pos];
+		pos += size;
+
+		// too large to batch (or batching is off), keep the order and send it alone
+		if (!batchEvents || (sizeof(std::uint16_t) + size + 1) > MAX_BATCH_SIZE) {
+			SendBatch();
+			Send(asio::buffer(event, size));
+			continue;
+		}
+
+		if ((batchBuffer.size() + sizeof(std::uint16_t) + size) > MAX_BATCH_SIZE)
+			SendBatch();
+
+		const std::uint16_t eventSize = size;
+		const std::uint8_t* eventSizeBytes = reinterpret_cast<const std::uint8_t*>(&eventSize);
+
+		batchBuffer.insert(batchBuffer.end(), eventSizeBytes, eventSizeBytes + sizeof(eventSize));
+		batchBuffer.insert(batchBuffer.end(), event, event + size);
+	}
+
+	SendBatch();
+	events.Clear();
+}
+
+void AutohostInterface::ReceiveMessages()
+{
+	std::vector<std::uint8_t> buffer;
+
+	try {
 		size_t bytes_avail = 0;
 
-		if ((bytes_avail = autohost.available()) > 0) {
-			std::vector<std::uint8_t> buffer(bytes_avail+1, 0);
-			/*const size_t bytesReceived = */autohost.receive(asio::buffer(buffer));
-			return std::string((char*)(&buffer[0]));
+		while (autohost.is_open() && (bytes_avail = autohost.available()) > 0) {
+			buffer.clear();
+			buffer.resize(bytes_avail + 1, 0);
+
+			autohost.receive(asio::buffer(buffer));
+
+			std::lock_guard<spring::mutex> lock(eventMutex);
+
+			if (chatMessages.size() < maxQueuedEvents)
+				chatMessages.emplace_back((char*)(&buffer[0]));
 		}
+	} catch (const asio::system_error& e) {
+		autohost.close();
+		LOG_L(L_ERROR, "Failed to receive; the autohost may not be reachable: %s", e.what());
 	}
+}
+
+void AutohostInterface::UpdateLoop()
+{
+	Threading::SetThreadName("autohost");
 
-	return "";
+	while (true) {
+		unsigned int numDropped = 0;
+		bool quit = false;
+
+		{
+			std::unique_lock<spring::mutex> lock(eventMutex);
+
+			eventCond.wait_for(lock, std::chrono::milliseconds(EVENT_INTERVAL), [&]() { return quitThread; });
+			std::swap(queuedEvents, sentEvents);
+
+			numDropped = numDroppedEvents;
+			numDroppedEvents = 0;
+			quit = quitThread;
+		}
+
+		SendEvents(sentEvents);
+
+		if (numDropped > 0) {
+			const std::string warning = "[AutohostInterface] event-queue full, dropped " + std::to_string(numDropped) + " events";
+
+			std::vector<std::uint8_t> buffer(1 + warning.size());
+			buffer[0] = SERVER_WARNING;
+			memcpy(&buffer[1], warning.data(), warning.size());
+
+			Send(asio::buffer(buffer));
+		}
+
+		ReceiveMessages();
+
+		if (quit)
+			break;
+	}
 }
 
 void AutohostInterface::Send(asio::mutable_buffers_1 buffer)
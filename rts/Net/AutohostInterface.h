@@ -5,11 +5,22 @@
 
 #include <string>
 #include <cinttypes>
+#include <deque>
+#include <vector>
 #include <asio/ip/udp.hpp>
 
+#include "System/Threading/SpringThreading.h"
+
 /**
  * API for engine <-> autohost (or similar) communication, using UDP over
  * loopback.
+ *
+ * Events are only queued by the server thread; a worker thread sends them
+ * (optionally several per datagram, see AutohostBatchEvents) and receives
+ * the autohost's messages, so a slow or flooded autohost socket can not
+ * stall the server. The queue is bounded: when it is full, chat, messages
+ * and other informational events are dropped (and counted in a warning),
+ * events that change the game's state never are.
  */
 class AutohostInterface
 {
@@ -28,9 +39,11 @@ public:
 	 */
 	AutohostInterface(const std::string& remoteIP, int remotePort,
 			const std::string& localIP = "", int localPort = 0);
-	virtual ~AutohostInterface() {}
+	virtual ~AutohostInterface();
 
 	bool IsInitialized() const { return initialized; }
+	/// whether SendPlayerInfo and SendFrameTiming should be called
+	bool WantsTelemetry() const { return sendTelemetry; }
 
 	void SendStart();
 	void SendQuit();
@@ -42,6 +55,9 @@ public:
 	void SendPlayerReady(uchar playerNum, uchar readyState);
 	void SendPlayerChat(uchar playerNum, uchar destination, const std::string& msg);
 	void SendPlayerDefeated(uchar playerNum);
+	void SendPlayerInfo(uchar playerNum, float cpuUsage, std::int32_t ping);
+
+	void SendFrameTiming(std::int32_t frameNum, float speedFactor, float avgUpdateTime, float maxUpdateTime);
 
 	void Message(const std::string& message);
 	void Warning(const std::string& message);
@@ -52,11 +68,26 @@ public:
 	/**
 	 * @brief Receive a chat message from the autohost
 	 * There should be only 1 message per UDP-Packet, and it will use the hosts
-	 * playernumber to inject this message
+	 * playernumber to inject this message. Returns the oldest message the
+	 * worker thread has received, or "" if there is none.
 	 */
 	std::string GetChatMessage();
 
 private:
+	struct EventQueue {
+		void Clear() { data.clear(); sizes.clear(); }
+
+		/// all events back to back
+		std::vector<std::uint8_t> data;
+		std::vector<std::uint32_t> sizes;
+	};
+
+	void PushEvent(const void* event, size_t size);
+	void SendEvents(EventQueue& events);
+	void ReceiveMessages();
+
+	void UpdateLoop();
+
 	void Send(asio::mutable_buffers_1 sendBuffer);
 
 	/**
@@ -75,8 +106,28 @@ private:
 			const std::string& remoteIP, int remotePort,
 			const std::string& localIP = "", int localPort = 0);
 
+	/// only touched by the worker thread once that runs
 	asio::ip::udp::socket autohost;
+
+	spring::thread eventThread;
+	spring::mutex eventMutex;
+	spring::condition_variable eventCond;
+
+	/// written by the server thread
+	EventQueue queuedEvents;
+	/// owned by the worker thread
+	EventQueue sentEvents;
+	std::vector<std::uint8_t> batchBuffer;
+
+	std::deque<std::string> chatMessages;
+
+	unsigned int maxQueuedEvents = 0;
+	unsigned int numDroppedEvents = 0;
+
 	bool initialized;
+	bool batchEvents = false;
+	bool sendTelemetry = false;
+	bool quitThread = false;
 };
 
 #endif // AUTOHOST_INTERFACE_H
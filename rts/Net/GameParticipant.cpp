@@ -1,5 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <cassert>
+
 #include "GameParticipant.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
@@ -14,10 +16,55 @@ GameParticipant::GameParticipant()
 
 void GameParticipant::SendData(std::shared_ptr<const netcode::RawPacket> packet)
 {
+	FlushFrameBatch();
+
 	if (clientLink != nullptr)
 		clientLink->SendData(packet);
 }
 
+void GameParticipant::SendNewFrame(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	if (frameBatchSize <= 1) {
+		SendData(packet);
+		return;
+	}
+
+	// held back until the batch is full or anything else is sent to us
+	if ((numPendingFrames += 1) >= frameBatchSize)
+		FlushFrameBatch();
+}
+
+void GameParticipant::SetFrameBatchSize(unsigned int size)
+{
+	if ((frameBatchSize = size) <= numPendingFrames)
+		FlushFrameBatch();
+}
+
+void GameParticipant::FlushFrameBatch()
+{
+	if (numPendingFrames == 0)
+		return;
+
+	const unsigned int numFrames = numPendingFrames;
+
+	numPendingFrames = 0;
+
+	if (clientLink == nullptr)
+		return;
+
+	if (numFrames == 1) {
+		clientLink->SendData(CBaseNetProtocol::Get().SendNewFrame());
+		return;
+	}
+
+	// only UDPConnection expands batches, so local clients are never batched
+	assert(!isLocal);
+	clientLink->SendData(CBaseNetProtocol::Get().SendNewFrames(numFrames));
+
+	numFrameBatches += 1;
+	numBatchedFrames += numFrames;
+}
+
 void GameParticipant::Connected(std::shared_ptr<netcode::CConnection> _link, bool local)
 {
 	clientLink = _link;
@@ -26,6 +73,9 @@ void GameParticipant::Connected(std::shared_ptr<netcode::CConnection> _link, boo
 	isLocal = local;
 	myState = CONNECTED;
 	lastFrameResponse = 0;
+
+	frameBatchSize = 1;
+	numPendingFrames = 0;
 }
 
 void GameParticipant::Kill(const std::string& reason, const bool flush)
@@ -42,9 +92,13 @@ void GameParticipant::Kill(const std::string& reason, const bool flush)
 		clientLink.reset();
 	}
 
+	frameBatchSize = 1;
+	numPendingFrames = 0;
+
 	aiClientLinks[MAX_AIS].link.reset();
 #ifdef SYNCCHECK
 	syncResponse.clear();
+	syncChecksums.clear();
 #endif
 
 	myState = DISCONNECTED;
@@ -4,6 +4,7 @@
 #define _GAME_PARTICIPANT_H
 
 #include <memory>
+#include <vector>
 
 #include "Game/Players/PlayerBase.h"
 #include "Game/Players/PlayerStatistics.h"
@@ -21,7 +22,12 @@ class GameParticipant : public PlayerBase
 public:
 	GameParticipant();
 
+	/// sends any frames held back for batching first, so the order is kept
 	void SendData(std::shared_ptr<const netcode::RawPacket> packet);
+	/// sends a NETMSG_NEWFRAME, or holds it back while frames are batched
+	void SendNewFrame(std::shared_ptr<const netcode::RawPacket> packet);
+	void SetFrameBatchSize(unsigned int size);
+	void FlushFrameBatch();
 	void Connected(std::shared_ptr<netcode::CConnection> link, bool local);
 	void Kill(const std::string& reason, const bool flush = false);
 
@@ -43,6 +49,14 @@ public:
 	bool isReconn = false;
 	bool isMidgameJoin = false;
 
+	/// frames per NETMSG_NEWFRAMES batch, >1 only while this client lags behind (see CGameServer::LagProtection)
+	unsigned int frameBatchSize = 1;
+	unsigned int numPendingFrames = 0;
+
+	// see "/framebatching"
+	unsigned int numFrameBatches = 0;
+	unsigned int numBatchedFrames = 0;
+
 	PlayerStatistics lastStats;
 
 	struct ClientLinkData {
@@ -62,6 +76,9 @@ public:
 
 	#ifdef SYNCCHECK
 	spring::unordered_map<int, unsigned int> syncResponse; // syncResponse[frameNum] = checksum
+	spring::unordered_map<int, std::vector<uint32_t>> syncChecksums; // syncChecksums[frameNum] = per-subsystem checksums
+
+	uint32_t desyncedSubsystems = 0; // bitmask of subsystems already reported as diverged
 	#endif
 };
 
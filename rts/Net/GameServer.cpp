@@ -4,6 +4,7 @@
 #include "System/Net/UDPConnection.h"
 
 #include <functional>
+#include <limits>
 
 #if defined DEDICATED || defined DEBUG
 	#include <iostream>
@@ -13,6 +14,7 @@
 
 #include "GameParticipant.h"
 #include "GameSkirmishAI.h"
+#include "SpectatorRelay.h"
 #include "AutohostInterface.h"
 
 #include "Game/ClientSetup.h"
@@ -42,6 +44,7 @@
 #include "System/SpringMath.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringFormat.h"
+#include "System/Sync/SubsystemChecksums.h"
 #include "System/TdfParser.h"
 #include "System/StringHash.h"
 #include "System/StringUtil.h"
@@ -75,6 +78,8 @@ CONFIG(bool, WhiteListAdditionalPlayers).defaultValue(true);
 CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
 CONFIG(bool, ServerLogInfoMessages).defaultValue(false);
 CONFIG(bool, ServerLogDebugMessages).defaultValue(false);
+CONFIG(int, SpectatorRelayInterval).defaultValue(0).minimumValue(0).description("Number of milliseconds between sends of the thread that relays game traffic to remote spectators, 0 sends to them from the server thread.");
+CONFIG(int, ServerMaxFrameBatch).defaultValue(1).minimumValue(1).maximumValue(15).description("Maximum number of sim frames the server sends in one message while remote clients lag behind because of high CPU usage, 1 disables batching. Batches never span a keyframe (every 16 frames).");
 CONFIG(std::string, AutohostIP).defaultValue("127.0.0.1");
 
 
@@ -110,6 +115,9 @@ static constexpr unsigned gameProgressFrameInterval = GAME_SPEED * 5;
 
 static constexpr unsigned syncResponseEchoInterval = GAME_SPEED * 2;
 
+/// remote clients above this CPU usage that fall behind get their frames batched
+static constexpr float frameBatchCpuUsage = 0.75f;
+
 
 //FIXME remodularize server commands, so they get registered in word completion etc.
 decltype(CGameServer::commandBlacklist) CGameServer::commandBlacklist{
@@ -170,7 +178,7 @@ void CGameServer::Initialize()
 	if (!myGameSetup->onlyLocal)
 		udpListener.reset(new netcode::UDPListener(myClientSetup->hostPort, myClientSetup->hostIP));
 
-	AddAutohostInterface(StringToLower(configHandler->GetString("AutohostIP")), configHandler->GetInt("AutohostPort"));
+	AddAutohostInterface(StringToLower(myClientSetup->autohostIP), myClientSetup->autohostPort);
 	Message(spring::format(ServerStart, myClientSetup->hostPort), false);
 
 	// start script
@@ -178,6 +186,9 @@ void CGameServer::Initialize()
 	minUserSpeed = myGameSetup->minSpeed;
 	noHelperAIs  = myGameSetup->noHelperAIs;
 
+	spectatorRelay.reset(new CSpectatorRelay());
+	spectatorRelay->Init(configHandler->GetInt("SpectatorRelayInterval"));
+
 	// modify and save GameSetup text (remove passwords)
 	StripGameSetupText(const_cast<GameData*>(myGameData.get()));
 
@@ -243,7 +254,9 @@ void CGameServer::Initialize()
 	}
 
 	{
-		std::sort(commandBlacklist.begin(), commandBlacklist.end());
+		// shared by all servers in the process, sort it only once
+		static const bool sortedBlacklist = (std::sort(commandBlacklist.begin(), commandBlacklist.end()), true);
+		(void) sortedBlacklist;
 	}
 
 	if (configHandler->GetBool("ServerRecordDemos")) {
@@ -255,6 +268,7 @@ void CGameServer::Initialize()
 	}
 
 	loopSleepTime = configHandler->GetInt("ServerSleepTime");
+	maxFrameBatchSize = configHandler->GetInt("ServerMaxFrameBatch");
 	linkMinPacketSize = globalConfig.linkIncomingMaxPacketRate > 0 ? (globalConfig.linkIncomingSustainedBandwidth / globalConfig.linkIncomingMaxPacketRate) : 1;
 
 	lastNewFrameTick = spring_gettime();
@@ -281,6 +295,12 @@ void CGameServer::PostLoad(int newServerFrameNum)
 
 	gameHasStarted = !PreSimFrame();
 
+	// loaded from a demo keyframe (see CDemoKeyframes), skip what it already contains
+	if (demoReader != nullptr) {
+		demoSeekFrame = newServerFrameNum;
+		demoSeekFrameNum = 0;
+	}
+
 	// for all GameParticipant's
 	for (GameParticipant& p: players) {
 		p.lastFrameResponse = newServerFrameNum;
@@ -451,8 +471,9 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 	if (demoReader == nullptr)
 		return ret;
 
-	// get all packets from the stream up to <modGameTime>
-	while ((buf = demoReader->GetData(modGameTime))) {
+	// get all packets from the stream up to <modGameTime>, or all
+	// of those already contained in the keyframe we were loaded from
+	while ((buf = demoReader->GetData((demoSeekFrameNum < demoSeekFrame)? std::numeric_limits<float>::max(): modGameTime))) {
 		std::shared_ptr<const RawPacket> rpkt(buf);
 
 		if (buf->length <= 0) {
@@ -462,6 +483,36 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 
 		const unsigned msgCode = buf->data[0];
 
+		if (demoSeekFrameNum < demoSeekFrame) {
+			switch (msgCode) {
+				case NETMSG_NEWFRAME:
+				case NETMSG_KEYFRAME: {
+					// continue in real-time from the next packet on
+					if ((demoSeekFrameNum += 1) == demoSeekFrame)
+						modGameTime = demoReader->GetNextDemoReadTime();
+
+					continue;
+				} break;
+
+				case NETMSG_RANDSEED: {
+					// the synced RNG state is part of the keyframe
+					continue;
+				} break;
+
+				case NETMSG_PLAYERNAME:
+				case NETMSG_PLAYERLEFT:
+				case NETMSG_CREATE_NEWPLAYER: {
+					// players are not, they are set up by the script
+				} break;
+
+				default: {
+					// setup messages (e.g. start-playing) preceding the first frame are still needed
+					if (demoSeekFrameNum > 0)
+						continue;
+				} break;
+			}
+		}
+
 		switch (msgCode) {
 			case NETMSG_NEWFRAME:
 			case NETMSG_KEYFRAME: {
@@ -544,9 +595,37 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	for (GameParticipant& p: players) {
+		if (p.clientLink != nullptr && p.clientLink->IsRelayed())
+			continue;
+
 		p.SendData(packet);
 	}
 
+	if (spectatorRelay->IsEnabled())
+		spectatorRelay->Broadcast(packet);
+
+	if (canReconnect || allowSpecJoin || !gameHasStarted)
+		packetCache.push_back(packet);
+
+	if (demoRecorder != nullptr)
+		demoRecorder->SaveToDemo(packet->data, packet->length, GetDemoTime());
+}
+
+void CGameServer::BroadcastNewFrame()
+{
+	const std::shared_ptr<const netcode::RawPacket> packet = CBaseNetProtocol::Get().SendNewFrame();
+
+	// frames for clients that lag behind are held back and batched, see LagProtection
+	for (GameParticipant& p: players) {
+		if (p.clientLink != nullptr && p.clientLink->IsRelayed())
+			continue;
+
+		p.SendNewFrame(packet);
+	}
+
+	if (spectatorRelay->IsEnabled())
+		spectatorRelay->Broadcast(packet);
+
 	if (canReconnect || allowSpecJoin || !gameHasStarted)
 		packetCache.push_back(packet);
 
@@ -554,6 +633,31 @@ void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 		demoRecorder->SaveToDemo(packet->data, packet->length, GetDemoTime());
 }
 
+void CGameServer::FlushFrameBatches()
+{
+	for (GameParticipant& p: players) {
+		p.FlushFrameBatch();
+	}
+}
+
+std::string CGameServer::GetFrameBatchingStats() const
+{
+	unsigned int numFrameBatches = 0;
+	unsigned int numBatchedFrames = 0;
+	unsigned int numBatchedLinks = 0;
+
+	for (const GameParticipant& p: players) {
+		numFrameBatches += p.numFrameBatches;
+		numBatchedFrames += p.numBatchedFrames;
+		numBatchedLinks += (p.frameBatchSize > 1);
+	}
+
+	return (spring::format(
+		"Frame batching: %u frames sent in %u batches, active for %.0fs (%u clients batched now, max batch size %u)",
+		numBatchedFrames, numFrameBatches, numBatchingIntervals * playerInfoTime.toSecsf(), numBatchedLinks, maxFrameBatchSize
+	));
+}
+
 void CGameServer::Message(const std::string& message, bool broadcast, bool internal)
 {
 	if (!internal) {
@@ -762,6 +866,8 @@ void CGameServer::CheckSync()
 		++outstandingSyncFrameIt;
 	}
 
+	CheckSyncChecksums();
+
 #else
 
 	// Make it clear this build isn't suitable for release.
@@ -773,6 +879,123 @@ void CGameServer::CheckSync()
 }
 
 
+void CGameServer::CheckSyncChecksums()
+{
+#ifdef SYNCCHECK
+	std::vector<uint32_t> correctChecksums;
+	std::vector< std::pair<uint32_t, unsigned> > checksumCounts; // <checksum, #clients matching it>
+
+	auto frameIt = outstandingSyncChecksumFrames.begin();
+
+	while (frameIt != outstandingSyncChecksumFrames.end()) {
+		const int frameNum = *frameIt;
+
+		bool completeResponseSet = true;
+
+		for (const GameParticipant& p: players) {
+			if (p.clientLink == nullptr)
+				continue;
+
+			completeResponseSet &= (p.syncChecksums.find(frameNum) != p.syncChecksums.end() || frameNum < (serverFrameNum - static_cast<int>(SYNCCHECK_TIMEOUT)));
+		}
+
+		if (!completeResponseSet) {
+			++frameIt;
+			continue;
+		}
+
+		correctChecksums.clear();
+
+		if (HasLocalClient()) {
+			// dictatorship, as in CheckSync
+			const auto it = players[localClientNumber].syncChecksums.find(frameNum);
+
+			if (it != players[localClientNumber].syncChecksums.end())
+				correctChecksums = it->second;
+		} else {
+			// democracy, but per subsystem so each can be blamed on its own
+			for (unsigned int subsys = 0; subsys < SubsystemChecksums::SUBSYS_COUNT; subsys++) {
+				uint32_t correctChecksum = 0;
+				unsigned maxChecksumCount = 0;
+
+				checksumCounts.clear();
+
+				for (const GameParticipant& p: players) {
+					const auto it = p.syncChecksums.find(frameNum);
+
+					if (p.clientLink == nullptr || it == p.syncChecksums.end() || subsys >= it->second.size())
+						continue;
+
+					const auto pred = [&](const std::pair<uint32_t, unsigned>& c) { return (c.first == it->second[subsys]); };
+					auto iter = std::find_if(checksumCounts.begin(), checksumCounts.end(), pred);
+
+					if (iter == checksumCounts.end()) {
+						checksumCounts.emplace_back(it->second[subsys], 0);
+						iter = checksumCounts.end() - 1;
+					}
+
+					if ((++(iter->second)) > maxChecksumCount) {
+						maxChecksumCount = iter->second;
+						correctChecksum = iter->first;
+					}
+				}
+
+				if (maxChecksumCount == 0)
+					break;
+
+				correctChecksums.push_back(correctChecksum);
+			}
+		}
+
+		for (GameParticipant& p: players) {
+			const auto it = p.syncChecksums.find(frameNum);
+
+			if (p.clientLink == nullptr || it == p.syncChecksums.end())
+				continue;
+
+			uint32_t desyncedSubsystems = 0;
+			std::string subsystemNames;
+
+			for (unsigned int subsys = 0, n = std::min(it->second.size(), correctChecksums.size()); subsys < n; subsys++) {
+				if (it->second[subsys] != correctChecksums[subsys])
+					desyncedSubsystems |= (1 << subsys);
+			}
+
+			// only name the frame in which a subsystem diverged first
+			if ((desyncedSubsystems &= ~p.desyncedSubsystems) == 0)
+				continue;
+
+			p.desyncedSubsystems |= desyncedSubsystems;
+
+			for (unsigned int subsys = 0; subsys < SubsystemChecksums::SUBSYS_COUNT; subsys++) {
+				if ((desyncedSubsystems & (1 << subsys)) == 0)
+					continue;
+
+				subsystemNames += (subsystemNames.empty()? "": ", ");
+				subsystemNames += SubsystemChecksums::GetName(subsys);
+			}
+
+			const std::string& message = spring::format(SubsystemSyncError, p.name.c_str(), frameNum, subsystemNames.c_str());
+
+			if (demoReader || !p.spectator) {
+				Message(message);
+			} else {
+				// spectator desyncs only go to the log and the spectator, as in CheckSync
+				LOG_L(L_ERROR, "%s", message.c_str());
+				PrivateMessage(p.id, message);
+			}
+		}
+
+		for (GameParticipant& p: players) {
+			p.syncChecksums.erase(frameNum);
+		}
+
+		frameIt = outstandingSyncChecksumFrames.erase(frameIt);
+	}
+#endif
+}
+
+
 float CGameServer::GetDemoTime() const {
 	if (!gameHasStarted) return gameTime;
 	return (startTime + serverFrameNum / float(GAME_SPEED));
@@ -797,6 +1020,13 @@ void CGameServer::Update()
 	if (lastPlayerInfo < (spring_gettime() - playerInfoTime)) {
 		lastPlayerInfo = spring_gettime();
 
+		if (hostif != nullptr && hostif->WantsTelemetry() && numUpdates > 0)
+			hostif->SendFrameTiming(serverFrameNum, internalSpeed, updateTimeSum / numUpdates, updateTimeMax);
+
+		updateTimeSum = 0.0f;
+		updateTimeMax = 0.0f;
+		numUpdates = 0;
+
 		if (!PreSimFrame()) {
 			LagProtection();
 		} else {
@@ -875,6 +1105,9 @@ void CGameServer::LagProtection()
 			const int curPing = ((serverFrameNum - player.lastFrameResponse) * 1000) / (GAME_SPEED * internalSpeed);
 			Broadcast(CBaseNetProtocol::Get().SendPlayerInfo(player.id, player.cpuUsage, curPing));
 
+			if (hostif != nullptr && hostif->WantsTelemetry())
+				hostif->SendPlayerInfo(player.id, player.cpuUsage, curPing);
+
 			const float playerCpuUsage = player.cpuUsage;
 			const float correctedCpu   = Clamp(playerCpuUsage, 0.0f, 1.0f);
 
@@ -938,6 +1171,30 @@ void CGameServer::LagProtection()
 		if (newSpeed != internalSpeed)
 			InternalSpeedChange(newSpeed);
 	}
+
+	// batch frames for remote clients that fall behind because they can not keep
+	// up (one more frame per batch for each second of lag), so they catch up with
+	// fewer messages and wakeups instead of dragging the game down further; all
+	// other clients keep getting one frame per message
+	bool batching = false;
+
+	for (GameParticipant& player: players) {
+		int batchSize = 1;
+
+		// relayed links share one stream of single frames
+		const bool relayed = (player.clientLink != nullptr && player.clientLink->IsRelayed());
+
+		if (maxFrameBatchSize > 1 && player.myState == GameParticipant::INGAME && !player.isLocal && !relayed && player.cpuUsage >= frameBatchCpuUsage) {
+			const int framesBehind = serverFrameNum - player.lastFrameResponse;
+
+			batchSize = Clamp(framesBehind / GAME_SPEED + 1, 1, int(maxFrameBatchSize));
+		}
+
+		player.SetFrameBatchSize(batchSize);
+		batching |= (batchSize > 1);
+	}
+
+	numBatchingIntervals += batching;
 }
 
 
@@ -1348,6 +1605,34 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 #endif
 		} break;
 
+		case NETMSG_SYNCCHECKSUMS: {
+#ifdef SYNCCHECK
+			try {
+				netcode::UnpackPacket pckt(packet, 2);
+
+				unsigned char playerNum; pckt >> playerNum;
+				          int  frameNum; pckt >> frameNum;
+
+				if (playerNum != a) {
+					Message(spring::format(WrongPlayer, msgCode, a, playerNum));
+					break;
+				}
+
+				// responses that arrive after the comparison window has passed are useless
+				if (frameNum > serverFrameNum || frameNum < (serverFrameNum - static_cast<int>(SYNCCHECK_TIMEOUT)))
+					break;
+
+				std::vector<uint32_t> checksums((packet->length - 7) / sizeof(uint32_t));
+				pckt >> checksums;
+
+				players[a].syncChecksums[frameNum] = std::move(checksums);
+				outstandingSyncChecksumFrames.insert(frameNum);
+			} catch (const netcode::UnpackPacketException& ex) {
+				Message(spring::format("[GameServer::%s][NETMSG_SYNCCHECKSUMS] exception \"%s\" from player \"%s\"", __func__, ex.what(), players[a].name.c_str()));
+			}
+#endif
+		} break;
+
 		case NETMSG_SHARE:
 			if (inbuf[1] != a) {
 				Message(spring::format(WrongPlayer, msgCode, a, (unsigned)inbuf[1]));
@@ -1548,6 +1833,10 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 					players[player].team      = newTeamID;
 					players[player].spectator = false;
 
+					// players are served by the server thread
+					if (players[player].clientLink != nullptr)
+						spectatorRelay->RemoveLink(players[player].clientLink);
+
 					if (!teams[newTeamID].HasLeader())
 						teams[newTeamID].SetLeader(player);
 
@@ -1821,6 +2110,7 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 		//case NETMSG_REJECT_CONNECT:
 		//case NETMSG_GAMEDATA:
 		//case NETMSG_RANDSEED:
+		//case NETMSG_NEWFRAMES: (not expanded on the server's links)
 		default: {
 			Message(spring::format(UnknownNetmsg, msgCode, a));
 		}
@@ -2497,6 +2787,10 @@ void CGameServer::PushAction(const Action& action, bool fromAutoHost)
 			}
 		} break;
 
+		case hashString("framebatching"): {
+			Message(GetFrameBatchingStats(), false);
+		} break;
+
 		case hashString("kill"): {
 			LOG("Server killed!");
 			quitServer = true;
@@ -2627,7 +2921,7 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 			if ((serverFrameNum % serverKeyframeInterval) == 0) {
 				Broadcast(CBaseNetProtocol::Get().SendKeyFrame(serverFrameNum));
 			} else {
-				Broadcast(CBaseNetProtocol::Get().SendNewFrame());
+				BroadcastNewFrame();
 			}
 
 			// every gameProgressFrameInterval, we broadcast current frame in a
@@ -2637,13 +2931,22 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 				CBaseNetProtocol::PacketType progressPacket = CBaseNetProtocol::Get().SendCurrentFrameProgress(serverFrameNum);
 				// we cannot use broadcast here, since we want to skip caching
 				for (GameParticipant& p: players) {
+					if (p.clientLink != nullptr && p.clientLink->IsRelayed())
+						continue;
+
 					p.SendData(progressPacket);
 				}
+
+				if (spectatorRelay->IsEnabled())
+					spectatorRelay->Broadcast(progressPacket);
 			}
 		#ifdef SYNCCHECK
 			outstandingSyncFrames.insert(serverFrameNum);
 		#endif
 		}
+	} else {
+		// do not hold back frames while paused
+		FlushFrameBatches();
 	}
 }
 
@@ -2683,10 +2986,27 @@ void CGameServer::UpdateLoop()
 				udpListener->Update();
 
 			std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
+
+			const spring_time updateStartTime = spring_gettime();
+
 			ServerReadNet();
 			Update();
+
+			const float updateTime = (spring_gettime() - updateStartTime).toMilliSecsf();
+
+			updateTimeSum += updateTime;
+			updateTimeMax = std::max(updateTimeMax, updateTime);
+			numUpdates += 1;
 		}
 
+		FlushFrameBatches();
+
+		// deliver what the relay still has queued, the quit message goes out directly
+		spectatorRelay->Kill();
+
+		if (numBatchingIntervals > 0)
+			Message(GetFrameBatchingStats(), false);
+
 		if (hostif != nullptr)
 			hostif->SendQuit();
 
@@ -2976,6 +3296,8 @@ unsigned CGameServer::BindConnection(
 	}
 
 	newPlayer.Connected(clientLink, isLocal);
+	// network version has been checked, client can handle compressed traffic
+	clientLink->EnableCompression();
 	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
@@ -3003,6 +3325,11 @@ unsigned CGameServer::BindConnection(
 	Message(spring::format(" -> Connection established (given id %i)", newPlayerNumber));
 	clientLink->SetLossFactor(netloss);
 	clientLink->Flush(!gameHasStarted);
+
+	// everything broadcast from here on reaches remote spectators through the relay
+	if (newPlayer.spectator && !isLocal && spectatorRelay->IsEnabled())
+		spectatorRelay->AddLink(clientLink);
+
 	return newPlayerNumber;
 }
 
@@ -36,6 +36,7 @@ namespace netcode
 class CDemoReader;
 class Action;
 class CDemoRecorder;
+class CSpectatorRelay;
 class AutohostInterface;
 class ClientSetup;
 class CGameSetup;
@@ -161,6 +162,7 @@ private:
 	void Update();
 	void ProcessPacket(const unsigned playerNum, std::shared_ptr<const netcode::RawPacket> packet);
 	void CheckSync();
+	void CheckSyncChecksums();
 	void HandleConnectionAttempts();
 	void ServerReadNet();
 
@@ -174,6 +176,11 @@ private:
 	bool SendDemoData(int targetFrameNum);
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
+	/// like Broadcast(SendNewFrame()), but lagging clients get their frames in batches
+	void BroadcastNewFrame();
+	/// sends the frames held back for batching to all clients
+	void FlushFrameBatches();
+	std::string GetFrameBatchingStats() const;
 
 	/**
 	 * @brief skip frames
@@ -226,6 +233,7 @@ private:
 	/////////////////// sync stuff ///////////////////
 #ifdef SYNCCHECK
 	std::set<int> outstandingSyncFrames;
+	std::set<int> outstandingSyncChecksumFrames;
 #endif
 
 	/////////////////// game status variables ///////////////////
@@ -250,9 +258,25 @@ private:
 	int curSpeedCtrl = 0;
 	int loopSleepTime = 0;
 
+	/// upper bound of each client's frame batch size, adapted to its lag in LagProtection
+	unsigned int maxFrameBatchSize = 1;
+
+	// how long batching was active for any client, see "/framebatching"
+	unsigned int numBatchingIntervals = 0;
+
+	// duration of ServerReadNet() + Update() since the last telemetry report (ms)
+	float updateTimeSum = 0.0f;
+	float updateTimeMax = 0.0f;
+	unsigned int numUpdates = 0;
+
 
 	int serverFrameNum = -1;
 
+	// when resuming a demo from a keyframe, the number of demo frames
+	// already contained in it and the number of those read so far
+	int demoSeekFrame = 0;
+	int demoSeekFrameNum = 0;
+
 	int syncErrorFrame = 0;
 	int syncWarningFrame = 0;
 
@@ -288,6 +312,7 @@ private:
 	std::unique_ptr<CDemoReader> demoReader;
 	std::unique_ptr<CDemoRecorder> demoRecorder;
 	std::unique_ptr<AutohostInterface> hostif;
+	std::unique_ptr<CSpectatorRelay> spectatorRelay;
 
 	CGlobalUnsyncedRNG rng;
 	spring::thread thread;
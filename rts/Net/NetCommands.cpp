@@ -7,6 +7,7 @@
 
 #include "ExternalAI/EngineOutHandler.h"
 #include "ExternalAI/SkirmishAIHandler.h"
+#include "Game/Benchmark.h"
 #include "Game/ClientData.h"
 #include "Game/CommandMessage.h"
 #include "Game/GameSetup.h"
@@ -31,11 +32,13 @@
 #include "System/EventHandler.h"
 #include "System/GlobalConfig.h"
 #include "System/Log/ILog.h"
+#include "System/MsgStrings.h"
 #include "System/SpringMath.h"
 #include "System/TimeProfiler.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Net/UnpackPacket.h"
 #include "System/Sound/ISound.h"
+#include "System/Sync/SubsystemChecksums.h"
 
 CONFIG(bool, LogClientData).defaultValue(false);
 
@@ -450,6 +453,10 @@ void CGame::ClientReadNet()
 
 					LOG("%s", sysMsg.c_str());
 					AddTraffic(-1, packetCode, dataLength);
+
+					// every frame of the demo precedes this message
+					if (sysMsg == DemoEnd)
+						benchmark.DemoEnded();
 				} catch (const netcode::UnpackPacketException& ex) {
 					LOG_L(L_ERROR, "[Game::%s][NETMSG_SYSTEMMSG] exception \"%s\"", __func__, ex.what());
 				}
@@ -571,6 +578,13 @@ void CGame::ClientReadNet()
 				if (haveServerDemo)
 					localSyncChecksums[gs->frameNum] = CSyncChecker::GetChecksum();
 
+				if (syncChecksumInterval > 0 && (gs->frameNum % syncChecksumInterval) == 0) {
+					SubsystemChecksums::Checksums checksums;
+					SubsystemChecksums::Calc(checksums);
+
+					clientNet->Send(CBaseNetProtocol::Get().SendSyncChecksums(gu->myPlayerNum, gs->frameNum, {checksums.begin(), checksums.end()}));
+				}
+
 				// reset checksum every 4096 frames =~ 2.5 minutes
 				if ((gs->frameNum & 4095) == 0)
 					CSyncChecker::NewFrame();
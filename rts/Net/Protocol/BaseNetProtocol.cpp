@@ -30,6 +30,13 @@ PacketType CBaseNetProtocol::SendNewFrame()
 	return PacketType(new PackPacket(sizeof(uint8_t), NETMSG_NEWFRAME));
 }
 
+PacketType CBaseNetProtocol::SendNewFrames(uint8_t numFrames)
+{
+	PackPacket* packet = new PackPacket(sizeof(uint8_t) + sizeof(numFrames), NETMSG_NEWFRAMES);
+	*packet << numFrames;
+	return PacketType(packet);
+}
+
 
 PacketType CBaseNetProtocol::SendQuit(const std::string& reason)
 {
@@ -383,6 +390,17 @@ PacketType CBaseNetProtocol::SendSyncResponse(uint8_t playerNum, int32_t frameNu
 	return PacketType(packet);
 }
 
+PacketType CBaseNetProtocol::SendSyncChecksums(uint8_t playerNum, int32_t frameNum, const std::vector<uint32_t>& checksums)
+{
+	const uint32_t payloadSize = sizeof(playerNum) + sizeof(frameNum) + (checksums.size() * sizeof(uint32_t));
+	const uint32_t headerSize = sizeof(uint8_t) + sizeof(uint8_t);
+	const uint32_t packetSize = headerSize + payloadSize;
+
+	PackPacket* packet = new PackPacket(packetSize, NETMSG_SYNCCHECKSUMS);
+	*packet << static_cast<uint8_t>(packetSize) << playerNum << frameNum << checksums;
+	return PacketType(packet);
+}
+
 PacketType CBaseNetProtocol::SendSystemMessage(uint8_t playerNum, std::string message)
 {
 	if (message.size() > 65000) {
@@ -646,6 +664,7 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_GAMEOVER, -1);
 	proto->AddType(NETMSG_MAPDRAW, -1);
 	proto->AddType(NETMSG_SYNCRESPONSE, 10);
+	proto->AddType(NETMSG_SYNCCHECKSUMS, -1);
 	proto->AddType(NETMSG_SYSTEMMSG, -2);
 	proto->AddType(NETMSG_STARTPOS, 16);
 	proto->AddType(NETMSG_PLAYERINFO, 10);
@@ -666,6 +685,8 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_AI_STATE_CHANGED, 4);
 	proto->AddType(NETMSG_GAME_FRAME_PROGRESS, 5);
 	proto->AddType(NETMSG_PING, 1 + (1 + 1 + 4));
+	proto->AddType(NETMSG_COMPRESSED, -2);
+	proto->AddType(NETMSG_NEWFRAMES, 2);
 
 #ifdef SYNCDEBUG
 	proto->AddType(NETMSG_SD_CHKREQUEST, 5);
@@ -43,6 +43,7 @@ public:
 
 	PacketType SendKeyFrame(int32_t frameNum);
 	PacketType SendNewFrame();
+	PacketType SendNewFrames(uint8_t numFrames);
 	PacketType SendQuit(const std::string& reason);
 	/// client can send these to force-start the game
 	PacketType SendStartPlaying(uint32_t countdown);
@@ -74,6 +75,7 @@ public:
 	PacketType SendMapDrawLine(uint8_t playerNum, int16_t x1, int16_t z1, int16_t x2, int16_t z2, bool);
 	PacketType SendMapDrawPoint(uint8_t playerNum, int16_t x, int16_t z, const std::string& label, bool);
 	PacketType SendSyncResponse(uint8_t playerNum, int32_t frameNum, uint32_t checksum);
+	PacketType SendSyncChecksums(uint8_t playerNum, int32_t frameNum, const std::vector<uint32_t>& checksums);
 	PacketType SendSystemMessage(uint8_t playerNum, std::string message);
 	PacketType SendStartPos(uint8_t playerNum, uint8_t teamNum, uint8_t readyState, float x, float y, float z);
 	PacketType SendPlayerInfo(uint8_t playerNum, float cpuUsage, int32_t ping);
@@ -93,6 +93,11 @@ enum NETMSG {
 
 	NETMSG_PING = 78, // uint8_t playerNum, uint8_t pingTag, float localTime
 
+	NETMSG_COMPRESSED       = 79, // uint16_t messageSize, raw deflate stream of complete messages # (un)packed by UDPConnection, never seen by the game #
+	NETMSG_SYNCCHECKSUMS    = 81, // uint8_t msgsize, playerNum; int32_t frameNum; uint32_t checksums[] # per-subsystem, see SubsystemChecksums.h #
+
+	NETMSG_NEWFRAMES        = 80, // uint8_t numFrames # batch of consecutive NETMSG_NEWFRAME's, expanded by the client's UDPConnection, never seen by the game #
+
 	NETMSG_LAST //max types of netmessages, internal only
 };
 
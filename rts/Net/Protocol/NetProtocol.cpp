@@ -54,7 +54,10 @@ void CNetProtocol::InitClient(std::shared_ptr<ClientSetup> clientSetup, const st
 	userName = clientSetup->myPlayerName;
 	userPasswd = clientSetup->myPasswd;
 
-	serverConnPtr = new (serverConnMem) netcode::UDPConnection(configHandler->GetInt("SourcePort"), clientSetup->hostIP, clientSetup->hostPort);
+	netcode::UDPConnection* conn = new (serverConnMem) netcode::UDPConnection(configHandler->GetInt("SourcePort"), clientSetup->hostIP, clientSetup->hostPort);
+	conn->SetExpandFrameBatches(true);
+
+	serverConnPtr = conn;
 	serverConnPtr->Unmute();
 	serverConnPtr->SendData(CBaseNetProtocol::Get().SendAttemptConnect(userName, userPasswd, clientVersion, clientPlatform, globalConfig.networkLossFactor));
 	serverConnPtr->Flush(true);
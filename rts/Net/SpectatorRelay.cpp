@@ -0,0 +1,162 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <functional>
+
+#include "SpectatorRelay.h"
+
+#include "System/Net/Connection.h"
+#include "System/Net/RawPacket.h"
+#include "System/Platform/Threading.h"
+
+
+void CSpectatorRelay::Init(int interval)
+{
+	Kill();
+
+	if ((relayInterval = interval) <= 0)
+		return;
+
+	quitRelay = false;
+	relayThread = std::move(spring::thread(std::bind(&CSpectatorRelay::UpdateLoop, this)));
+}
+
+void CSpectatorRelay::Kill()
+{
+	if (relayThread.joinable()) {
+		{
+			std::lock_guard<spring::mutex> lock(queueMutex);
+			quitRelay = true;
+		}
+
+		queueCond.notify_all();
+		relayThread.join();
+	}
+
+	// the thread is gone, hand whatever links are left back to their owners
+	for (const std::weak_ptr<netcode::CConnection>& link: links) {
+		if (link.expired())
+			continue;
+
+		link.lock()->SetRelayed(false);
+	}
+
+	links.clear();
+	queuedItems.clear();
+	relayedItems.clear();
+
+	numQueuedItems = 0;
+	numRelayedItems = 0;
+	relayInterval = 0;
+}
+
+
+void CSpectatorRelay::AddLink(std::shared_ptr<netcode::CConnection> link)
+{
+	link->SetRelayed(true);
+	PushItem({RELAY_ITEM_ADD_LINK, nullptr, link});
+}
+
+void CSpectatorRelay::RemoveLink(std::shared_ptr<netcode::CConnection> link)
+{
+	if (!link->IsRelayed())
+		return;
+
+	std::unique_lock<spring::mutex> lock(queueMutex);
+
+	queuedItems.push_back({RELAY_ITEM_REMOVE_LINK, nullptr, link});
+	numQueuedItems += 1;
+
+	// everything queued before this is sent to <link> first
+	const unsigned int itemNum = numQueuedItems;
+
+	queueCond.wait(lock, [&]() { return (numRelayedItems >= itemNum); });
+	link->SetRelayed(false);
+}
+
+void CSpectatorRelay::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
+{
+	PushItem({RELAY_ITEM_PACKET, packet, {}});
+}
+
+
+void CSpectatorRelay::PushItem(RelayItem&& item)
+{
+	std::lock_guard<spring::mutex> lock(queueMutex);
+
+	queuedItems.emplace_back(std::move(item));
+	numQueuedItems += 1;
+}
+
+void CSpectatorRelay::ProcessItems(std::vector<RelayItem>& items)
+{
+	for (RelayItem& item: items) {
+		switch (item.type) {
+			case RELAY_ITEM_PACKET: {
+				for (const std::weak_ptr<netcode::CConnection>& link: links) {
+					if (link.expired())
+						continue;
+
+					link.lock()->SendData(item.packet);
+				}
+			} break;
+
+			case RELAY_ITEM_ADD_LINK: {
+				links.push_back(item.link);
+			} break;
+
+			case RELAY_ITEM_REMOVE_LINK: {
+				const auto pred = [&](const std::weak_ptr<netcode::CConnection>& link) {
+					return (!link.owner_before(item.link) && !item.link.owner_before(link));
+				};
+
+				links.erase(std::remove_if(links.begin(), links.end(), pred), links.end());
+			} break;
+		}
+	}
+
+	items.clear();
+}
+
+
+void CSpectatorRelay::UpdateLoop()
+{
+	Threading::SetThreadName("relay");
+
+	while (true) {
+		unsigned int itemNum = 0;
+		bool quit = false;
+
+		{
+			std::unique_lock<spring::mutex> lock(queueMutex);
+
+			queueCond.wait_for(lock, std::chrono::milliseconds(relayInterval), [&]() { return quitRelay; });
+			std::swap(queuedItems, relayedItems);
+
+			itemNum = numQueuedItems;
+			quit = quitRelay;
+		}
+
+		ProcessItems(relayedItems);
+
+		for (const std::weak_ptr<netcode::CConnection>& link: links) {
+			if (link.expired())
+				continue;
+
+			link.lock()->Update();
+		}
+
+		// links of players that left or were kicked are not removed explicitly
+		links.erase(std::remove_if(links.begin(), links.end(), [](const std::weak_ptr<netcode::CConnection>& link) { return link.expired(); }), links.end());
+
+		{
+			std::lock_guard<spring::mutex> lock(queueMutex);
+			numRelayedItems = itemNum;
+		}
+
+		queueCond.notify_all();
+
+		if (quit)
+			break;
+	}
+}
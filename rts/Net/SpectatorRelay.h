@@ -0,0 +1,87 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SPECTATOR_RELAY_H
+#define SPECTATOR_RELAY_H
+
+#include <memory>
+#include <vector>
+
+#include "System/Threading/SpringThreading.h"
+
+namespace netcode
+{
+	class RawPacket;
+	class CConnection;
+}
+
+/**
+ * Fans broadcast traffic out to spectator links on a dedicated thread, so
+ * a server with many spectators does not spend its own tick on copying
+ * every packet into (and flushing) each of their connections.
+ *
+ * Broadcasts and link changes are queued in a single ordered stream; the
+ * relay thread applies it every <interval> milliseconds and then updates
+ * (flushes, resends, checks timeouts of) all its links. Relayed links are
+ * flagged so the server and UDPListener leave their sending to the relay,
+ * while the server keeps reading from them as before. The links share the
+ * server's UDP socket, every use of which is serialized by the UDPListener's
+ * socket mutex.
+ */
+class CSpectatorRelay
+{
+public:
+	~CSpectatorRelay() { Kill(); }
+
+	void Init(int interval);
+	/// delivers whatever is still queued, then stops the thread
+	void Kill();
+
+	bool IsEnabled() const { return (relayInterval > 0); }
+
+	/// starts relaying to <link>, which then receives all later broadcasts
+	void AddLink(std::shared_ptr<netcode::CConnection> link);
+	/// stops relaying to <link>, returns once the relay no longer touches it
+	void RemoveLink(std::shared_ptr<netcode::CConnection> link);
+
+	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
+
+private:
+	enum {
+		RELAY_ITEM_PACKET,
+		RELAY_ITEM_ADD_LINK,
+		RELAY_ITEM_REMOVE_LINK,
+	};
+
+	struct RelayItem {
+		int type;
+
+		std::shared_ptr<const netcode::RawPacket> packet;
+		std::weak_ptr<netcode::CConnection> link;
+	};
+
+	void PushItem(RelayItem&& item);
+	void ProcessItems(std::vector<RelayItem>& items);
+
+	void UpdateLoop();
+
+private:
+	spring::thread relayThread;
+
+	spring::mutex queueMutex;
+	spring::condition_variable queueCond;
+
+	/// written by the server thread
+	std::vector<RelayItem> queuedItems;
+	/// owned by the relay thread
+	std::vector<RelayItem> relayedItems;
+	std::vector< std::weak_ptr<netcode::CConnection> > links;
+
+	unsigned int numQueuedItems = 0;
+	unsigned int numRelayedItems = 0;
+
+	int relayInterval = 0;
+
+	bool quitRelay = false;
+};
+
+#endif // SPECTATOR_RELAY_H
@@ -8,8 +8,12 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Objects/SolidObject.h"
 #include "System/Matrix44f.h"
+#include "System/SpringMath.h"
 #include "System/Log/ILog.h"
 
+#include <limits>
+#include <xmmintrin.h>
+
 unsigned int CCollisionHandler::numDiscTests = 0;
 unsigned int CCollisionHandler::numContTests = 0;
 
@@ -72,6 +76,75 @@ bool CCollisionHandler::DetectHit(
 
 
 
+void CollisionSphereBatch::Add(const CSolidObject* o, const CollisionVolume* v)
+{
+	const float3 wsp = v->GetWorldSpacePos(o);
+
+	// piece-tree volumes are not bounded by the object's own volume;
+	// otherwise pad the radius so float rounding can never cull a hit
+	const float rad = v->GetBoundingRadius() * 1.01f + 1.0f;
+	const float rsq = v->DefaultToPieceTree()? std::numeric_limits<float>::max(): (rad * rad);
+
+	xs.push_back(wsp.x);
+	ys.push_back(wsp.y);
+	zs.push_back(wsp.z);
+	rsqs.push_back(rsq);
+}
+
+size_t CCollisionHandler::CullSegmentHits(CollisionSphereBatch& b, const float3 p0, const float3 p1)
+{
+	const size_t n = b.rsqs.size();
+	const size_t n4 = n & ~size_t(3);
+
+	const float3 dir = p1 - p0;
+	const float dirSq = dir.SqLength();
+	// degenerate segments reduce to a point-sphere test (t = 0)
+	const float dirSqInv = (dirSq > 0.0f)? (1.0f / dirSq): 0.0f;
+
+	size_t numCandidates = 0;
+
+	b.mask.resize(n);
+
+	const __m128 p0x = _mm_set1_ps(p0.x), p0y = _mm_set1_ps(p0.y), p0z = _mm_set1_ps(p0.z);
+	const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+	const __m128 dInv = _mm_set1_ps(dirSqInv);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (size_t i = 0; i < n4; i += 4) {
+		// vector from segment start to sphere center
+		const __m128 wx = _mm_sub_ps(_mm_loadu_ps(&b.xs[i]), p0x);
+		const __m128 wy = _mm_sub_ps(_mm_loadu_ps(&b.ys[i]), p0y);
+		const __m128 wz = _mm_sub_ps(_mm_loadu_ps(&b.zs[i]), p0z);
+
+		// parameter of the closest point on the segment, clamped to [0, 1]
+		__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, dx), _mm_mul_ps(wy, dy)), _mm_mul_ps(wz, dz));
+		t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(t, dInv), zero), one);
+
+		const __m128 qx = _mm_sub_ps(wx, _mm_mul_ps(t, dx));
+		const __m128 qy = _mm_sub_ps(wy, _mm_mul_ps(t, dy));
+		const __m128 qz = _mm_sub_ps(wz, _mm_mul_ps(t, dz));
+		const __m128 qq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz));
+
+		const int bits = _mm_movemask_ps(_mm_cmple_ps(qq, _mm_loadu_ps(&b.rsqs[i])));
+
+		for (size_t j = 0; j < 4; j++) {
+			numCandidates += (b.mask[i + j] = ((bits >> j) & 1));
+		}
+	}
+
+	for (size_t i = n4; i < n; i++) {
+		const float3 w = float3(b.xs[i], b.ys[i], b.zs[i]) - p0;
+		const float t = Clamp(w.dot(dir) * dirSqInv, 0.0f, 1.0f);
+
+		numCandidates += (b.mask[i] = ((w - dir * t).SqLength() <= b.rsqs[i]));
+	}
+
+	return numCandidates;
+}
+
+
+
 bool CCollisionHandler::Collision(
 	const CSolidObject* o,
 	const CollisionVolume* v,
@@ -8,6 +8,8 @@
 #include "System/Matrix44f.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <vector>
 
 class CSolidObject;
 struct LocalModelPiece;
@@ -86,6 +88,37 @@ private:
 	const LocalModelPiece* lmp = nullptr;
 };
 
+/**
+ * SoA bounding-spheres (world-space) of a batch of objects' collision
+ * volumes, used to cull DetectHit candidates for one ray segment four
+ * lanes at a time before running the exact per-volume tests
+ */
+struct CollisionSphereBatch {
+public:
+	void Clear() {
+		xs.clear();
+		ys.clear();
+		zs.clear();
+		rsqs.clear();
+		mask.clear();
+	}
+
+	void Add(const CSolidObject* o, const CollisionVolume* v);
+
+	// true if the object at index <i> survived the last cull
+	bool IsCandidate(size_t i) const { return (mask[i] != 0); }
+	size_t Size() const { return rsqs.size(); }
+
+private:
+	friend class CCollisionHandler;
+
+	std::vector<float> xs;
+	std::vector<float> ys;
+	std::vector<float> zs;
+	std::vector<float> rsqs;
+	std::vector<uint8_t> mask;
+};
+
 /**
  * Responsible for detecting hits between projectiles
  * and solid objects (units, features), each SO has a
@@ -112,6 +145,14 @@ class CCollisionHandler {
 			CollisionQuery* cq = nullptr,
 			bool forceTrace = false
 		);
+		/**
+		 * Conservatively marks which objects in <b> could be hit by
+		 * the segment [p0, p1]; a culled object is guaranteed to not
+		 * pass DetectHit, surviving ones still need the exact test
+		 * @return number of surviving candidates
+		 */
+		static size_t CullSegmentHits(CollisionSphereBatch& b, const float3 p0, const float3 p1);
+
 		static bool MouseHit(
 			const CSolidObject* o,
 			const CMatrix44f& m,
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <xmmintrin.h>
 
 #include "LosMap.h"
 #include "LosHandler.h"
@@ -10,6 +12,7 @@
 #include "System/float3.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
+#include "System/Threading/SpringThreading.h"
 #include "System/Threading/ThreadPool.h"
 #ifdef USE_UNSYNCED_HEIGHTMAP
 	#include "Game/GlobalUnsynced.h" // for myAllyTeam
@@ -519,6 +522,68 @@ inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
 }
 
 
+// per-radius copies of RADIUS_ISQRT_TABLES laid out like the angle maps, such that
+// the raycast precalc reads them linearly alongside the heightmap rows; shared by
+// all threads since unlike the other tables they only depend on the radius
+static std::array<std::vector<float>, MAX_UNIT_SENSOR_RADIUS + 1> RADIUS_ISQRT_MAPS;
+// set once the map for a radius is complete, lookups of existing maps do not lock
+static std::array<std::atomic<const float*>, MAX_UNIT_SENSOR_RADIUS + 1> RADIUS_ISQRT_MAP_PTRS;
+static spring::mutex radiusIsqrtMapsMutex;
+
+static const float* isqrtMapLookup(int radius)
+{
+	assert(radius <= MAX_UNIT_SENSOR_RADIUS);
+
+	const float* isqrtMapPtr = RADIUS_ISQRT_MAP_PTRS[radius].load(std::memory_order_acquire);
+
+	if (isqrtMapPtr != nullptr)
+		return isqrtMapPtr;
+
+	std::lock_guard<spring::mutex> lock(radiusIsqrtMapsMutex);
+
+	std::vector<float>& isqrtMap = RADIUS_ISQRT_MAPS[radius];
+
+	// another thread might have created it while we waited
+	if (isqrtMap.empty()) {
+		isqrtMap.resize(Square((2 * radius) + 1));
+
+		for (int y = -radius; y <= radius; ++y) {
+			for (int x = -radius; x <= radius; ++x) {
+				isqrtMap[ToAngleMapIdx(int2(x, y), radius)] = math::isqrt(std::max(unsigned(x * x + y * y), 1u));
+			}
+		}
+
+		RADIUS_ISQRT_MAP_PTRS[radius].store(isqrtMap.data(), std::memory_order_release);
+	}
+
+	return (isqrtMap.data());
+}
+
+// computes the raycast angles for one row of squares four at a time; the
+// operations match the scalar tail exactly so results stay bit-identical
+static void CalcRaycastAngles(float* angles, const float* heights, const float* invRs, unsigned int count, float losHeight)
+{
+	const __m128 zeroVec = _mm_setzero_ps();
+	const __m128 hgtVec = _mm_set1_ps(losHeight);
+	const __m128 bonVec = _mm_set1_ps(LOS_BONUS_HEIGHT);
+
+	unsigned int i = 0;
+
+	for (; (i + 4) <= count; i += 4) {
+		// _mm_max_ps returns its second operand for NaN's and zeros of either sign, as std::max(0, h) does
+		const __m128 dh = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(heights + i), zeroVec), hgtVec);
+
+		_mm_storeu_ps(angles + i, _mm_mul_ps(_mm_add_ps(dh, bonVec), _mm_loadu_ps(invRs + i)));
+	}
+
+	for (; i < count; ++i) {
+		const float dh = std::max(0.0f, heights[i]) - losHeight;
+
+		angles[i] = (dh + LOS_BONUS_HEIGHT) * invRs[i];
+	}
+}
+
+
 inline void CastLos(
 	float* prvAngle,
 	float* maxAngle,
@@ -620,6 +685,8 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	// 2. The heightmap is much bigger than the circle, and won't fit into the L2/L3. So
 	//    when we buffer the precalc in a vector just large enough for the processed data,
 	//    we reduce the amount of cache misses.
+	const float* isqrtMap = isqrtMapLookup(radius);
+
 	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
 		const unsigned y_ = pos.y + y;
 		const unsigned sx = pos.x - width;
@@ -627,29 +694,13 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 
 		const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
 
-		float* raycastAnglesPtr = &raycastAngles[oidx];
-		char* losRaySquaresPtr = &losRaySquares[oidx];
-
-		int idx = MAP_SQUARE(int2(sx, y_));
-
-		for (unsigned x_ = sx; x_ < ex; ++x_) {
-			const int2 off(x_ - pos.x, y);
-
-			if (off == int2(0, 0)) {
-				++idx;
-				++raycastAnglesPtr;
-				++losRaySquaresPtr;
-				continue;
-			}
-
-			const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-			const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
-
-			*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-			*(losRaySquaresPtr++) = true;
-		}
+		CalcRaycastAngles(&raycastAngles[oidx], &mipHeightMap[MAP_SQUARE(int2(sx, y_))], &isqrtMap[oidx], ex - sx, losHeight);
+		std::fill(losRaySquares.begin() + oidx, losRaySquares.begin() + oidx + (ex - sx), true);
 	});
 
+	// the center square is not part of any ray
+	raycastAngles[ToAngleMapIdx(int2(0, 0), radius)] = -1e8;
+
 	// cast the rays
 	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
@@ -704,6 +755,8 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
 
 	// Optimization: precalc all angles
+	const float* isqrtMap = isqrtMapLookup(radius);
+
 	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
 		const unsigned y_ = pos.y + y;
 
@@ -711,32 +764,22 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 			const unsigned sx = Clamp(pos.x - width,     0, size.x);
 			const unsigned ex = Clamp(pos.x + width + 1, 0, size.x);
 
-			const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
+			if (sx >= ex)
+				return;
 
-			float* raycastAnglesPtr = &raycastAngles[oidx];
-			char* losRaySquaresPtr = &losRaySquares[oidx];
-
-			int idx = MAP_SQUARE(int2(sx, y_));
-
-			for (unsigned x_ = sx; x_ < ex; ++x_) {
-				const int2 off(x_ - pos.x, y);
-
-				if (off == int2(0, 0)) {
-					++idx;
-					++raycastAnglesPtr;
-					++losRaySquaresPtr;
-					continue;
-				}
-
-				const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-				const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
+			const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
 
-				*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-				*(losRaySquaresPtr++) = true;
-			}
+			CalcRaycastAngles(&raycastAngles[oidx], &mipHeightMap[MAP_SQUARE(int2(sx, y_))], &isqrtMap[oidx], ex - sx, losHeight);
+			std::fill(losRaySquares.begin() + oidx, losRaySquares.begin() + oidx + (ex - sx), true);
 		}
 	});
 
+	// the center square is not part of any ray
+	if (safeRect.Inside(pos)) {
+		raycastAngles[ToAngleMapIdx(int2(0, 0), radius)] = -1e8;
+		losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = false;
+	}
+
 
 	// Cast the Rays
 	const size_t numRays = helper.GetLosTableSize(radius);
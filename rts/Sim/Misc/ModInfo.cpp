@@ -33,6 +33,7 @@ void CModInfo::ResetState()
 		allowSepAxisCollisionTest  = false;
 		allowGroundUnitGravity     = true;
 		allowHoverUnitStrafing     = true;
+		useUnitCollisionBroadphase = false;
 	}
 	{
 		constructionDecay      = true;
@@ -97,6 +98,8 @@ void CModInfo::ResetState()
 		pfUpdateRate     = 0.007f;
 
 		allowTake = true;
+
+		unitUpdateMultiThreaded = false;
 	}
 }
 
@@ -136,6 +139,8 @@ void CModInfo::Init(const std::string& modFileName)
 		pfUpdateRate = system.GetFloat("pathFinderUpdateRate", pfUpdateRate);
 
 		allowTake = system.GetBool("allowTake", allowTake);
+
+		unitUpdateMultiThreaded = system.GetBool("unitUpdateMultiThreaded", unitUpdateMultiThreaded);
 	}
 
 	{
@@ -152,6 +157,7 @@ void CModInfo::Init(const std::string& modFileName)
 		allowSepAxisCollisionTest = movementTbl.GetBool("allowSepAxisCollisionTest", allowSepAxisCollisionTest);
 		allowGroundUnitGravity = movementTbl.GetBool("allowGroundUnitGravity", allowGroundUnitGravity);
 		allowHoverUnitStrafing = movementTbl.GetBool("allowHoverUnitStrafing", (pathFinderSystem == QTPFS_TYPE));
+		useUnitCollisionBroadphase = movementTbl.GetBool("useUnitCollisionBroadphase", useUnitCollisionBroadphase);
 	}
 
 	{
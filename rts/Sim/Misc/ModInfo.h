@@ -51,6 +51,7 @@ public:
 	bool allowSepAxisCollisionTest;  //< determines if (ground-)units perform collision-testing via the SAT
 	bool allowGroundUnitGravity;     //< determines if (ground-)units experience gravity during regular movement
 	bool allowHoverUnitStrafing;     //< determines if (hover-)units carry their momentum sideways when turning
+	bool useUnitCollisionBroadphase; //< determines if (ground-)units gather collision candidates via a per-frame sweep-and-prune pass
 
 	// Build behaviour
 	/// Should constructions without builders decay?
@@ -163,6 +164,9 @@ public:
 	float pfUpdateRate;
 
 	bool allowTake;
+
+	/// run the per-unit Update phase on all threads (see CUnitHandler::UpdateUnitsMT)
+	bool unitUpdateMultiThreaded;
 };
 
 extern CModInfo modInfo;
@@ -14,6 +14,7 @@
 	#include "Sim/Features/Feature.h"
 	#include "Sim/Projectiles/Projectile.h"
 	#include "Sim/Units/Unit.h"
+	#include "Sim/Units/UnitHandler.h"
 	#include "Sim/Weapons/PlasmaRepulser.h"
 #endif
 
@@ -30,7 +31,9 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+
+	CR_IGNORED(unitsGeneration)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -144,6 +147,8 @@ void CQuadField::Kill()
 	tempProjectiles.ReleaseAll();
 	tempSolids.ReleaseAll();
 	tempQuads.ReleaseAll();
+
+	unitsGeneration++;
 }
 
 
@@ -166,30 +171,9 @@ int CQuadField::WorldPosToQuadFieldIdx(const float3 p) const
 void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
 {
 	pos.AssertNaNs();
-	pos.ClampInBounds();
 	qfq.quads = tempQuads.ReserveVector();
 
-	const int2 min = WorldPosToQuadField(pos - radius);
-	const int2 max = WorldPosToQuadField(pos + radius);
-
-	if (max.y < min.y || max.x < min.x)
-		return;
-
-	// qsx and qsz are always equal
-	const float maxSqLength = (radius + quadSizeX * 0.72f) * (radius + quadSizeZ * 0.72f);
-
-	for (int z = min.y; z <= max.y; ++z) {
-		for (int x = min.x; x <= max.x; ++x) {
-			assert(x < numQuadsX);
-			assert(z < numQuadsZ);
-			const float3 quadPos = float3(x * quadSizeX + quadSizeX * 0.5f, 0, z * quadSizeZ + quadSizeZ * 0.5f);
-			if (pos.SqDistance2D(quadPos) < maxSqLength) {
-				qfq.quads->push_back(z * numQuadsX + x);
-			}
-		}
-	}
-
-	return;
+	VisitQuads(pos, radius, [&](int qi) { qfq.quads->push_back(qi); });
 }
 
 
@@ -324,6 +308,7 @@ bool CQuadField::InsertUnitIf(CUnit* unit, const float3& wpos)
 
 	spring::VectorInsertUnique(baseQuads[wposQuadIdx].units, unit, false);
 	spring::VectorInsertUnique(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit, false);
+	unitsGeneration++;
 	return true;
 }
 
@@ -354,6 +339,7 @@ bool CQuadField::RemoveUnitIf(CUnit* unit, const float3& wpos)
 
 	spring::VectorErase(baseQuads[wposQuadIdx].units, unit);
 	spring::VectorErase(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit);
+	unitsGeneration++;
 	return true;
 }
 #endif
@@ -383,6 +369,7 @@ void CQuadField::MovedUnit(CUnit* unit)
 	}
 
 	unit->quads = std::move(*qfQuery.quads);
+	unitsGeneration++;
 }
 
 void CQuadField::RemoveUnit(CUnit* unit)
@@ -393,6 +380,7 @@ void CQuadField::RemoveUnit(CUnit* unit)
 	}
 
 	unit->quads.clear();
+	unitsGeneration++;
 
 	#ifdef DEBUG_QUADFIELD
 	for (const Quad& q: baseQuads) {
@@ -554,6 +542,7 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
 	const int tempNum = gs->GetTempNum();
+	const UnitHotState& hotState = unitHandler.GetHotState();
 	qfq.units = tempUnits.ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
@@ -563,11 +552,14 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 
 			u->tempNum = tempNum;
 
-			const float totRad       = radius + u->radius;
+			// .xyz := pos, .w := radius
+			const float4& unitPosRad = hotState.GetPosRadius(u->id);
+
+			const float totRad       = radius + unitPosRad.w;
 			const float totRadSq     = totRad * totRad;
 			const float posUnitDstSq = spherical?
-				pos.SqDistance(u->pos):
-				pos.SqDistance2D(u->pos);
+				pos.SqDistance(unitPosRad):
+				pos.SqDistance2D(unitPosRad);
 
 			if (posUnitDstSq >= totRadSq)
 				continue;
@@ -584,6 +576,7 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 	QuadFieldQuery qfQuery;
 	GetQuadsRectangle(qfQuery, mins, maxs);
 	const int tempNum = gs->GetTempNum();
+	const UnitHotState& hotState = unitHandler.GetHotState();
 	qfq.units = tempUnits.ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
@@ -594,7 +587,7 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 
 			unit->tempNum = tempNum;
 
-			const float3& pos = unit->pos;
+			const float4& pos = hotState.GetPosRadius(unit->id);
 			if (pos.x < mins.x || pos.x > maxs.x)
 				continue;
 			if (pos.z < mins.z || pos.z > maxs.z)
@@ -93,6 +93,30 @@ public:
 	void Kill();
 
 	void GetQuads(QuadFieldQuery& qfq, float3 pos, float radius);
+	/**
+	 * Calls @c f with the index of each quad GetQuads would return,
+	 * without touching the query caches (safe for concurrent reads)
+	 */
+	template<typename F> void VisitQuads(float3 pos, float radius, F&& f) const {
+		pos.ClampInBounds();
+
+		const int2 min = WorldPosToQuadField(pos - radius);
+		const int2 max = WorldPosToQuadField(pos + radius);
+
+		// qsx and qsz are always equal
+		const float maxSqLength = (radius + quadSizeX * 0.72f) * (radius + quadSizeZ * 0.72f);
+
+		for (int z = min.y; z <= max.y; ++z) {
+			for (int x = min.x; x <= max.x; ++x) {
+				assert(x < numQuadsX);
+				assert(z < numQuadsZ);
+				const float3 quadPos = float3(x * quadSizeX + quadSizeX * 0.5f, 0, z * quadSizeZ + quadSizeZ * 0.5f);
+				if (pos.SqDistance2D(quadPos) < maxSqLength) {
+					f(z * numQuadsX + x);
+				}
+			}
+		}
+	}
 	void GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, const float3& maxs);
 	void GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const float3& dir, float length);
 
@@ -229,6 +253,9 @@ public:
 	int GetQuadSizeX() const { return quadSizeX; }
 	int GetQuadSizeZ() const { return quadSizeZ; }
 
+	/// changes whenever a unit is added to or removed from any quad
+	unsigned int GetUnitsGeneration() const { return unitsGeneration; }
+
 	constexpr static unsigned int BASE_QUAD_SIZE = 128;
 
 private:
@@ -252,6 +279,8 @@ private:
 
 	int quadSizeX;
 	int quadSizeZ;
+
+	unsigned int unitsGeneration = 0;
 };
 
 extern CQuadField quadField;
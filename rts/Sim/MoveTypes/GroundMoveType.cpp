@@ -2,6 +2,7 @@
 
 #include "GroundMoveType.h"
 #include "MoveDefHandler.h"
+#include "UnitCollisionBroadphase.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "Game/Camera.h"
 #include "Game/GameHelper.h"
@@ -169,6 +170,9 @@ static CGroundMoveType::MemberData gmtMemberData = {
 	}},
 };
 
+// rebuilt on the first unit-collision query of each frame
+static CUnitCollisionBroadphase unitCollisionBroadphase;
+
 
 
 
@@ -365,6 +369,12 @@ static constexpr decltype(&CalcSpeedVectorInclGravity) calcSpeedVectorFuncs[] =
 
 
 
+void CGroundMoveType::InitStatic()
+{
+	unitCollisionBroadphase.Kill();
+}
+
+
 CGroundMoveType::CGroundMoveType(CUnit* owner):
 	AMoveType(owner),
 	pathController(owner),
@@ -2336,6 +2346,16 @@ bool CGroundMoveType::HandleStaticObjectCollision(
 	}
 }
 
+static bool GetBroadphaseCandidates(const CUnit* collider, CUnit* const*& beg, CUnit* const*& end)
+{
+	if (!unitCollisionBroadphase.IsBuilt(gs->frameNum)) {
+		SCOPED_TIMER("Sim::Unit::MoveType::Collisions::Broadphase");
+		unitCollisionBroadphase.Build(unitHandler.GetActiveUnits(), gs->frameNum);
+	}
+
+	return (unitCollisionBroadphase.GetCandidates(collider, beg, end));
+}
+
 void CGroundMoveType::HandleUnitCollisions(
 	CUnit* collider,
 	const float3& colliderParams, // .x := speed, .y := radius, .z := fpstretch
@@ -2351,12 +2371,29 @@ void CGroundMoveType::HandleUnitCollisions(
 	const bool allowSAT = modInfo.allowSepAxisCollisionTest;
 	const bool forceSAT = (colliderParams.z > 0.1f);
 
+	const float collisionRadius = colliderParams.x + (colliderParams.y * 2.0f);
+
+	CUnit* const* collideesBeg = nullptr;
+	CUnit* const* collideesEnd = nullptr;
+
 	// copy on purpose, since the below can call Lua
 	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, collider->pos, colliderParams.x + (colliderParams.y * 2.0f));
 
-	for (CUnit* collidee: *qfQuery.units) {
+	// broadphase candidates are a superset and still need the GetUnitsExact distance test
+	const bool useBroadphase = modInfo.useUnitCollisionBroadphase && GetBroadphaseCandidates(collider, collideesBeg, collideesEnd);
+
+	if (!useBroadphase) {
+		quadField.GetUnitsExact(qfQuery, collider->pos, collisionRadius);
+
+		collideesBeg = qfQuery.units->data();
+		collideesEnd = qfQuery.units->data() + qfQuery.units->size();
+	}
+
+	for (CUnit* const* it = collideesBeg; it != collideesEnd; ++it) {
+		CUnit* collidee = *it;
+
 		if (collidee == collider) continue;
+		if (useBroadphase && collider->pos.SqDistance(collidee->pos) >= Square(collisionRadius + collidee->radius)) continue;
 		if (collidee->IsSkidding()) continue;
 		if (collidee->IsFlying()) continue;
 
@@ -27,6 +27,8 @@ public:
 		std::array<std::pair<unsigned int, float*>, 9> floats;
 	};
 
+	static void InitStatic();
+
 	void PostLoad();
 
 	bool Update() override;
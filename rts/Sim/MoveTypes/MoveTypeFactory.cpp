@@ -15,6 +15,8 @@ void MoveTypeFactory::InitStatic() {
 	static_assert(sizeof(CGroundMoveType) >= sizeof(CHoverAirMoveType ), "");
 	static_assert(sizeof(CGroundMoveType) >= sizeof(CStaticMoveType   ), "");
 	static_assert(sizeof(CGroundMoveType) >= sizeof(CScriptMoveType   ), "");
+
+	CGroundMoveType::InitStatic();
 }
 
 AMoveType* MoveTypeFactory::GetMoveType(CUnit* unit, const UnitDef* ud) {
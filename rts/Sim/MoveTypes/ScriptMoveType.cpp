@@ -107,7 +107,7 @@ bool CScriptMoveType::Update()
 
 		if (owner->pos.y <= gndMin) {
 			owner->Move(UpVector * (gndMin - owner->pos.y), true);
-			owner->speed.y = 0.0f;
+			owner->SetVelocity({owner->speed.x, 0.0f, owner->speed.z});
 
 			if (groundStop) {
 				velVec = ZeroVector;
@@ -0,0 +1,134 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "UnitCollisionBroadphase.h"
+#include "MoveDefHandler.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
+#include "System/SpringMath.h"
+
+// distance a unit can plausibly move (or be pushed) between the
+// build and the query, on top of its speed at the time of build
+static constexpr float POSITION_MARGIN = SQUARE_SIZE * 1.0f;
+
+
+void CUnitCollisionBroadphase::Build(const std::vector<CUnit*>& units, int frameNum)
+{
+	entries.clear();
+	active.clear();
+	pairs.clear();
+	candidates.clear();
+
+	entries.reserve(units.size());
+
+	const UnitHotState& hotState = unitHandler.GetHotState();
+
+	for (CUnit* u: units) {
+		const float4& posRad = hotState.GetPosRadius(u->id);
+		const float speed = hotState.GetSpeed(u->id).w;
+		const float margin = speed + POSITION_MARGIN;
+
+		Entry e;
+		e.posX = posRad.x;
+		e.posZ = posRad.z;
+		// mirrors the query radius used by CGroundMoveType::HandleUnitCollisions
+		e.reach = (u->moveDef != nullptr)? (speed + u->moveDef->CalcFootPrintMaxInteriorRadius() * 2.0f + margin): 0.0f;
+		e.extent = posRad.w + margin;
+		e.minX = e.posX - std::max(e.reach, e.extent);
+		e.maxX = e.posX + std::max(e.reach, e.extent);
+		e.unit = u;
+
+		entries.push_back(e);
+
+		if (size_t(u->id) >= ranges.size())
+			ranges.resize(u->id + 1);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return ((a.minX < b.minX) || (a.minX == b.minX && a.unit->id < b.unit->id));
+	});
+
+	for (unsigned int i = 0; i < entries.size(); i++) {
+		const Entry& ei = entries[i];
+
+		// retire intervals that end before this one starts; order of <active> is irrelevant
+		for (unsigned int k = 0; k < active.size(); ) {
+			if (entries[ active[k] ].maxX < ei.minX) {
+				active[k] = active.back();
+				active.pop_back();
+			} else {
+				k++;
+			}
+		}
+
+		for (const unsigned int j: active) {
+			const Entry& ej = entries[j];
+
+			if (ei.reach > 0.0f) AddPair(ei, ej);
+			if (ej.reach > 0.0f) AddPair(ej, ei);
+		}
+
+		active.push_back(i);
+	}
+
+	// group by collider and visit collidees in id-order, independent of positions
+	std::sort(pairs.begin(), pairs.end(), [](const std::pair<int, CUnit*>& a, const std::pair<int, CUnit*>& b) {
+		return ((a.first < b.first) || (a.first == b.first && a.second->id < b.second->id));
+	});
+
+	candidates.reserve(pairs.size());
+
+	for (const Entry& e: entries) {
+		ranges[e.unit->id] = {e.unit, 0, 0, frameNum};
+	}
+	for (const auto& p: pairs) {
+		CandidateRange& r = ranges[p.first];
+
+		if (r.beg == r.end)
+			r.beg = candidates.size();
+
+		candidates.push_back(p.second);
+		r.end = candidates.size();
+	}
+
+	builtFrame = frameNum;
+}
+
+void CUnitCollisionBroadphase::Kill()
+{
+	entries.clear();
+	active.clear();
+	pairs.clear();
+	candidates.clear();
+	ranges.clear();
+
+	builtFrame = -1;
+}
+
+void CUnitCollisionBroadphase::AddPair(const Entry& collider, const Entry& collidee)
+{
+	const float dx = collider.posX - collidee.posX;
+	const float dz = collider.posZ - collidee.posZ;
+
+	if ((dx * dx + dz * dz) >= Square(collider.reach + collidee.extent))
+		return;
+
+	pairs.emplace_back(collider.unit->id, collidee.unit);
+}
+
+bool CUnitCollisionBroadphase::GetCandidates(const CUnit* collider, CUnit* const*& beg, CUnit* const*& end) const
+{
+	if (size_t(collider->id) >= ranges.size())
+		return false;
+
+	const CandidateRange& r = ranges[collider->id];
+
+	if (r.frame != builtFrame || r.unit != collider)
+		return false;
+
+	beg = candidates.data() + r.beg;
+	end = candidates.data() + r.end;
+	return true;
+}
@@ -0,0 +1,67 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_COLLISION_BROADPHASE_H
+#define UNIT_COLLISION_BROADPHASE_H
+
+#include <vector>
+
+class CUnit;
+
+/**
+ * Sweep-and-prune broadphase for ground-unit collisions. Built lazily once per
+ * frame from the active units, it replaces the per-collider QuadField queries
+ * in CGroundMoveType::HandleUnitCollisions with a single sort along the x-axis.
+ *
+ * Intervals are padded by each unit's speed since positions change while the
+ * movetypes are updated, so the candidate lists are a conservative superset of
+ * what GetUnitsExact would return at query time; callers must still apply the
+ * exact distance test. Candidates are ordered by unit id.
+ */
+class CUnitCollisionBroadphase {
+public:
+	void Build(const std::vector<CUnit*>& units, int frameNum);
+	void Kill();
+
+	bool IsBuilt(int frameNum) const { return (builtFrame == frameNum); }
+
+	/**
+	 * @return false if collider was not indexed in the current build (e.g.
+	 *   because it was created after it), true otherwise with [beg, end)
+	 *   covering all units whose padded circle overlaps collider's reach
+	 */
+	bool GetCandidates(const CUnit* collider, CUnit* const*& beg, CUnit* const*& end) const;
+
+private:
+	struct Entry {
+		float minX;
+		float maxX;
+		float posX;
+		float posZ;
+		float reach;  // radius searched by the unit as collider, 0 if it never collides actively
+		float extent; // radius the unit occupies as collidee
+		CUnit* unit;
+	};
+
+	struct CandidateRange {
+		const CUnit* unit = nullptr;
+
+		unsigned int beg = 0;
+		unsigned int end = 0;
+		int frame = -1;
+	};
+
+	void AddPair(const Entry& collider, const Entry& collidee);
+
+private:
+	std::vector<Entry> entries;
+	std::vector<unsigned int> active;
+
+	// (collider id, collidee) pairs; sorted and compacted into candidates
+	std::vector< std::pair<int, CUnit*> > pairs;
+	std::vector<CUnit*> candidates;
+	std::vector<CandidateRange> ranges;
+
+	int builtFrame = -1;
+};
+
+#endif
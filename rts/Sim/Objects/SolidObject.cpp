@@ -121,7 +121,7 @@ void CSolidObject::UpdatePhysicalState(float eps)
 	ps |= (PSTATE_BIT_INAIR       * ((    ps   & MASK_NOAIR) ==    0));
 	#undef MASK_NOAIR
 
-	physicalState = static_cast<PhysicalState>(ps);
+	SetPhysicalState(ps);
 
 	// verify mutex relations (A != B); if one
 	// fails then A and B *must* both be false
@@ -127,12 +127,30 @@ public:
 
 	virtual void UpdatePhysicalState(float eps);
 
+	// refreshes the SoA mirror (if any) of pos, radius, speed, allyteam and
+	// physicalState; called by every setter below that touches those fields
+	virtual void UpdateHotState() {}
+
+	void SetVelocity(const float3& v) override { CWorldObject::SetVelocity(v); UpdateHotState(); }
+	void SetVelocityAndSpeed(const float3& v) override { CWorldObject::SetVelocityAndSpeed(v); UpdateHotState(); }
+
+	float SetSpeed(const float3& v) {
+		const float s = CWorldObject::SetSpeed(v);
+		UpdateHotState();
+		return s;
+	}
+
+	void SetRadiusAndHeight(float r, float h) { CWorldObject::SetRadiusAndHeight(r, h); UpdateHotState(); }
+	void SetRadiusAndHeight(const S3DModel* model) { CWorldObject::SetRadiusAndHeight(model); UpdateHotState(); }
+
 	void Move(const float3& v, bool relative) {
 		const float3& dv = relative? v: (v - pos);
 
 		pos += dv;
 		midPos += dv;
 		aimPos += dv;
+
+		UpdateHotState();
 	}
 
 	// this should be called whenever the direction
@@ -267,8 +285,8 @@ public:
 	bool IsBlocking() const { return (HasPhysicalStateBit(PSTATE_BIT_BLOCKING)); }
 
 	bool    HasPhysicalStateBit(unsigned int bit) const { return ((physicalState & bit) != 0); }
-	void    SetPhysicalStateBit(unsigned int bit) { unsigned int ps = physicalState; ps |= ( bit); physicalState = static_cast<PhysicalState>(ps); }
-	void  ClearPhysicalStateBit(unsigned int bit) { unsigned int ps = physicalState; ps &= (~bit); physicalState = static_cast<PhysicalState>(ps); }
+	void    SetPhysicalStateBit(unsigned int bit) { unsigned int ps = physicalState; ps |= ( bit); SetPhysicalState(ps); }
+	void  ClearPhysicalStateBit(unsigned int bit) { unsigned int ps = physicalState; ps &= (~bit); SetPhysicalState(ps); }
 	void   PushPhysicalStateBit(unsigned int bit) { UpdatePhysicalStateBit(1u << (32u - bits_ffs(bit)), HasPhysicalStateBit(bit)); }
 	void    PopPhysicalStateBit(unsigned int bit) { UpdatePhysicalStateBit(bit, HasPhysicalStateBit(1u << (32u - bits_ffs(bit)))); }
 	bool UpdatePhysicalStateBit(unsigned int bit, bool set) {
@@ -294,6 +312,14 @@ public:
 		return (HasCollidableStateBit(bit));
 	}
 
+	void SetPhysicalState(unsigned int ps) {
+		if (ps == physicalState)
+			return;
+
+		physicalState = static_cast<PhysicalState>(ps);
+		UpdateHotState();
+	}
+
 	bool SetVoidState();
 	bool ClearVoidState();
 	void UpdateVoidState(bool set);
@@ -25,8 +25,10 @@ namespace QTPFS {
 	struct INode {
 	public:
 		void SetNodeNumber(unsigned int n) { nodeNumber = n; }
+		void SetNodeIndex(unsigned int n) { nodeIndex = n; }
 		void SetHeapIndex(unsigned int n) { heapIndex = n; }
 		unsigned int GetNodeNumber() const { return nodeNumber; }
+		unsigned int GetNodeIndex() const { return nodeIndex; }
 		unsigned int GetHeapIndex() const { return heapIndex; }
 		float GetHeapPriority() const { return GetPathCost(NODE_PATH_COST_F); }
 
@@ -90,6 +92,9 @@ namespace QTPFS {
 		//     storing the heap-index is an *UGLY* break of abstraction,
 		//     but the only way to keep the cost of resorting acceptable
 		unsigned int nodeNumber = -1u;
+		// dense per-layer index (root is 0, pool nodes follow) used
+		// by searches to address their private copy of node state
+		unsigned int nodeIndex = -1u;
 		unsigned int heapIndex = -1u;
 
 		float fCost = 0.0f;
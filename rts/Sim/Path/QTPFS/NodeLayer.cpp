@@ -37,6 +37,7 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 
 	// pre-count the root
 	numLeafNodes = 1;
+	maxNodeIndex = 0;
 	layerNumber = layerNum;
 
 	xsize = mapDims.mapx;
@@ -3,6 +3,7 @@
 #ifndef QTPFS_NODELAYER_HDR
 #define QTPFS_NODELAYER_HDR
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <deque>
@@ -76,6 +77,7 @@ namespace QTPFS {
 
 		INode* AllocRootNode(const INode* parent, unsigned int nn,  unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2) {
 			rootNode.Init(parent, nn, x1, z1, x2, z2);
+			rootNode.SetNodeIndex(0);
 			return &rootNode;
 		}
 
@@ -89,8 +91,11 @@ namespace QTPFS {
 				poolNodes[idx / POOL_CHUNK_SIZE].resize(POOL_CHUNK_SIZE);
 
 			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].Init(parent, nn, x1, z1, x2, z2);
+			poolNodes[idx / POOL_CHUNK_SIZE][idx % POOL_CHUNK_SIZE].SetNodeIndex(idx + 1);
 			nodeIndcs.pop_back();
 
+			maxNodeIndex = std::max(maxNodeIndex, idx + 1);
+
 			return idx;
 		}
 
@@ -106,6 +111,9 @@ namespace QTPFS {
 
 		void RegisterNode(INode* n);
 
+		// upper bound (inclusive) of INode::GetNodeIndex over all allocated nodes
+		unsigned int GetMaxNodeIndex() const { return maxNodeIndex; }
+
 		void SetNumLeafNodes(unsigned int n) { numLeafNodes = n; }
 		unsigned int GetNumLeafNodes() const { return numLeafNodes; }
 
@@ -161,6 +169,7 @@ namespace QTPFS {
 
 		unsigned int layerNumber = 0;
 		unsigned int numLeafNodes = 0;
+		unsigned int maxNodeIndex = 0;
 		unsigned int updateCounter = 0;
 
 		unsigned int xsize = 0;
@@ -148,7 +148,9 @@ QTPFS::PathManager::~PathManager() {
 	numCurrExecutedSearches.clear();
 	numPrevExecutedSearches.clear();
 
-	PathSearch::FreeGlobalQueue();
+	for (SearchThreadData& threadData: searchThreadData) {
+		threadData.Kill();
+	}
 
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	// at this point the thread is waiting, so notify it
@@ -185,8 +187,6 @@ void QTPFS::PathManager::InitStatic() {
 }
 
 void QTPFS::PathManager::Load() {
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -247,7 +247,12 @@ void QTPFS::PathManager::Load() {
 
 		{ SyncedUint tmp(pfsCheckSum); }
 
-		PathSearch::InitGlobalQueue(maxNumLeafNodes);
+		// one set of search scratch-buffers per pool thread
+		searchThreadData.resize(ThreadPool::GetMaxThreads());
+
+		for (SearchThreadData& threadData: searchThreadData) {
+			threadData.Init(maxNumLeafNodes);
+		}
 	}
 
 	{
@@ -752,43 +757,44 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	PathCache& pathCache = pathCaches[pathType];
 
 	std::vector<IPathSearch*>& searches = pathSearches[pathType];
-	std::vector<IPathSearch*>::iterator searchesIt = searches.begin();
-
-	if (!searches.empty()) {
-		// execute pending searches collected via
-		// RequestPath and QueueDeadPathSearches
-		while (searchesIt != searches.end()) {
-			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
-			}
-		}
+
+	if (searches.empty())
+		return;
+
+	// execute pending searches collected via RequestPath and
+	// QueueDeadPathSearches in request order; they are handed
+	// to ExecuteSearchBatch in groups whose members can neither
+	// share each other's result nor otherwise interact
+	keptSearches.clear();
+
+	for (IPathSearch* search: searches) {
+		if (!DispatchSearch(search, nodeLayer, pathCache, pathType))
+			continue;
+
+		keptSearches.push_back(search);
 	}
+
+	ExecuteSearchBatch(pathCache);
+
+	searches.swap(keptSearches);
 }
 
-bool QTPFS::PathManager::ExecuteSearch(
-	PathSearchVect& searches,
-	PathSearchVectIt& searchesIt,
+// returns true iff the search has to stay queued
+bool QTPFS::PathManager::DispatchSearch(
+	IPathSearch* search,
 	NodeLayer& nodeLayer,
 	PathCache& pathCache,
 	unsigned int pathType
 ) {
-	IPathSearch* search = *searchesIt;
 	IPath* path = pathCache.GetTempPath(search->GetID());
 
 	assert(search != nullptr);
 	assert(path != nullptr);
 
-	const auto DeleteSearch = [](IPathSearch* s, PathSearchVect& v, PathSearchVectIt& it) {
-		// ordering of still-queued searches is not relevant
-		*it = v.back();
-		v.pop_back();
-		delete s;
-	};
-
 	// temp-path might have been removed already via
 	// DeletePath before we got a chance to process it
 	if (path->GetID() == 0) {
-		DeleteSearch(search, searches, searchesIt);
+		delete search;
 		return false;
 	}
 
@@ -800,11 +806,16 @@ bool QTPFS::PathManager::ExecuteSearch(
 
 	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
+		// an earlier search in the pending batch might produce a path
+		// this one can copy, so the batch has to be completed first
+		if (searchBatchHashes.find(path->GetHash()) != searchBatchHashes.end())
+			ExecuteSearchBatch(pathCache);
+
 		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
 
 		if (sharedPathsIt != sharedPaths.end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
-				DeleteSearch(search, searches, searchesIt);
+				delete search;
 				return false;
 			}
 		}
@@ -814,31 +825,72 @@ bool QTPFS::PathManager::ExecuteSearch(
 		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
 		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
 
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
-			++searchesIt; return false;
-		}
+		// keep queued for a later update
+		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES)
+			return true;
 
 		numCurrExecutedSearches[search->GetTeam()] += 1;
 		#endif
 	}
 
-	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	searchBatch.emplace_back(search, path);
+	searchBatchHashes.insert(path->GetHash());
+	return false;
+}
+
+void QTPFS::PathManager::ExecuteSearchBatch(PathCache& pathCache) {
+	if (searchBatch.empty())
+		return;
+
+	const auto ExecuteSearch = [&](const int i) {
+		IPathSearch* search = searchBatch[i].first;
+		IPath* path = searchBatch[i].second;
+
+		if (!search->Execute(searchThreadData[ThreadPool::GetThreadNum()], numTerrainChanges)) {
+			searchBatch[i].second = nullptr;
+			return;
+		}
+
 		search->Finalize(path);
+	};
 
-		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
-		#endif
+	#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
+	// searches only read the layer and write to their own path, node
+	// state lives in the per-thread SearchThreadData
+	for_mt(0, searchBatch.size(), ExecuteSearch);
+	#else
+	// neighbor-caches are lazily updated (written) during searches
+	for (size_t i = 0; i < searchBatch.size(); i++) {
+		ExecuteSearch(i);
+	}
+	#endif
 
-		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
-		#endif
-	} else {
-		DeletePath(path->GetID());
+	// commit in request order, independent of which thread ran what
+	for (const auto& p: searchBatch) {
+		IPathSearch* search = p.first;
+		IPath* path = p.second;
+
+		if (path != nullptr) {
+			// removes path from temp-paths, adds it to live-paths
+			// path remains in live-cache until DeletePath is called
+			pathCache.AddLivePath(path);
+
+			#ifdef QTPFS_SEARCH_SHARED_PATHS
+			sharedPaths[path->GetHash()] = path;
+			#endif
+
+			#ifdef QTPFS_TRACE_PATH_SEARCHES
+			pathTraces[path->GetID()] = search->GetExecutionTrace();
+			#endif
+		} else {
+			DeletePath(search->GetID());
+		}
+
+		delete search;
 	}
 
-	DeleteSearch(search, searches, searchesIt);
-	return true;
+	searchBatch.clear();
+	searchBatchHashes.clear();
 }
 
 void QTPFS::PathManager::QueueDeadPathSearches(unsigned int pathType) {
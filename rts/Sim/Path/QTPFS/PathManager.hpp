@@ -10,6 +10,7 @@
 #include "PathCache.hpp"
 #include "PathSearch.hpp"
 #include "System/UnorderedMap.hpp"
+#include "System/UnorderedSet.hpp"
 
 struct MoveDef;
 struct SRectangle;
@@ -134,13 +135,13 @@ namespace QTPFS {
 			const bool synced
 		);
 
-		bool ExecuteSearch(
-			PathSearchVect& searches,
-			PathSearchVectIt& searchesIt,
+		bool DispatchSearch(
+			IPathSearch* search,
 			NodeLayer& nodeLayer,
 			PathCache& pathCache,
 			unsigned int pathType
 		);
+		void ExecuteSearchBatch(PathCache& pathCache);
 
 		bool IsFinalized() const { return (!nodeTrees.empty()); }
 
@@ -159,13 +160,21 @@ namespace QTPFS {
 		// maps "hashes" of executed searches to the found paths
 		spring::unordered_map<std::uint64_t, IPath*> sharedPaths;
 
+		// searches (and their temp-paths) to be executed concurrently
+		std::vector< std::pair<IPathSearch*, IPath*> > searchBatch;
+		spring::unordered_set<std::uint64_t> searchBatchHashes;
+		// searches that remain queued after ExecuteQueuedSearches
+		std::vector<IPathSearch*> keptSearches;
+
+		// per-thread search scratch-buffers, indexed by ThreadPool::GetThreadNum
+		std::vector<SearchThreadData> searchThreadData;
+
 		std::vector<unsigned int> numCurrExecutedSearches;
 		std::vector<unsigned int> numPrevExecutedSearches;
 
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -15,9 +15,6 @@
 
 #include "System/float3.h"
 
-QTPFS::binary_heap<QTPFS::INode*> QTPFS::PathSearch::openNodes;
-
-
 
 void QTPFS::PathSearch::Initialize(
 	NodeLayer* layer,
@@ -33,6 +30,7 @@ void QTPFS::PathSearch::Initialize(
 	pathCache = cache;
 
 	searchRect = searchArea;
+	searchData = nullptr;
 	searchExec = nullptr;
 
 	srcNode = nodeLayer->GetNode(srcPoint.x / SQUARE_SIZE, srcPoint.z / SQUARE_SIZE);
@@ -43,12 +41,20 @@ void QTPFS::PathSearch::Initialize(
 }
 
 bool QTPFS::PathSearch::Execute(
-	unsigned int searchStateOffset,
+	SearchThreadData& threadData,
 	unsigned int searchMagicNumber
 ) {
-	searchState = searchStateOffset; // starts at NODE_STATE_OFFSET
+	// NOTE: offset *must* start at a non-zero value
+	searchData  = &threadData;
+	searchState = (threadData.searchState += NODE_STATE_OFFSET);
 	searchMagic = searchMagicNumber; // starts at numTerrainChanges
 
+	// node-indices are stable until the layer is re-tesselated, which
+	// never happens while searches are running; entries added here are
+	// default-initialized with a searchState older than any search's
+	if (threadData.searchNodes.size() <= nodeLayer->GetMaxNodeIndex())
+		threadData.searchNodes.resize(nodeLayer->GetMaxNodeIndex() + 1);
+
 	haveFullPath = (srcNode == tgtNode);
 	havePartPath = false;
 
@@ -75,8 +81,9 @@ bool QTPFS::PathSearch::Execute(
 	// nodes can represent many terrain squares, some of which can still
 	// be passable and allow a unit to move within a node)
 	// NOTE: we need to make sure such paths do not have infinite cost!
-	if (srcNode->GetMoveCost() == QTPFS_POSITIVE_INFINITY)
-		srcNode->SetMoveCost(0.0f);
+	srcNodeImpassable = (srcNode->GetMoveCost() == QTPFS_POSITIVE_INFINITY);
+
+	binary_heap<SearchNode*>& openNodes = threadData.openNodes;
 
 	ResetState(srcNode);
 	UpdateNode(srcNode, nullptr, 0);
@@ -96,10 +103,6 @@ bool QTPFS::PathSearch::Execute(
 			openNodes.reset();
 	}
 
-	if (srcNode->GetMoveCost() == 0.0f)
-		srcNode->SetMoveCost(QTPFS_POSITIVE_INFINITY);
-
-
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// adjust the target-point if we only got a partial result
 	// NOTE:
@@ -136,8 +139,8 @@ void QTPFS::PathSearch::ResetState(INode* node) {
 		hCosts[i] = 0.0f;
 	}
 
-	openNodes.reset();
-	openNodes.push(node);
+	searchData->openNodes.reset();
+	searchData->openNodes.push(&GetSearchNode(node));
 }
 
 void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx) {
@@ -146,15 +149,23 @@ void QTPFS::PathSearch::UpdateNode(INode* nextNode, INode* prevNode, unsigned in
 	//   but this is *impossible* to achieve on a non-regular
 	//   grid on which any node only has an average move-cost
 	//   associated with it --> paths will be "nearly optimal"
-	nextNode->SetPrevNode(prevNode);
-	nextNode->SetPathCosts(gCosts[netPointIdx], hCosts[netPointIdx]);
-	nextNode->SetSearchState(searchState | NODE_STATE_OPEN);
-	nextNode->SetNeighborEdgeTransitionPoint(0, netPoints[netPointIdx]);
+	SearchNode& nextSearchNode = GetSearchNode(nextNode);
+
+	nextSearchNode.node = nextNode;
+	nextSearchNode.prevNode = prevNode;
+	nextSearchNode.fCost = gCosts[netPointIdx] + hCosts[netPointIdx];
+	nextSearchNode.gCost = gCosts[netPointIdx];
+	nextSearchNode.hCost = hCosts[netPointIdx];
+	nextSearchNode.searchState = searchState | NODE_STATE_OPEN;
+	nextSearchNode.netPoint = netPoints[netPointIdx];
 }
 
 void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
-	curNode = openNodes.top();
-	curNode->SetSearchState(searchState | NODE_STATE_CLOSED);
+	binary_heap<SearchNode*>& openNodes = searchData->openNodes;
+	SearchNode* curSearchNode = openNodes.top();
+
+	curNode = curSearchNode->node;
+	curSearchNode->searchState = searchState | NODE_STATE_CLOSED;
 	#ifdef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
 	// in the non-conservative case, this is done from
 	// NodeLayer::ExecNodeNeighborCacheUpdates instead
@@ -170,7 +181,7 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	if (curNode == tgtNode)
 		return;
-	if (curNode->AllSquaresImpassable())
+	if (IsNodeImpassable(curNode))
 		return;
 
 	if (curNode->xmid() < searchRect.x1) return;
@@ -180,7 +191,7 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 
 	#ifdef QTPFS_SUPPORT_PARTIAL_SEARCHES
 	// remember the node with lowest h-cost in case the search fails to reach tgtNode
-	if (curNode->GetPathCost(NODE_PATH_COST_H) < minNode->GetPathCost(NODE_PATH_COST_H))
+	if (curSearchNode->hCost < GetSearchNode(minNode).hCost)
 		minNode = curNode;
 	#endif
 
@@ -188,9 +199,13 @@ void QTPFS::PathSearch::IterateNodes(const std::vector<INode*>& allNodes) {
 }
 
 void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes) {
+	binary_heap<SearchNode*>& openNodes = searchData->openNodes;
+	const SearchNode& curSearchNode = GetSearchNode(curNode);
+
 	// if curNode equals srcNode, this is just the original srcPoint
-	const float2& curPoint2 = curNode->GetNeighborEdgeTransitionPoint(0);
+	const float2& curPoint2 = curSearchNode.netPoint;
 	const float3  curPoint  = {curPoint2.x, 0.0f, curPoint2.y};
+	const float   curCost   = GetNodeMoveCost(curNode);
 
 	for (unsigned int i = 0; i < nxtNodes.size(); i++) {
 		// NOTE:
@@ -212,12 +227,15 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		//   nightmare)
 		nxtNode = nxtNodes[i];
 
-		if (nxtNode->AllSquaresImpassable())
+		if (IsNodeImpassable(nxtNode))
 			continue;
 
-		const bool isCurrent = (nxtNode->GetSearchState() >= searchState);
-		const bool isClosed = ((nxtNode->GetSearchState() & 1) == NODE_STATE_CLOSED);
+		SearchNode& nxtSearchNode = GetSearchNode(nxtNode);
+
+		const bool isCurrent = (nxtSearchNode.searchState >= searchState);
+		const bool isClosed = ((nxtSearchNode.searchState & 1) == NODE_STATE_CLOSED);
 		const bool isTarget = (nxtNode == tgtNode);
+		const float nxtCost = GetNodeMoveCost(nxtNode);
 
 		unsigned int netPointIdx = 0;
 
@@ -235,9 +253,9 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 			gDists[0] = curPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			hDists[0] = tgtPoint.distance({netPoints[0].x, 0.0f, netPoints[0].y});
 			gCosts[0] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[0] +
-				nxtNode->GetMoveCost() * hDists[0] * int(isTarget);
+				curSearchNode.gCost +
+				curCost * gDists[0] +
+				nxtCost * hDists[0] * int(isTarget);
 			hCosts[0] = hDists[0] * hCostMult * int(!isTarget);
 		}
 		#else
@@ -253,9 +271,9 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 			gDists[j] = curPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			hDists[j] = tgtPoint.distance({netPoints[j].x, 0.0f, netPoints[j].y});
 			gCosts[j] =
-				curNode->GetPathCost(NODE_PATH_COST_G) +
-				curNode->GetMoveCost() * gDists[j] +
-				nxtNode->GetMoveCost() * hDists[j] * int(isTarget);
+				curSearchNode.gCost +
+				curCost * gDists[j] +
+				nxtCost * hDists[j] * int(isTarget);
 			hCosts[j] = hDists[j] * hCostMult * int(!isTarget);
 
 			if ((gCosts[j] + hCosts[j]) < (gCosts[netPointIdx] + hCosts[netPointIdx])) {
@@ -267,7 +285,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		if (!isCurrent) {
 			UpdateNode(nxtNode, curNode, netPointIdx);
 
-			openNodes.push(nxtNode);
+			openNodes.push(&nxtSearchNode);
 			openNodes.check_heap_property(0);
 
 			#ifdef QTPFS_TRACE_PATH_SEARCHES
@@ -276,10 +294,10 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 
 			continue;
 		}
-		if (gCosts[netPointIdx] >= nxtNode->GetPathCost(NODE_PATH_COST_G))
+		if (gCosts[netPointIdx] >= nxtSearchNode.gCost)
 			continue;
 		if (isClosed)
-			openNodes.push(nxtNode);
+			openNodes.push(&nxtSearchNode);
 
 		UpdateNode(nxtNode, curNode, netPointIdx);
 
@@ -287,7 +305,7 @@ void QTPFS::PathSearch::IterateNodeNeighbors(const std::vector<INode*>& nxtNodes
 		// (changing the f-cost of an OPEN node messes up the
 		// queue's internal consistency; a pushed node remains
 		// OPEN until it gets popped)
-		openNodes.resort(nxtNode);
+		openNodes.resort(&nxtSearchNode);
 		openNodes.check_heap_property(0);
 	}
 }
@@ -301,8 +319,8 @@ void QTPFS::PathSearch::Finalize(IPath* path) {
 
 	path->SetBoundingBox();
 
-	// path remains in live-cache until DeletePath is called
-	pathCache->AddLivePath(path);
+	// not needed anymore, can be re-used by the next search on this thread
+	searchData = nullptr;
 }
 
 void QTPFS::PathSearch::TracePath(IPath* path) {
@@ -311,12 +329,12 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 
 	if (srcNode != tgtNode) {
 		INode* tmpNode = tgtNode;
-		INode* prvNode = tmpNode->GetPrevNode();
+		INode* prvNode = GetSearchNode(tmpNode).prevNode;
 
 		float3 prvPoint = tgtPoint;
 
 		while ((prvNode != nullptr) && (tmpNode != srcNode)) {
-			const float2& tmpPoint2 = tmpNode->GetNeighborEdgeTransitionPoint(0);
+			const float2& tmpPoint2 = GetSearchNode(tmpNode).netPoint;
 			const float3  tmpPoint  = {tmpPoint2.x, 0.0f, tmpPoint2.y};
 
 			assert(!math::isinf(tmpPoint.x) && !math::isinf(tmpPoint.z));
@@ -331,16 +349,9 @@ void QTPFS::PathSearch::TracePath(IPath* path) {
 			if (tmpPoint != prvPoint)
 				points.push_front(tmpPoint);
 
-			#ifndef QTPFS_SMOOTH_PATHS
-			// make sure the back-pointers can never become dangling
-			// (if smoothing IS enabled, we delay this until we reach
-			// SmoothPath() because we still need them there)
-			tmpNode->SetPrevNode(nullptr);
-			#endif
-
 			prvPoint = tmpPoint;
 			tmpNode = prvNode;
-			prvNode = tmpNode->GetPrevNode();
+			prvNode = GetSearchNode(tmpNode).prevNode;
 		}
 	}
 
@@ -366,7 +377,7 @@ void QTPFS::PathSearch::SmoothPath(IPath* path) const {
 	if (path->NumPoints() == 2)
 		return;
 
-	assert(srcNode->GetPrevNode() == NULL);
+	assert(GetSearchNode(srcNode).prevNode == nullptr);
 
 	for (unsigned int k = 0; k < QTPFS_MAX_SMOOTHING_ITERATIONS; k++) {
 		if (!SmoothPathIter(path)) {
@@ -374,17 +385,6 @@ void QTPFS::PathSearch::SmoothPath(IPath* path) const {
 			break;
 		}
 	}
-
-	INode* n0 = tgtNode;
-	INode* n1 = tgtNode;
-
-	while (n1 != srcNode) {
-		n0 = n1;
-		n1 = n0->GetPrevNode();
-
-		// reset back-pointers
-		n0->SetPrevNode(NULL);
-	}
 }
 
 bool QTPFS::PathSearch::SmoothPathIter(IPath* path) const {
@@ -400,7 +400,7 @@ bool QTPFS::PathSearch::SmoothPathIter(IPath* path) const {
 
 	while (n1 != srcNode) {
 		n0 = n1;
-		n1 = n0->GetPrevNode();
+		n1 = GetSearchNode(n0).prevNode;
 		ni -= 1;
 
 		assert(n1->GetNeighborRelation(n0) != 0);
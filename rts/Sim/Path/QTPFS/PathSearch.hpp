@@ -16,6 +16,58 @@ namespace QTPFS {
 	struct NodeLayer;
 	struct IPath;
 
+	// private copy of the node fields written during a search; lets
+	// multiple searches run concurrently over the same NodeLayer since
+	// the layer itself is only read
+	struct SearchNode {
+		void SetHeapIndex(unsigned int n) { heapIndex = n; }
+		unsigned int GetHeapIndex() const { return heapIndex; }
+		float GetHeapPriority() const { return fCost; }
+
+		bool operator <  (const SearchNode* n) const { return (fCost <  n->fCost); }
+		bool operator >  (const SearchNode* n) const { return (fCost >  n->fCost); }
+		bool operator == (const SearchNode* n) const { return (fCost == n->fCost); }
+		bool operator <= (const SearchNode* n) const { return (fCost <= n->fCost); }
+		bool operator >= (const SearchNode* n) const { return (fCost >= n->fCost); }
+
+		INode* node = nullptr;
+		// points back to previous node in path
+		INode* prevNode = nullptr;
+
+		// transition-point on the edge shared with prevNode
+		float2 netPoint;
+
+		float fCost = 0.0f;
+		float gCost = 0.0f;
+		float hCost = 0.0f;
+
+		unsigned int heapIndex = -1u;
+		unsigned int searchState = 0;
+	};
+
+	// scratch memory owned by one thread, re-used by all searches it runs
+	struct SearchThreadData {
+		void Init(unsigned int maxOpenNodes) {
+			openNodes.reserve(maxOpenNodes);
+			searchNodes.clear();
+			searchState = 0;
+		}
+		void Kill() {
+			openNodes.clear();
+			searchNodes.clear();
+		}
+
+		// allocated once, re-used without clear()'s; relies on
+		// SearchNode::operator< to sort by increasing f-cost
+		binary_heap<SearchNode*> openNodes;
+		// indexed by INode::GetNodeIndex, grown on demand
+		std::vector<SearchNode> searchNodes;
+
+		// offset that identifies nodes as part of the current search
+		unsigned int searchState = 0;
+	};
+
+
 	namespace PathSearchTrace {
 		struct Iteration {
 			Iteration() { nodeIndices.push_back(-1u); }
@@ -67,7 +119,7 @@ namespace QTPFS {
 
 	// NOTE:
 	//     we could support "time-sliced" execution, but we would have
-	//     to isolate each query from modifying another's INode members
+	//     to isolate each query from modifying another's SearchNode's
 	//     (*Cost, nodeState, etc.) --> memory-intensive
 	//     also, terrain changes could invalidate partial paths without
 	//     buffering the *entire* heightmap each frame --> not efficient
@@ -91,8 +143,11 @@ namespace QTPFS {
 			const float3& targetPoint,
 			const SRectangle& searchArea
 		) = 0;
+		// Execute and Finalize may run on any thread (but must be called
+		// back-to-back on the same one); Finalize only fills in the path,
+		// the caller moves it into the live-cache
 		virtual bool Execute(
-			unsigned int searchStateOffset = 0,
+			SearchThreadData& threadData,
 			unsigned int searchMagicNumber = 0
 		) = 0;
 		virtual void Finalize(IPath* path) = 0;
@@ -122,6 +177,7 @@ namespace QTPFS {
 			: IPathSearch(pathSearchType)
 			, nodeLayer(NULL)
 			, pathCache(NULL)
+			, searchData(NULL)
 			, searchExec(NULL)
 			, srcNode(NULL)
 			, tgtNode(NULL)
@@ -131,8 +187,9 @@ namespace QTPFS {
 			, hCostMult(0.0f)
 			, haveFullPath(false)
 			, havePartPath(false)
+			, srcNodeImpassable(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
+		~PathSearch() {}
 
 		void Initialize(
 			NodeLayer* layer,
@@ -142,7 +199,7 @@ namespace QTPFS {
 			const SRectangle& searchArea
 		);
 		bool Execute(
-			unsigned int searchStateOffset = 0,
+			SearchThreadData& threadData,
 			unsigned int searchMagicNumber = 0
 		);
 		void Finalize(IPath* path);
@@ -151,10 +208,20 @@ namespace QTPFS {
 
 		const std::uint64_t GetHash(std::uint64_t N, std::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
-
 	private:
+		      SearchNode& GetSearchNode(const INode* node)       { return searchData->searchNodes[node->GetNodeIndex()]; }
+		const SearchNode& GetSearchNode(const INode* node) const { return searchData->searchNodes[node->GetNodeIndex()]; }
+
+		// a search may start from an impassable node (because single
+		// nodes can represent many terrain squares, some of which can
+		// still be passable); it is then treated as zero-cost instead
+		float GetNodeMoveCost(const INode* node) const {
+			return ((node == srcNode && srcNodeImpassable)? 0.0f: node->GetMoveCost());
+		}
+		bool IsNodeImpassable(const INode* node) const {
+			return (GetNodeMoveCost(node) == QTPFS_POSITIVE_INFINITY);
+		}
+
 		void ResetState(INode* node);
 		void UpdateNode(INode* nextNode, INode* prevNode, unsigned int netPointIdx);
 
@@ -165,13 +232,12 @@ namespace QTPFS {
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
-		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
-
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
 
+		// set by Execute, valid until Finalize returns
+		SearchThreadData* searchData;
+
 		// not used unless QTPFS_TRACE_PATH_SEARCHES is defined
 		PathSearchTrace::Execution* searchExec;
 		PathSearchTrace::Iteration searchIter;
@@ -196,6 +262,7 @@ namespace QTPFS {
 
 		bool haveFullPath;
 		bool havePartPath;
+		bool srcNodeImpassable;
 	};
 }
 
@@ -57,7 +57,8 @@ CR_REG_METADATA(CProjectileHandler, (
 	CR_MEMBER_UN(frameProjectileCounts),
 
 	CR_MEMBER(freeProjectileIDs),
-	CR_MEMBER(projectileMaps)
+	CR_MEMBER(projectileMaps),
+	CR_IGNORED(collisionCandidates)
 ))
 
 
@@ -483,20 +484,37 @@ static bool CheckProjectileCollisionFlags(const CProjectile* p, const CUnit* u)
 }
 
 
-void CProjectileHandler::CheckUnitCollisions(
+bool CProjectileHandler::CheckUnitCollisions(
 	CProjectile* p,
 	std::vector<CUnit*>& tempUnits,
 	const float3 ppos0,
 	const float3 ppos1
 ) {
 	if (!p->checkCol)
-		return;
+		return false;
+
+	static CollisionSphereBatch colSpheres;
 
 	CollisionQuery cq;
 
-	for (CUnit* unit: tempUnits) {
+	colSpheres.Clear();
+
+	for (const CUnit* unit: tempUnits) {
+		colSpheres.Add(unit, &unit->collisionVolume);
+	}
+
+	if (CCollisionHandler::CullSegmentHits(colSpheres, ppos0, ppos1) == 0)
+		return false;
+
+	for (size_t i = 0; i < tempUnits.size(); i++) {
+		CUnit* unit = tempUnits[i];
+
 		assert(unit != nullptr);
 
+		// segment misses the volume's bounding sphere, DetectHit would fail
+		if (!colSpheres.IsCandidate(i))
+			continue;
+
 		// if this unit fired this projectile, always ignore
 		if (unit == p->owner())
 			continue;
@@ -518,12 +536,14 @@ void CProjectileHandler::CheckUnitCollisions(
 				p->Collision(unit);
 			}
 
-			break;
+			return true;
 		}
 	}
+
+	return false;
 }
 
-void CProjectileHandler::CheckFeatureCollisions(
+bool CProjectileHandler::CheckFeatureCollisions(
 	CProjectile* p,
 	std::vector<CFeature*>& tempFeatures,
 	const float3 ppos0,
@@ -531,16 +551,32 @@ void CProjectileHandler::CheckFeatureCollisions(
 ) {
 	// already collided with unit?
 	if (!p->checkCol)
-		return;
+		return false;
 
 	if ((p->GetCollisionFlags() & Collision::NOFEATURES) != 0)
-		return;
+		return false;
+
+	static CollisionSphereBatch colSpheres;
 
 	CollisionQuery cq;
 
-	for (CFeature* feature: tempFeatures) {
+	colSpheres.Clear();
+
+	for (const CFeature* feature: tempFeatures) {
+		colSpheres.Add(feature, &feature->collisionVolume);
+	}
+
+	if (CCollisionHandler::CullSegmentHits(colSpheres, ppos0, ppos1) == 0)
+		return false;
+
+	for (size_t i = 0; i < tempFeatures.size(); i++) {
+		CFeature* feature = tempFeatures[i];
+
 		assert(feature != nullptr);
 
+		if (!colSpheres.IsCandidate(i))
+			continue;
+
 		if (!feature->HasCollidableStateBit(CSolidObject::CSTATE_BIT_PROJECTILES))
 			continue;
 
@@ -556,23 +592,25 @@ void CProjectileHandler::CheckFeatureCollisions(
 				p->Collision(feature);
 			}
 
-			break;
+			return true;
 		}
 	}
+
+	return false;
 }
 
 
-void CProjectileHandler::CheckShieldCollisions(
+bool CProjectileHandler::CheckShieldCollisions(
 	CProjectile* p,
 	std::vector<CPlasmaRepulser*>& tempRepulsers,
 	const float3 ppos0,
 	const float3 ppos1
 ) {
 	if (!p->checkCol)
-		return;
+		return false;
 	// skip unsynced and non-weapon projectiles
 	if (!p->weapon)
-		return;
+		return false;
 
 	CWeaponProjectile* wpro = static_cast<CWeaponProjectile*>(p);
 	const WeaponDef* wdef = wpro->GetWeaponDef();
@@ -582,10 +620,13 @@ void CProjectileHandler::CheckShieldCollisions(
 
 	// bail early
 	if (interceptType == 0)
-		return;
+		return false;
 
 	CollisionQuery cq;
 
+	// IncomingProjectile can run gadget code and change shield state
+	bool handledHit = false;
+
 	for (CPlasmaRepulser* repulser: tempRepulsers) {
 		assert(repulser != nullptr);
 
@@ -610,9 +651,36 @@ void CProjectileHandler::CheckShieldCollisions(
 		if (cq.InsideHit() && repulser->IgnoreInteriorHit(wpro))
 			continue;
 
+		handledHit = true;
+
 		if (repulser->IncomingProjectile(wpro, cq.GetHitPos()))
-			return;
+			return true;
 	}
+
+	return handledHit;
+}
+
+static bool HasColVolsInRange(const CProjectile* p)
+{
+	// mirrors the selection criteria of CQuadField::GetUnitsAndFeaturesColVol
+	const float3& pos = p->pos;
+	const float radius = p->speed.w + p->radius;
+
+	bool inRange = false;
+
+	quadField.VisitQuads(pos, radius, [&](int qi) {
+		const CQuadField::Quad& quad = quadField.GetQuad(qi);
+
+		const auto inRangeFunc = [&](const CollisionVolume& colvol, const float3& colvolPos) {
+			return (pos.SqDistance(colvolPos) < Square(radius + colvol.GetBoundingRadius()));
+		};
+
+		inRange = inRange || std::any_of(quad.units.begin(), quad.units.end(), [&](const CUnit* u) { return (inRangeFunc(u->collisionVolume, u->collisionVolume.GetWorldSpacePos(u))); });
+		inRange = inRange || std::any_of(quad.features.begin(), quad.features.end(), [&](const CFeature* f) { return (inRangeFunc(f->collisionVolume, f->collisionVolume.GetWorldSpacePos(f))); });
+		inRange = inRange || std::any_of(quad.repulsers.begin(), quad.repulsers.end(), [&](const CPlasmaRepulser* r) { return (inRangeFunc(r->collisionVolume, r->weaponMuzzlePos)); });
+	});
+
+	return inRange;
 }
 
 void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
@@ -621,21 +689,45 @@ void CProjectileHandler::CheckUnitFeatureCollisions(ProjectileContainer& pc)
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	// read-only pre-pass: find projectiles that have nothing within reach,
+	// which makes all of their Check*Collisions calls no-ops (as long as no
+	// hit has been handled yet, since those can change the world arbitrarily)
+	{
+		SCOPED_TIMER("Sim::Projectiles::Collisions::PrePass");
+
+		collisionCandidates.clear();
+		collisionCandidates.resize(pc.size(), 1);
+
+		for_mt_chunk(0, pc.size(), [&](int i) {
+			const CProjectile* p = pc[i];
+
+			if (!p->checkCol || p->deleteMe)
+				return;
+
+			collisionCandidates[i] = HasColVolsInRange(p);
+		});
+	}
+
+	bool handledHit = false;
+
 	for (size_t i = 0; i < pc.size(); ++i) {
 		CProjectile* p = pc[i];
 
 		if (!p->checkCol) continue;
 		if ( p->deleteMe) continue;
 
+		if (!handledHit && !collisionCandidates[i])
+			continue;
+
 		const float3 ppos0 = p->pos;
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
 		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
 
-		CheckShieldCollisions(p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
-		CheckUnitCollisions(p, tempUnits, ppos0, ppos1); tempUnits.clear();
-		CheckFeatureCollisions(p, tempFeatures, ppos0, ppos1); tempFeatures.clear();
+		handledHit |= CheckShieldCollisions(p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
+		handledHit |= CheckUnitCollisions(p, tempUnits, ppos0, ppos1); tempUnits.clear();
+		handledHit |= CheckFeatureCollisions(p, tempFeatures, ppos0, ppos1); tempFeatures.clear();
 	}
 }
 
@@ -4,6 +4,7 @@
 #define PROJECTILE_HANDLER_H
 
 #include <array>
+#include <cstdint>
 #include <vector>
 
 #include "Rendering/Models/3DModel.h"
@@ -44,9 +45,10 @@ public:
 		return projectileContainers[synced];
 	}
 
-	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
-	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
-	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
+	// each returns true if a hit was handled (i.e. the world may have changed)
+	bool CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
+	bool CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
+	bool CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
 	void CheckUnitFeatureCollisions(ProjectileContainer&);
 	void CheckGroundCollisions(ProjectileContainer&);
 	void CheckCollisions();
@@ -120,6 +122,9 @@ private:
 	// [0] := ID ==> projectile* map for living unsynced projectiles
 	// [1] := ID ==> projectile* map for living   synced projectiles
 	std::vector<CProjectile*> projectileMaps[2];
+
+	// per-projectile results of the concurrent pre-pass in CheckUnitFeatureCollisions
+	std::vector<uint8_t> collisionCandidates;
 };
 
 
@@ -184,6 +184,10 @@ void CUnit::SanityCheck() const
 		assert(pos.z >= -(float3::maxzpos * 16.0f));
 		assert(pos.z <=  (float3::maxzpos * 16.0f));
 	}
+
+	// the SoA mirror must never diverge from the unit itself
+	assert(unitHandler.GetHotState().GetPosRadius(id) == float4(pos, radius));
+	assert(unitHandler.GetHotState().GetPhysicalState(id) == physicalState);
 }
 
 
@@ -389,6 +393,8 @@ void CUnit::PostInit(const CUnit* builder)
 
 void CUnit::PostLoad()
 {
+	UpdateHotState();
+
 	eventHandler.RenderUnitPreCreated(this);
 	eventHandler.RenderUnitCreated(this, isCloaked);
 }
@@ -547,6 +553,12 @@ float3 CUnit::GetErrorVector(int argAllyTeam) const
 	return (posErrorVector * errorMult * (atErrorMask != 0));
 }
 
+void CUnit::UpdateHotState()
+{
+	unitHandler.UpdateHotState(this);
+}
+
+
 void CUnit::UpdatePosErrorParams(bool updateError, bool updateDelta)
 {
 	// every frame, magnitude of error increases
@@ -656,6 +668,15 @@ void CUnit::Update()
 	outOfMapTime *= (!pos.IsInBounds());
 }
 
+bool CUnit::GetUpdateDependents(std::vector<CUnit*>& dependents) const
+{
+	for (const TransportedUnit& tu: transportedUnits) {
+		dependents.push_back(tu.unit);
+	}
+
+	return true;
+}
+
 void CUnit::UpdateWeapons()
 {
 	if (!CanUpdateWeapons())
@@ -1745,6 +1766,24 @@ void CUnit::DependentDied(CObject* o)
 
 
 
+enum {
+	UPDATE_EVENT_ENTERED_AIR   = 0,
+	UPDATE_EVENT_LEFT_AIR      = 1,
+	UPDATE_EVENT_ENTERED_WATER = 2,
+	UPDATE_EVENT_LEFT_WATER    = 3,
+};
+
+static void FireUpdateEvent(CUnit* unit, unsigned int event)
+{
+	switch (event) {
+		case UPDATE_EVENT_ENTERED_AIR  : { eventHandler.UnitEnteredAir(unit);   } break;
+		case UPDATE_EVENT_LEFT_AIR     : { eventHandler.UnitLeftAir(unit);      } break;
+		case UPDATE_EVENT_ENTERED_WATER: { eventHandler.UnitEnteredWater(unit); } break;
+		case UPDATE_EVENT_LEFT_WATER   : { eventHandler.UnitLeftWater(unit);    } break;
+		default: { assert(false); } break;
+	}
+}
+
 void CUnit::UpdatePhysicalState(float eps)
 {
 	const bool inAir   = IsInAir();
@@ -1752,20 +1791,35 @@ void CUnit::UpdatePhysicalState(float eps)
 
 	CSolidObject::UpdatePhysicalState(eps);
 
-	if (IsInAir() != inAir) {
-		if (IsInAir()) {
-			eventHandler.UnitEnteredAir(this);
-		} else {
-			eventHandler.UnitLeftAir(this);
+	unsigned int events[2];
+	unsigned int numEvents = 0;
+
+	if (IsInAir() != inAir)
+		events[numEvents++] = IsInAir()? UPDATE_EVENT_ENTERED_AIR: UPDATE_EVENT_LEFT_AIR;
+	if (IsInWater() != inWater)
+		events[numEvents++] = IsInWater()? UPDATE_EVENT_ENTERED_WATER: UPDATE_EVENT_LEFT_WATER;
+
+	for (unsigned int i = 0; i < numEvents; i++) {
+		if (!recordUpdateEvents) {
+			FireUpdateEvent(this, events[i]);
+			continue;
 		}
+
+		// Update calls this once, so two per frame at most
+		assert(numRecordedUpdateEvents < sizeof(recordedUpdateEvents));
+		recordedUpdateEvents[numRecordedUpdateEvents++] = events[i];
 	}
-	if (IsInWater() != inWater) {
-		if (IsInWater()) {
-			eventHandler.UnitEnteredWater(this);
-		} else {
-			eventHandler.UnitLeftWater(this);
-		}
+}
+
+void CUnit::FlushUpdateEvents()
+{
+	recordUpdateEvents = false;
+
+	for (uint8_t i = 0; i < numRecordedUpdateEvents; i++) {
+		FireUpdateEvent(this, recordedUpdateEvents[i]);
 	}
+
+	numRecordedUpdateEvents = 0;
 }
 
 void CUnit::UpdateTerrainType()
@@ -2929,6 +2983,9 @@ CR_REG_METADATA(CUnit, (
 	CR_MEMBER(incomingMissiles),
 
 	CR_MEMBER(cegDamage),
+	CR_IGNORED(recordedUpdateEvents),
+	CR_IGNORED(numRecordedUpdateEvents),
+	CR_IGNORED(recordUpdateEvents),
 
 	CR_MEMBER_UN(noMinimap),
 	CR_MEMBER_UN(leaveTracks),
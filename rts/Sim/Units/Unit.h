@@ -83,6 +83,10 @@ public:
 	virtual void PostInit(const CUnit* builder);
 
 	virtual void Update();
+	/// true if Update() only modifies the state of this unit
+	virtual bool HasIsolatedUpdate() const { return (transporter == nullptr && transportedUnits.empty()); }
+	/// collects the other units Update() may modify; false if it can also change global state (e.g. terrain)
+	virtual bool GetUpdateDependents(std::vector<CUnit*>& dependents) const;
 	virtual void SlowUpdate();
 
 	const SolidObjectDef* GetDef() const { return ((const SolidObjectDef*) unitDef); }
@@ -108,6 +112,7 @@ public:
 	void Deactivate();
 
 	void ForcedMove(const float3& newPos);
+	void UpdateHotState() override;
 
 	void DeleteScript();
 	void EnableScriptMoveType();
@@ -150,6 +155,8 @@ public:
 	void CalculateTerrainType();
 	void UpdateTerrainType();
 	void UpdatePhysicalState(float eps);
+	/// fires the callins UpdatePhysicalState recorded while recordUpdateEvents was set
+	void FlushUpdateEvents();
 
 	float3 GetErrorVector(int allyteam) const;
 	float3 GetErrorPos(int allyteam, bool aiming = false) const { return (aiming? aimPos: midPos) + GetErrorVector(allyteam); }
@@ -511,6 +518,12 @@ public:
 	// the damage value passed to CEGs spawned by this unit's script
 	int cegDamage = 0;
 
+	// set while Update() runs on a worker thread (CUnitHandler::UpdateUnitsMT);
+	// the physical-state callins are then only recorded until FlushUpdateEvents
+	uint8_t recordedUpdateEvents[4];
+	uint8_t numRecordedUpdateEvents = 0;
+	bool recordUpdateEvents = false;
+
 
 	// if the unit is in it's 'on'-state
 	bool activated = false;
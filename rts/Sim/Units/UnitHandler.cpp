@@ -11,7 +11,9 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Game/GameHelper.h"
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Path/IPathManager.h"
@@ -43,7 +45,11 @@ CR_REG_METADATA(CUnitHandler, (
 	CR_MEMBER(maxUnits),
 	CR_MEMBER(maxUnitRadius),
 
-	CR_MEMBER(inUpdateCall)
+	CR_MEMBER(inUpdateCall),
+
+	CR_IGNORED(updateDependents),
+	CR_IGNORED(deferredUpdateFlags),
+	CR_IGNORED(hotState)
 ))
 
 
@@ -53,6 +59,19 @@ UnitMemPool unitMemPool;
 CUnitHandler unitHandler;
 
 
+void UnitHotState::Update(const CUnit* unit)
+{
+	// PreInit moves units before AddUnit has assigned their ID
+	if (static_cast<unsigned int>(unit->id) >= posRadius.size())
+		return;
+
+	posRadius[unit->id] = float4(unit->pos, unit->radius);
+	speeds[unit->id] = unit->speed;
+	allyTeams[unit->id] = unit->allyteam;
+	physicalStates[unit->id] = unit->physicalState;
+}
+
+
 CUnit* CUnitHandler::NewUnit(const UnitDef* ud)
 {
 	// special static builder structures that can always be given
@@ -104,6 +123,8 @@ void CUnitHandler::Init() {
 	{
 		units.resize(maxUnits, nullptr);
 		activeUnits.reserve(maxUnits);
+		deferredUpdateFlags.resize(maxUnits, 0);
+		hotState.Init(maxUnits);
 
 		unitMemPool.reserve(128);
 
@@ -131,6 +152,7 @@ void CUnitHandler::Kill()
 		unitMemPool.clear();
 
 		units.clear();
+		hotState.Kill();
 
 		for (int teamNum = 0; teamNum < MAX_TEAMS; teamNum++) {
 			// reuse inner vectors when reloading
@@ -204,6 +226,7 @@ bool CUnitHandler::AddUnit(CUnit* unit)
 	assert(CanAddUnit(unit->id));
 
 	InsertActiveUnit(unit);
+	hotState.Update(unit);
 
 	teamHandler.Team(unit->team)->AddUnit(unit, CTeam::AddBuilt);
 
@@ -351,6 +374,9 @@ void CUnitHandler::SlowUpdateUnits()
 
 	activeSlowUpdateUnit = idxEnd;
 
+	// weapons of this batch scanning for targets in the same area share the candidates
+	helper->PrepareWeaponTargets(activeUnits, idxBeg, idxEnd);
+
 	// stagger the SlowUpdate's
 	for (size_t i = idxBeg; i<idxEnd; ++i) {
 		CUnit* unit = activeUnits[i];
@@ -475,6 +501,82 @@ void CUnitHandler::UpdateUnits()
 	}
 }
 
+void CUnitHandler::UpdateUnitsMT()
+{
+	// plain CUnit::Update only touches the unit itself, but transporters
+	// move their transportees and builders or factories change buildees,
+	// team resources and fire events; such units and everything they can
+	// modify are deferred to the serial pass below
+	std::fill(deferredUpdateFlags.begin(), deferredUpdateFlags.end(), 0);
+
+	for (const CUnit* unit: activeUnits) {
+		if (unit->HasIsolatedUpdate())
+			continue;
+
+		updateDependents.clear();
+
+		// global side-effects, nothing can run concurrently this frame
+		if (!unit->GetUpdateDependents(updateDependents)) {
+			UpdateUnits();
+			return;
+		}
+
+		deferredUpdateFlags[unit->id] = 1;
+
+		for (const CUnit* dependent: updateDependents) {
+			deferredUpdateFlags[dependent->id] = 1;
+		}
+	}
+
+	SCOPED_TIMER("Sim::Unit::Update");
+
+	// the units a task updates do not depend on the number of threads
+	constexpr size_t chunkSize = 256;
+
+	const size_t numUnits = activeUnits.size();
+	const size_t numChunks = (numUnits + chunkSize - 1) / chunkSize;
+
+	for_mt(0, numChunks, [&](const int chunkIdx) {
+		const size_t idxBeg = chunkIdx * chunkSize;
+		const size_t idxEnd = std::min(idxBeg + chunkSize, numUnits);
+
+		for (size_t i = idxBeg; i < idxEnd; ++i) {
+			CUnit* unit = activeUnits[i];
+
+			if (deferredUpdateFlags[unit->id] != 0)
+				continue;
+
+			// callins (UnitEnteredAir etc) must not run here, FlushUpdateEvents fires them
+			unit->recordUpdateEvents = true;
+
+			unit->SanityCheck();
+			unit->Update();
+			unit->SanityCheck();
+		}
+	});
+
+	// walk activeUnits in order, updating the deferred units and firing the
+	// callins recorded for the others at their position; callins thus reach
+	// Lua in the same order as in UpdateUnits, but see every non-deferred
+	// unit already updated (deterministically so, on all clients)
+	//
+	// units created by builders and factories in this pass are appended and
+	// (as in UpdateUnits) still get their first Update this frame
+	for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size(); ++activeUpdateUnit) {
+		CUnit* unit = activeUnits[activeUpdateUnit];
+
+		if (activeUpdateUnit >= numUnits || deferredUpdateFlags[unit->id] != 0) {
+			unit->SanityCheck();
+			unit->Update();
+			unit->SanityCheck();
+		} else {
+			unit->FlushUpdateEvents();
+		}
+
+		assert(activeUnits[activeUpdateUnit] == unit);
+	}
+}
+
 void CUnitHandler::UpdateUnitWeapons()
 {
 	SCOPED_TIMER("Sim::Unit::Weapon");
@@ -493,7 +595,15 @@ void CUnitHandler::Update()
 	QueueDeleteUnits();
 	UpdateUnitLosStates();
 	SlowUpdateUnits();
-	UpdateUnits();
+
+	// SYNCDEBUG records every synced assertion in call order
+	#ifndef SYNCDEBUG
+	if (modInfo.unitUpdateMultiThreaded)
+		UpdateUnitsMT();
+	else
+	#endif
+		UpdateUnits();
+
 	UpdateUnitWeapons();
 
 	inUpdateCall = false;
@@ -521,6 +631,8 @@ void CUnitHandler::ChangeUnitTeam(CUnit* unit, int oldTeamNum, int newTeamNum)
 	spring::VectorErase       (GetUnitsByTeamAndDef(oldTeamNum, unit->unitDef->id), unit       );
 	spring::VectorInsertUnique(GetUnitsByTeamAndDef(newTeamNum,                 0), unit, false);
 	spring::VectorInsertUnique(GetUnitsByTeamAndDef(newTeamNum, unit->unitDef->id), unit, false);
+
+	hotState.Update(unit);
 }
 
 
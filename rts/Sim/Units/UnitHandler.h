@@ -8,6 +8,7 @@
 
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/SimObjectIDPool.h"
+#include "Sim/Units/UnitHotState.h"
 #include "System/creg/STL_Map.h"
 
 struct UnitDef;
@@ -56,6 +57,9 @@ public:
 
 	void ChangeUnitTeam(CUnit* unit, int oldTeamNum, int newTeamNum);
 
+	const UnitHotState& GetHotState() const { return hotState; }
+	void UpdateHotState(const CUnit* unit) { hotState.Update(unit); }
+
 	// note: negative ID's are implicitly converted
 	CUnit* GetUnitUnsafe(unsigned int id) const { return units[id]; }
 	CUnit* GetUnit(unsigned int id) const { return ((id < MaxUnits())? units[id]: nullptr); }
@@ -84,6 +88,7 @@ private:
 	void UpdateUnitMoveTypes();
 	void UpdateUnitLosStates();
 	void UpdateUnits();
+	void UpdateUnitsMT();
 	void UpdateUnitWeapons();
 
 	void GetUnitsWithPathRequests(std::vector<CUnit*>& unitsToMove, const size_t idxBeg, const size_t idxEnd);
@@ -101,6 +106,14 @@ private:
 
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
+	///< scratch state of UpdateUnitsMT; flags the units whose Update can
+	///< not run concurrently and is done in the serial pass instead
+	std::vector<CUnit*> updateDependents;
+	std::vector<uint8_t> deferredUpdateFlags;
+
+	///< SoA mirror of the hot CUnit fields, indexed by unit ID
+	UnitHotState hotState;
+
 
 	size_t activeSlowUpdateUnit = 0;  ///< first unit of batch that will be SlowUpdate'd this frame
 	size_t activeUpdateUnit = 0;      ///< first unit of batch that will be SlowUpdate'd this frame
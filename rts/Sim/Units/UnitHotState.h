@@ -0,0 +1,60 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef UNIT_HOT_STATE_H
+#define UNIT_HOT_STATE_H
+
+#include <vector>
+
+#include "System/float4.h"
+
+class CUnit;
+
+/**
+ * Structure-of-arrays mirror of the CUnit fields that range scans read,
+ * indexed by unit ID so a scan touches a few compact arrays instead of a
+ * full CUnit per candidate.
+ *
+ * Entries are written by CUnit::UpdateHotState, which CSolidObject calls
+ * from every setter of a mirrored field (Move, SetVelocity, SetSpeed, the
+ * physical-state bit setters, ...) so they never diverge from the unit.
+ */
+class UnitHotState
+{
+public:
+	void Init(unsigned int maxUnits) {
+		posRadius.clear();
+		posRadius.resize(maxUnits, float4());
+		speeds.clear();
+		speeds.resize(maxUnits, float4());
+		allyTeams.clear();
+		allyTeams.resize(maxUnits, -1);
+		physicalStates.clear();
+		physicalStates.resize(maxUnits, 0);
+	}
+	void Kill() {
+		posRadius.clear();
+		speeds.clear();
+		allyTeams.clear();
+		physicalStates.clear();
+	}
+
+	// defined in UnitHandler.cpp
+	void Update(const CUnit* unit);
+
+	const float4& GetPosRadius(int unitID) const { return posRadius[unitID]; }
+	const float4& GetSpeed(int unitID) const { return speeds[unitID]; }
+
+	int GetAllyTeam(int unitID) const { return allyTeams[unitID]; }
+	unsigned int GetPhysicalState(int unitID) const { return physicalStates[unitID]; }
+
+private:
+	///< .xyz := pos, .w := radius
+	std::vector<float4> posRadius;
+	///< .xyz := velocity, .w := |velocity|
+	std::vector<float4> speeds;
+
+	std::vector<int> allyTeams;
+	std::vector<unsigned int> physicalStates;
+};
+
+#endif /* UNIT_HOT_STATE_H */
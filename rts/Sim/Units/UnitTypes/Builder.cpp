@@ -545,6 +545,23 @@ void CBuilder::Update()
 }
 
 
+bool CBuilder::GetUpdateDependents(std::vector<CUnit*>& dependents) const
+{
+	// terraforming changes the heightmap every unit reads
+	if (terraforming || helpTerraform != nullptr)
+		return false;
+
+	if (curBuild != nullptr)
+		dependents.push_back(curBuild);
+	if (curCapture != nullptr)
+		dependents.push_back(curCapture);
+	if (curReclaim != nullptr && reclaimingUnit)
+		dependents.push_back(static_cast<CUnit*>(curReclaim));
+
+	return (CUnit::GetUpdateDependents(dependents));
+}
+
+
 void CBuilder::SlowUpdate()
 {
 	if (terraforming)
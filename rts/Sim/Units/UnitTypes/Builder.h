@@ -32,6 +32,8 @@ public:
 	CBuilder();
 
 	void Update();
+	bool HasIsolatedUpdate() const { return false; }
+	bool GetUpdateDependents(std::vector<CUnit*>& dependents) const;
 	void SlowUpdate();
 	void DependentDied(CObject* o);
 
@@ -142,6 +142,15 @@ void CFactory::Update()
 	CBuilding::Update();
 }
 
+bool CFactory::GetUpdateDependents(std::vector<CUnit*>& dependents) const
+{
+	// BuggerOff only issues orders, which Update does not read
+	if (curBuild != nullptr)
+		dependents.push_back(curBuild);
+
+	return (CUnit::GetUpdateDependents(dependents));
+}
+
 
 
 void CFactory::StartBuild(const UnitDef* buildeeDef) {
@@ -27,6 +27,8 @@ public:
 	unsigned int QueueBuild(const UnitDef* buildeeDef, const Command& buildCmd);
 
 	void Update();
+	bool HasIsolatedUpdate() const { return false; }
+	bool GetUpdateDependents(std::vector<CUnit*>& dependents) const;
 
 	void DependentDied(CObject* o);
 	void CreateNanoParticle(bool highPriority = false);
@@ -15,15 +15,10 @@ CRC::CRC(): crc(CRC_INIT_VAL)
 
 uint32_t CRC::InitTable()
 {
-	static bool crcTableInitialized = false;
+	// archives are opened concurrently, let the compiler guard this
+	static const bool crcTableInitialized = (CrcGenerateTable(), true);
 
-	if (crcTableInitialized)
-		return 1;
-
-	CrcGenerateTable();
-
-	crcTableInitialized = true;
-	return 0;
+	return crcTableInitialized;
 }
 
 uint32_t CRC::CalcDigest(const void* data, size_t size)
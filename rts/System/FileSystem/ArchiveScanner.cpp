@@ -18,9 +18,11 @@
 #include "DataDirsAccess.h"
 #include "FileSystem.h"
 #include "FileQueryFlags.h"
+#include "MappedFile.h"
 #include "Lua/LuaParser.h"
 #include "System/ContainerUtil.h"
 #include "System/StringUtil.h"
+#include "System/Sync/HsiehHash.h"
 #include "System/Exceptions.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/FileSystem/RapidHandler.h"
@@ -53,6 +55,12 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
 
 constexpr static int INTERNAL_VER = 16;
 
+static std::string GetCacheFilePath(const char* fileNameFmt)
+{
+	// the "cache" dir is created in DataDirLocater
+	return (FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, fileNameFmt));
+}
+
 
 /*
  * Engine known (and used?) tags in [map|mod]info.lua
@@ -387,14 +395,15 @@ static std::atomic<uint32_t> numScannedArchives{0};
 CArchiveScanner::CArchiveScanner()
 {
 	Clear();
-	// the "cache" dir is created in DataDirLocater
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = GetCacheFilePath("ArchiveCache%i.bin"));
 	ScanAllDirs();
 }
 
 
 CArchiveScanner::~CArchiveScanner()
 {
+	WriteHashCacheData(hashCacheFile);
+
 	if (!isDirty)
 		return;
 
@@ -430,9 +439,11 @@ void CArchiveScanner::Reload()
 	if (isDirty)
 		WriteCacheData(GetFilepath());
 
+	WriteHashCacheData(hashCacheFile);
+
 	// ctor
 	Clear();
-	ReadCacheData(cachefile = FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheDir()) + IntToString(INTERNAL_VER, "ArchiveCache%i.lua"));
+	ReadCacheData(cachefile = GetCacheFilePath("ArchiveCache%i.bin"));
 	ScanAllDirs();
 }
 
@@ -947,15 +958,62 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 	// sort by filename
 	std::stable_sort(fileNames.begin(), fileNames.end());
 
-	// compute hashes of the files
-	for_mt(0, fileNames.size(), [&](const int i) {
-		ar->CalcHash(ar->FindFile(fileNames[i]), fileHashes[i].data(), fileBuffers[ ThreadPool::GetThreadNum() ]);
+	// compressed archives are only ever replaced as a whole, so the hashes of
+	// their files stay valid until the archive's mtime changes; pool archives
+	// have them precomputed and directory archives lack a meaningful mtime
+	ArchiveFileHashes* cachedHashes = nullptr;
+
+	if (ar->GetType() == ARCHIVE_TYPE_SDZ || ar->GetType() == ARCHIVE_TYPE_SD7) {
+		const uint32_t modified = FileSystemAbstraction::GetFileModificationTime(archiveName);
+
+		if (modified != 0) {
+			if (hashCacheFile.empty())
+				ReadHashCacheData(hashCacheFile = GetCacheFilePath("ArchiveHashes%i.bin"));
+
+			cachedHashes = &archiveFileHashes[archiveName];
+
+			if (cachedHashes->modified != modified || cachedHashes->files.size() != ar->NumFiles()) {
+				cachedHashes->modified = modified;
+				cachedHashes->files.clear();
+				cachedHashes->files.resize(ar->NumFiles());
+			}
+		}
+	}
+
+	std::vector<unsigned int> fileIDs(fileNames.size());
+	std::vector<uint32_t> fileSizes(fileNames.size());
+	std::vector<size_t> uncachedFiles;
+
+	for (size_t i = 0; i < fileNames.size(); i++) {
+		fileIDs[i] = ar->FindFile(fileNames[i]);
+		fileSizes[i] = ar->FileInfo(fileIDs[i]).second;
+
+		if (cachedHashes != nullptr && cachedHashes->files[fileIDs[i]].size == fileSizes[i]) {
+			fileHashes[i] = cachedHashes->files[fileIDs[i]].hash;
+			continue;
+		}
+
+		uncachedFiles.push_back(i);
+	}
+
+	// compute hashes of the files not seen before
+	for_mt(0, uncachedFiles.size(), [&](const int j) {
+		const size_t i = uncachedFiles[j];
+
+		if (ar->CalcHash(fileIDs[i], fileHashes[i].data(), fileBuffers[ ThreadPool::GetThreadNum() ]) && cachedHashes != nullptr) {
+			cachedHashes->files[fileIDs[i]].size = fileSizes[i];
+			cachedHashes->files[fileIDs[i]].hash = fileHashes[i];
+		}
 
 		#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer(WDT_MAIN);
 		#endif
 	});
 
+	isHashCacheDirty |= (cachedHashes != nullptr && !uncachedFiles.empty());
+
+	LOG_S(LOG_SECTION_ARCHIVESCANNER, "[%s] hashed %u of %u files in %s", __func__, uint32_t(uncachedFiles.size()), uint32_t(fileNames.size()), archiveName.c_str());
+
 	// combine individual hashes, initialize to hash(name)
 	for (size_t i = 0; i < fileNames.size(); i++) {
 		sha512::calc_digest(reinterpret_cast<const uint8_t*>(fileNames[i].c_str()), fileNames[i].size(), archiveInfo.checksum);
@@ -973,7 +1031,217 @@ bool CArchiveScanner::GetArchiveChecksum(const std::string& archiveName, Archive
 }
 
 
+/*
+ * Layout of the binary ArchiveCache. Everything is stored in native byte
+ * order (the cache never leaves the machine it was written on) and every
+ * section is 4-byte aligned, so records are used directly from the mapped
+ * file:
+ *
+ *   CacheHeader
+ *   CacheArchiveRecord[numArchives]
+ *   CacheBrokenRecord[numBrokenArchives]
+ *   CacheInfoItemRecord[numInfoItems]
+ *   uint32_t[numStringRefs]    (dependency names)
+ *   char[stringTableSize]      (NUL-terminated, deduplicated strings)
+ *
+ * Strings are referenced by their offset into the string table, offset 0
+ * is always the empty string.
+ */
+static constexpr char CACHE_MAGIC[8] = {'S', 'P', 'R', 'A', 'C', 'B', 'I', 'N'};
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t fileSize;
+
+	uint32_t numArchives;
+	uint32_t numBrokenArchives;
+	uint32_t numInfoItems;
+	uint32_t numStringRefs;
+	uint32_t stringTableSize;
+
+	uint32_t dataHash; // over everything following the header
+};
+
+struct CacheArchiveRecord {
+	uint32_t origName;
+	uint32_t path;
+	uint32_t archiveDataPath;
+
+	uint32_t modified;
+	uint32_t modifiedArchiveData;
+
+	uint32_t firstInfoItem;
+	uint32_t numInfoItems;
+	uint32_t firstDependency;
+	uint32_t numDependencies;
+
+	uint8_t checksum[sha512::SHA_LEN];
+};
+
+struct CacheBrokenRecord {
+	uint32_t name;
+	uint32_t path;
+	uint32_t problem;
+	uint32_t modified;
+};
+
+struct CacheInfoItemRecord {
+	uint32_t key;
+	uint32_t valueType;
+	uint32_t value; // integer, float or bool bits, or a string offset
+};
+
+static_assert((sizeof(CacheHeader) % 4) == 0, "");
+static_assert(sizeof(CacheArchiveRecord) == (sizeof(uint32_t) * 9 + sha512::SHA_LEN), "");
+
+
+static void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
+{
+	auto it = std::remove_if(deps.begin(), deps.end(), [&](const std::string& dep) { return (dep == exclude); });
+	deps.erase(it, deps.end());
+}
+
+
 void CArchiveScanner::ReadCacheData(const std::string& filename)
+{
+	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+
+	const CMappedFile file(filename);
+
+	if (!file.IsOpen()) {
+		// carry the text cache of older versions over instead of rescanning everything
+		const std::string& luaCacheFile = GetCacheFilePath("ArchiveCache%i.lua");
+
+		if (FileSystem::FileExists(luaCacheFile)) {
+			LOG_L(L_INFO, "[AS::%s] ArchiveCache %s doesn't exist, importing %s", __func__, filename.c_str(), luaCacheFile.c_str());
+			ReadLuaCacheData(luaCacheFile);
+			return;
+		}
+
+		LOG_L(L_INFO, "[AS::%s] ArchiveCache %s doesn't exist", __func__, filename.c_str());
+		return;
+	}
+
+	const uint8_t* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	CacheHeader header;
+
+	if (size < sizeof(header))
+		return;
+
+	std::memcpy(&header, data, sizeof(header));
+
+	// Do not load old version caches
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != INTERNAL_VER)
+		return;
+
+	const uint64_t stringTableOffset =
+		sizeof(CacheHeader) +
+		sizeof(CacheArchiveRecord) * uint64_t(header.numArchives) +
+		sizeof(CacheBrokenRecord) * uint64_t(header.numBrokenArchives) +
+		sizeof(CacheInfoItemRecord) * uint64_t(header.numInfoItems) +
+		sizeof(uint32_t) * uint64_t(header.numStringRefs);
+
+	const bool validSize = (header.fileSize == size && header.stringTableSize > 0 && (stringTableOffset + header.stringTableSize) == size);
+
+	// also catches a file that was damaged outside of WriteCacheFile
+	if (!validSize || data[size - 1] != 0 || HsiehHash(data + sizeof(header), size - sizeof(header), 0) != header.dataHash) {
+		LOG_L(L_WARNING, "[AS::%s] ArchiveCache %s is corrupt, ignoring it", __func__, filename.c_str());
+		return;
+	}
+
+	const CacheArchiveRecord* archiveRecs = reinterpret_cast<const CacheArchiveRecord*>(data + sizeof(CacheHeader));
+	const CacheBrokenRecord* brokenRecs = reinterpret_cast<const CacheBrokenRecord*>(archiveRecs + header.numArchives);
+	const CacheInfoItemRecord* infoItemRecs = reinterpret_cast<const CacheInfoItemRecord*>(brokenRecs + header.numBrokenArchives);
+	const uint32_t* stringRefs = reinterpret_cast<const uint32_t*>(infoItemRecs + header.numInfoItems);
+	const char* stringTable = reinterpret_cast<const char*>(stringRefs + header.numStringRefs);
+
+	const auto GetString = [&](uint32_t offset) { return std::string((offset < header.stringTableSize)? (stringTable + offset): ""); };
+	const auto InRange = [](uint32_t first, uint32_t count, uint32_t total) { return (first <= total && count <= (total - first)); };
+
+	for (uint32_t i = 0; i < header.numArchives; ++i) {
+		const CacheArchiveRecord& rec = archiveRecs[i];
+
+		if (!InRange(rec.firstInfoItem, rec.numInfoItems, header.numInfoItems) || !InRange(rec.firstDependency, rec.numDependencies, header.numStringRefs))
+			continue;
+
+		const std::string& curArchiveName = GetString(rec.origName);
+
+		ArchiveInfo& ai = GetAddArchiveInfo(StringToLower(curArchiveName));
+		ArchiveInfo tmp; // used to compare against all-zero hash
+
+		ai.origName = curArchiveName;
+		ai.path = GetString(rec.path);
+		ai.archiveDataPath = GetString(rec.archiveDataPath);
+
+		ai.modified = rec.modified;
+		ai.modifiedArchiveData = rec.modifiedArchiveData;
+
+		std::memcpy(ai.checksum, rec.checksum, sha512::SHA_LEN);
+
+		ai.updated = false;
+		ai.hashed = (memcmp(ai.checksum, tmp.checksum, sha512::SHA_LEN) != 0);
+
+		ai.archiveData = {};
+
+		for (uint32_t j = rec.firstInfoItem, n = rec.firstInfoItem + rec.numInfoItems; j < n; ++j) {
+			const CacheInfoItemRecord& itemRec = infoItemRecs[j];
+			const std::string& key = GetString(itemRec.key);
+
+			switch (itemRec.valueType) {
+				case INFO_VALUE_TYPE_STRING: {
+					ai.archiveData.SetInfoItemValueString(key, GetString(itemRec.value));
+				} break;
+				case INFO_VALUE_TYPE_INTEGER: {
+					int32_t value;
+					std::memcpy(&value, &itemRec.value, sizeof(value));
+					ai.archiveData.SetInfoItemValueInteger(key, value);
+				} break;
+				case INFO_VALUE_TYPE_FLOAT: {
+					float value;
+					std::memcpy(&value, &itemRec.value, sizeof(value));
+					ai.archiveData.SetInfoItemValueFloat(key, value);
+				} break;
+				case INFO_VALUE_TYPE_BOOL: {
+					ai.archiveData.SetInfoItemValueBool(key, itemRec.value != 0);
+				} break;
+				default: {
+				} break;
+			}
+		}
+
+		for (uint32_t j = rec.firstDependency, n = rec.firstDependency + rec.numDependencies; j < n; ++j) {
+			ai.archiveData.GetDependencies().push_back(GetString(stringRefs[j]));
+		}
+
+		if (ai.archiveData.IsMap()) {
+			AddDependency(ai.archiveData.GetDependencies(), GetMapHelperContentName());
+		} else if (ai.archiveData.IsGame()) {
+			AddDependency(ai.archiveData.GetDependencies(), GetSpringBaseContentName());
+		}
+	}
+
+	for (uint32_t i = 0; i < header.numBrokenArchives; ++i) {
+		const CacheBrokenRecord& rec = brokenRecs[i];
+		const std::string& name = StringToLower(GetString(rec.name));
+
+		BrokenArchive& ba = GetAddBrokenArchive(name);
+		ba.name = name;
+		ba.path = GetString(rec.path);
+		ba.modified = rec.modified;
+		ba.updated = false;
+		ba.problem = GetString(rec.problem);
+
+		if (ba.problem.empty())
+			ba.problem = "unknown";
+	}
+
+	isDirty = false;
+}
+
+void CArchiveScanner::ReadLuaCacheData(const std::string& filename)
 {
 	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
 	if (!FileSystem::FileExists(filename)) {
@@ -1053,22 +1321,40 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 	isDirty = false;
 }
 
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
+/*
+ * Writes <image> to <filename>, unless the file already holds exactly that
+ * (the common case of nothing having changed since the last scan). The image
+ * goes to a temporary file in the same directory first, which then replaces
+ * the old cache, so a crash or full disk can not leave a torn file behind.
+ */
+static bool WriteCacheFile(const std::string& filename, const std::vector<uint8_t>& image)
 {
-	if (str.empty())
-		return;
+	{
+		// closed again before renaming, windows can not replace a mapped file
+		const CMappedFile file(filename);
 
-	if ((str.find_first_of("\\\"") != std::string::npos) || (str.find_first_of('\n') != std::string::npos )) {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
+		if (file.IsOpen() && file.GetSize() == image.size() && std::memcmp(file.GetData(), image.data(), image.size()) == 0)
+			return true;
 	}
-}
 
-void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
-{
-	auto it = std::remove_if(deps.begin(), deps.end(), [&](const std::string& dep) { return (dep == exclude); });
-	deps.erase(it, deps.end());
+	const std::string tmpFilename = filename + ".tmp";
+
+	FILE* out = fopen(tmpFilename.c_str(), "wb");
+
+	if (out == nullptr)
+		return false;
+
+	bool written = true;
+
+	written &= (fwrite(image.data(), 1, image.size(), out) == image.size());
+	written &= (fclose(out) != EOF);
+
+	if (!written) {
+		FileSystemAbstraction::DeleteFile(tmpFilename);
+		return false;
+	}
+
+	return (FileSystemAbstraction::RenameFile(tmpFilename, filename));
 }
 
 void CArchiveScanner::WriteCacheData(const std::string& filename)
@@ -1077,12 +1363,6 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	if (!isDirty)
 		return;
 
-	FILE* out = fopen(filename.c_str(), "wt");
-	if (out == nullptr) {
-		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
-		return;
-	}
-
 	// First delete all outdated information
 	{
 		std::stable_sort(archiveInfos.begin(), archiveInfos.end(), [](const ArchiveInfo& a, const ArchiveInfo& b) { return (a.origName < b.origName); });
@@ -1107,40 +1387,63 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	}
 
 
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = %u\n", unsigned(archiveInfos.size()));
+	std::vector<CacheArchiveRecord> archiveRecs;
+	std::vector<CacheBrokenRecord> brokenRecs;
+	std::vector<CacheInfoItemRecord> infoItemRecs;
+	std::vector<uint32_t> stringRefs;
+	std::string stringTable(1, '\0');
+
+	spring::unordered_map<std::string, uint32_t> stringOffsets;
+
+	const auto AddString = [&](const std::string& str) -> uint32_t {
+		if (str.empty())
+			return 0;
+
+		const auto iter = stringOffsets.find(str);
+
+		if (iter != stringOffsets.end())
+			return iter->second;
+
+		const uint32_t offset = stringTable.size();
+
+		stringTable.append(str.c_str(), str.size() + 1);
+		stringOffsets.insert(str, offset);
+		return offset;
+	};
+
+	archiveRecs.reserve(archiveInfos.size());
+	brokenRecs.reserve(brokenArchives.size());
 
 	for (const ArchiveInfo& arcInfo: archiveInfos) {
-		sha512::raw_digest rawDigest;
-		sha512::hex_digest hexDigest;
-
-		std::memcpy(rawDigest.data(), arcInfo.checksum, sha512::SHA_LEN);
-		sha512::dump_digest(rawDigest, hexDigest);
-
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%s\",\n", hexDigest.data());
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
-
-		if (!arcInfo.archiveDataPath.empty()) {
-			SafeStr(out, "\t\t\tarchiveDataPath = ",              arcInfo.archiveDataPath);
-			fprintf(out, "\t\t\tmodifiedArchiveData = \"%u\",\n", arcInfo.modifiedArchiveData);
-		}
+		CacheArchiveRecord rec;
+		std::memset(&rec, 0, sizeof(rec));
+
+		rec.origName = AddString(arcInfo.origName);
+		rec.path = AddString(arcInfo.path);
+		rec.archiveDataPath = AddString(arcInfo.archiveDataPath);
+		rec.modified = arcInfo.modified;
+		rec.modifiedArchiveData = arcInfo.modifiedArchiveData;
+
+		std::memcpy(rec.checksum, arcInfo.checksum, sha512::SHA_LEN);
 
 		// mod info?
 		const ArchiveData& archData = arcInfo.archiveData;
+
 		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
+			rec.firstInfoItem = infoItemRecs.size();
+			rec.numInfoItems = archData.GetInfo().size();
 
 			for (const auto& ii: archData.GetInfo()) {
-				if (ii.second.valueType == INFO_VALUE_TYPE_STRING) {
-					SafeStr(out, std::string("\t\t\t\t" + ii.first + " = ").c_str(), ii.second.valueTypeString);
-				} else {
-					fprintf(out, "\t\t\t\t%s = %s,\n", ii.first.c_str(), ii.second.GetValueAsString(false).c_str());
+				CacheInfoItemRecord itemRec = {AddString(ii.first), uint32_t(ii.second.valueType), 0};
+
+				switch (ii.second.valueType) {
+					case INFO_VALUE_TYPE_STRING : { itemRec.value = AddString(ii.second.valueTypeString); } break;
+					case INFO_VALUE_TYPE_INTEGER: { std::memcpy(&itemRec.value, &ii.second.value.typeInteger, sizeof(itemRec.value)); } break;
+					case INFO_VALUE_TYPE_FLOAT  : { std::memcpy(&itemRec.value, &ii.second.value.typeFloat, sizeof(itemRec.value)); } break;
+					case INFO_VALUE_TYPE_BOOL   : { itemRec.value = ii.second.value.typeBool; } break;
 				}
+
+				infoItemRecs.push_back(itemRec);
 			}
 
 			std::vector<std::string> deps = archData.GetDependencies();
@@ -1150,42 +1453,228 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 				FilterDep(deps, GetSpringBaseContentName());
 			}
 
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (const auto& dep: deps) {
-					SafeStr(out, "\t\t\t\t\t", dep);
-				}
-				fprintf(out, "\t\t\t\t},\n");
+			rec.firstDependency = stringRefs.size();
+			rec.numDependencies = deps.size();
+
+			for (const std::string& dep: deps) {
+				stringRefs.push_back(AddString(dep));
 			}
-			fprintf(out, "\t\t\t},\n");
 		}
 
-		fprintf(out, "\t\t},\n");
+		archiveRecs.push_back(rec);
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
-	fprintf(out, "\tbrokenArchives = {  -- count = %u\n", unsigned(brokenArchives.size()));
-
 	for (const BrokenArchive& ba: brokenArchives) {
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", ba.name);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+		brokenRecs.push_back({AddString(ba.name), AddString(ba.path), AddString(ba.problem), ba.modified});
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
 
-	if (fclose(out) == EOF)
+	std::vector<uint8_t> image;
+	CacheHeader header;
+
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = INTERNAL_VER;
+	header.numArchives = archiveRecs.size();
+	header.numBrokenArchives = brokenRecs.size();
+	header.numInfoItems = infoItemRecs.size();
+	header.numStringRefs = stringRefs.size();
+	header.stringTableSize = stringTable.size();
+
+	const auto AppendSection = [&](const void* sectionData, size_t sectionSize) {
+		image.insert(image.end(), reinterpret_cast<const uint8_t*>(sectionData), reinterpret_cast<const uint8_t*>(sectionData) + sectionSize);
+	};
+
+	image.resize(sizeof(header));
+	AppendSection(archiveRecs.data(), archiveRecs.size() * sizeof(CacheArchiveRecord));
+	AppendSection(brokenRecs.data(), brokenRecs.size() * sizeof(CacheBrokenRecord));
+	AppendSection(infoItemRecs.data(), infoItemRecs.size() * sizeof(CacheInfoItemRecord));
+	AppendSection(stringRefs.data(), stringRefs.size() * sizeof(uint32_t));
+	AppendSection(stringTable.data(), stringTable.size());
+
+	header.fileSize = image.size();
+	header.dataHash = HsiehHash(image.data() + sizeof(header), image.size() - sizeof(header), 0);
+
+	std::memcpy(image.data(), &header, sizeof(header));
+
+	if (!WriteCacheFile(filename, image))
 		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
 
 	isDirty = false;
 }
 
 
+/*
+ * Layout of the per-file hash cache (ArchiveHashes), following the same
+ * conventions as the ArchiveCache:
+ *
+ *   HashCacheHeader
+ *   HashCacheArchiveRecord[numArchives]
+ *   HashCacheFileRecord[numFiles]  (per archive, indexed by file-id)
+ *   char[stringTableSize]          (NUL-terminated archive paths)
+ */
+static constexpr char HASH_CACHE_MAGIC[8] = {'S', 'P', 'R', 'A', 'H', 'A', 'S', 'H'};
+
+struct HashCacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t fileSize;
+
+	uint32_t numArchives;
+	uint32_t numFiles;
+	uint32_t stringTableSize;
+
+	uint32_t dataHash; // over everything following the header
+};
+
+struct HashCacheArchiveRecord {
+	uint32_t path;
+	uint32_t modified;
+
+	uint32_t firstFile;
+	uint32_t numFiles;
+};
+
+struct HashCacheFileRecord {
+	uint32_t size; // -1 if not hashed
+	uint8_t hash[sha512::SHA_LEN];
+};
+
+static_assert((sizeof(HashCacheHeader) % 4) == 0, "");
+static_assert(sizeof(HashCacheFileRecord) == (sizeof(uint32_t) + sha512::SHA_LEN), "");
+
+
+void CArchiveScanner::ReadHashCacheData(const std::string& filename)
+{
+	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+
+	archiveFileHashes.clear();
+	isHashCacheDirty = false;
+
+	const CMappedFile file(filename);
+
+	if (!file.IsOpen())
+		return;
+
+	const uint8_t* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	HashCacheHeader header;
+
+	if (size < sizeof(header))
+		return;
+
+	std::memcpy(&header, data, sizeof(header));
+
+	if (std::memcmp(header.magic, HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC)) != 0 || header.version != INTERNAL_VER)
+		return;
+
+	const uint64_t stringTableOffset =
+		sizeof(HashCacheHeader) +
+		sizeof(HashCacheArchiveRecord) * uint64_t(header.numArchives) +
+		sizeof(HashCacheFileRecord) * uint64_t(header.numFiles);
+
+	const bool validSize = (header.fileSize == size && header.stringTableSize > 0 && (stringTableOffset + header.stringTableSize) == size);
+
+	if (!validSize || data[size - 1] != 0 || HsiehHash(data + sizeof(header), size - sizeof(header), 0) != header.dataHash) {
+		LOG_L(L_WARNING, "[AS::%s] hash cache %s is corrupt, ignoring it", __func__, filename.c_str());
+		return;
+	}
+
+	const HashCacheArchiveRecord* archiveRecs = reinterpret_cast<const HashCacheArchiveRecord*>(data + sizeof(HashCacheHeader));
+	const HashCacheFileRecord* fileRecs = reinterpret_cast<const HashCacheFileRecord*>(archiveRecs + header.numArchives);
+	const char* stringTable = reinterpret_cast<const char*>(fileRecs + header.numFiles);
+
+	archiveFileHashes.reserve(header.numArchives);
+
+	for (uint32_t i = 0; i < header.numArchives; i++) {
+		const HashCacheArchiveRecord& rec = archiveRecs[i];
+
+		if (rec.path >= header.stringTableSize || (uint64_t(rec.firstFile) + rec.numFiles) > header.numFiles)
+			continue;
+
+		ArchiveFileHashes& afh = archiveFileHashes[stringTable + rec.path];
+
+		afh.modified = rec.modified;
+		afh.files.resize(rec.numFiles);
+
+		for (uint32_t j = 0; j < rec.numFiles; j++) {
+			afh.files[j].size = fileRecs[rec.firstFile + j].size;
+			std::memcpy(afh.files[j].hash.data(), fileRecs[rec.firstFile + j].hash, sha512::SHA_LEN);
+		}
+	}
+}
+
+void CArchiveScanner::WriteHashCacheData(const std::string& filename)
+{
+	std::lock_guard<decltype(scannerMutex)> lck(scannerMutex);
+
+	if (!isHashCacheDirty)
+		return;
+
+	// drop archives that were since deleted or replaced
+	std::vector<std::pair<const std::string*, const ArchiveFileHashes*>> archives;
+	archives.reserve(archiveFileHashes.size());
+
+	for (const auto& p: archiveFileHashes) {
+		if (FileSystemAbstraction::GetFileModificationTime(p.first) != p.second.modified)
+			continue;
+
+		archives.emplace_back(&p.first, &p.second);
+	}
+
+	// keep the layout stable, so an unchanged cache is not rewritten by WriteCacheFile
+	std::sort(archives.begin(), archives.end(), [](const auto& a, const auto& b) { return (*a.first < *b.first); });
+
+	std::vector<HashCacheArchiveRecord> archiveRecs;
+	std::vector<HashCacheFileRecord> fileRecs;
+	std::string stringTable(1, '\0');
+
+	archiveRecs.reserve(archives.size());
+
+	for (const auto& p: archives) {
+		archiveRecs.push_back({uint32_t(stringTable.size()), p.second->modified, uint32_t(fileRecs.size()), uint32_t(p.second->files.size())});
+		stringTable.append(p.first->c_str(), p.first->size() + 1);
+
+		for (const ArchiveFileHashes::FileHash& fh: p.second->files) {
+			HashCacheFileRecord rec;
+
+			rec.size = fh.size;
+			std::memcpy(rec.hash, fh.hash.data(), sha512::SHA_LEN);
+
+			fileRecs.push_back(rec);
+		}
+	}
+
+
+	std::vector<uint8_t> image;
+	HashCacheHeader header;
+
+	std::memcpy(header.magic, HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC));
+	header.version = INTERNAL_VER;
+	header.numArchives = archiveRecs.size();
+	header.numFiles = fileRecs.size();
+	header.stringTableSize = stringTable.size();
+
+	const auto AppendSection = [&](const void* sectionData, size_t sectionSize) {
+		image.insert(image.end(), reinterpret_cast<const uint8_t*>(sectionData), reinterpret_cast<const uint8_t*>(sectionData) + sectionSize);
+	};
+
+	image.resize(sizeof(header));
+	AppendSection(archiveRecs.data(), archiveRecs.size() * sizeof(HashCacheArchiveRecord));
+	AppendSection(fileRecs.data(), fileRecs.size() * sizeof(HashCacheFileRecord));
+	AppendSection(stringTable.data(), stringTable.size());
+
+	header.fileSize = image.size();
+	header.dataHash = HsiehHash(image.data() + sizeof(header), image.size() - sizeof(header), 0);
+
+	std::memcpy(image.data(), &header, sizeof(header));
+
+	if (!WriteCacheFile(filename, image))
+		LOG_L(L_ERROR, "[AS::%s] failed to write to \"%s\"!", __func__, filename.c_str());
+
+	isHashCacheDirty = false;
+}
+
 static void sortByName(std::vector<CArchiveScanner::ArchiveData>& data)
 {
 	std::stable_sort(data.begin(), data.end(), [](const CArchiveScanner::ArchiveData& a, const CArchiveScanner::ArchiveData& b) {
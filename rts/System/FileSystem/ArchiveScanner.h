@@ -184,6 +184,15 @@ private:
 		uint32_t modified = 0;
 		bool updated = false;
 	};
+	struct ArchiveFileHashes {
+		struct FileHash {
+			uint32_t size = -1u; // of the file when it was hashed, -1 if it was not
+			sha512::raw_digest hash;
+		};
+
+		uint32_t modified = 0;
+		std::vector<FileHash> files; // indexed by file-id
+	};
 
 private:
 	ArchiveInfo& GetAddArchiveInfo(const std::string& lcfn);
@@ -202,9 +211,15 @@ private:
 	std::string SearchMapFile(const IArchive* ar, std::string& error);
 
 
+	/// reads the binary cache, or imports the Lua one if that does not exist yet
 	void ReadCacheData(const std::string& filename);
+	void ReadLuaCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
 
+	/// per-file hashes of (compressed) archives, see GetArchiveChecksum
+	void ReadHashCacheData(const std::string& filename);
+	void WriteHashCacheData(const std::string& filename);
+
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
 
 	/**
@@ -243,9 +258,14 @@ private:
 	std::vector<ArchiveInfo> archiveInfos;
 	std::vector<BrokenArchive> brokenArchives;
 
+	// keyed by full archive path; read on first use, survives Reload
+	spring::unordered_map<std::string, ArchiveFileHashes> archiveFileHashes;
+
 	std::string cachefile;
+	std::string hashCacheFile;
 
 	bool isDirty = false;
+	bool isHashCacheDirty = false;
 	bool isInScan = false;
 };
 
@@ -4,14 +4,34 @@
 #include "System/GlobalConfig.h"
 #include "System/MainDefines.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/ThreadPool.h"
 
 #include <cassert>
 
-spring::mutex CBufferedArchive::archiveLock;
+
+spring::mutex CBufferedArchive::cacheMutex;
+std::list<CBufferedArchive::CacheEntry> CBufferedArchive::cacheList;
+CBufferedArchive::CacheStats CBufferedArchive::cacheStats;
 
 
 CBufferedArchive::~CBufferedArchive()
 {
+	// subclasses have to do this, GetFileImpl is gone by now
+	assert(numPrefetchTasks == 0);
+
+	{
+		std::lock_guard<spring::mutex> lock(cacheMutex);
+
+		for (const FileBuffer& fb: fileCache) {
+			if (!fb.populated || !fb.exists)
+				continue;
+
+			cacheStats.numBytes -= fb.data->size();
+			cacheStats.numFiles -= 1;
+			cacheList.erase(fb.cacheIter);
+		}
+	}
+
 	// filter archives for which only {map,mod}info.lua was accessed
 	if (cacheSize <= 1 || fileCount <= 1)
 		return;
@@ -19,9 +39,17 @@ CBufferedArchive::~CBufferedArchive()
 	LOG_L(L_INFO, "[%s][name=%s] %u bytes cached in %u files", __func__, archiveFile.c_str(), cacheSize, fileCount);
 }
 
+
+CBufferedArchive::CacheStats CBufferedArchive::GetCacheStats()
+{
+	std::lock_guard<spring::mutex> lock(cacheMutex);
+	return cacheStats;
+}
+
+
 bool CBufferedArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
+	std::lock_guard<spring::mutex> lck(fileLocks[fid % NUM_FILE_LOCKS]);
 	assert(IsFileId(fid));
 
 	int ret = 0;
@@ -41,29 +69,217 @@ bool CBufferedArchive::GetFile(unsigned int fid, std::vector<std::uint8_t>& buff
 		return (ret == 1);
 	}
 
-	// NumFiles is virtual, can't do this in ctor
-	if (fileCache.empty())
-		fileCache.resize(NumFiles());
+	std::shared_ptr< const std::vector<std::uint8_t> > data;
 
-	FileBuffer& fb = fileCache.at(fid);
+	{
+		std::lock_guard<spring::mutex> lock(cacheMutex);
 
-	if (!fb.populated) {
-		fb.exists = ((ret = GetFileImpl(fid, fb.data)) == 1);
-		fb.populated = true;
+		// NumFiles is virtual, can't do this in ctor
+		if (fileCache.empty())
+			fileCache.resize(NumFiles());
 
-		cacheSize += fb.data.size();
-		fileCount += fb.exists;
+		FileBuffer& fb = fileCache.at(fid);
+
+		if (fb.populated) {
+			cacheStats.hits += 1;
+
+			if (!fb.exists) {
+				LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s", __func__, fid, archiveFile.c_str());
+				return false;
+			}
+
+			cacheList.splice(cacheList.begin(), cacheList, fb.cacheIter);
+			data = fb.data;
+		}
+	}
+
+	if (data != nullptr) {
+		if (buffer.size() != data->size())
+			buffer.resize(data->size());
+
+		// TODO: zero-copy access
+		std::copy(data->begin(), data->end(), buffer.begin());
+		return true;
 	}
 
-	if (!fb.exists) {
-		LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s ret=%d size=" _STPF_, __func__, fid, archiveFile.c_str(), ret, fb.data.size());
+	return (ExtractFile(fid, buffer));
+}
+
+bool CBufferedArchive::ExtractFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	int ret = 0;
+
+	// not cached (anymore), extract and keep a copy if it fits
+	if ((ret = GetFileImpl(fid, buffer)) != 1) {
+		LOG_L(L_WARNING, "[BufferedArchive::%s(fid=%u)][!fb.exists] name=%s ret=%d size=" _STPF_, __func__, fid, archiveFile.c_str(), ret, buffer.size());
+		AddCacheEntry(fid, false, nullptr);
 		return false;
 	}
 
-	if (buffer.size() != fb.data.size())
-		buffer.resize(fb.data.size());
+	const size_t maxFileSize = globalConfig.vfsCacheMaxFileSize * size_t(1024);
+	const size_t maxCacheSize = globalConfig.vfsCacheMaxSize * size_t(1024 * 1024);
 
-	// TODO: zero-copy access
-	std::copy(fb.data.begin(), fb.data.end(), buffer.begin());
+	if ((maxFileSize == 0 || buffer.size() <= maxFileSize) && (maxCacheSize == 0 || buffer.size() <= maxCacheSize)) {
+		AddCacheEntry(fid, true, std::make_shared< const std::vector<std::uint8_t> >(buffer));
+	} else {
+		AddCacheEntry(fid, true, nullptr);
+	}
+
+	return true;
+}
+
+bool CBufferedArchive::CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN], std::vector<std::uint8_t>& fb)
+{
+	assert(IsFileId(fid));
+
+	if (GetFileImpl(fid, fb) != 1)
+		return false;
+
+	if (fb.empty())
+		return false;
+
+	sha512::calc_digest(fb.data(), fb.size(), hash);
 	return true;
 }
+
+
+
+void CBufferedArchive::PrefetchFiles(const std::vector<unsigned int>& fids)
+{
+	// nothing to prefetch into
+	if (noCache || !globalConfig.vfsCacheArchiveFiles)
+		return;
+
+	const size_t maxFileSize = globalConfig.vfsCacheMaxFileSize * size_t(1024);
+	const size_t maxCacheSize = globalConfig.vfsCacheMaxSize * size_t(1024 * 1024);
+
+	std::vector<unsigned int> prefetchFids;
+	prefetchFids.reserve(fids.size());
+
+	size_t prefetchSize = 0;
+
+	for (const unsigned int fid: fids) {
+		// e.g. files in solid blocks, which would have to be decompressed as a whole
+		if (!IsFileId(fid) || !HasLowReadingCost(fid))
+			continue;
+
+		const size_t fileSize = FileInfo(fid).second;
+
+		if (maxFileSize > 0 && fileSize > maxFileSize)
+			continue;
+
+		// leave room for everything else, prefetched files should still be there when they are read
+		if (maxCacheSize > 0 && (prefetchSize += fileSize) > (maxCacheSize / 2))
+			break;
+
+		prefetchFids.push_back(fid);
+	}
+
+	if (prefetchFids.empty())
+		return;
+
+	// one task per worker, each takes every n-th file so the first ones requested are read first
+	const size_t numTasks = std::min(prefetchFids.size(), size_t(std::max(1, ThreadPool::GetNumThreads() - 1)));
+	const auto taskFids = std::make_shared< const std::vector<unsigned int> >(std::move(prefetchFids));
+
+	for (size_t i = 0; i < numTasks; i++) {
+		{
+			std::lock_guard<spring::mutex> lock(prefetchMutex);
+			numPrefetchTasks += 1;
+		}
+
+		ThreadPool::Enqueue([this, i, numTasks, taskFids]() {
+			std::vector<std::uint8_t> buffer;
+
+			for (size_t j = i; j < taskFids->size() && !stopPrefetch; j += numTasks) {
+				PrefetchFile((*taskFids)[j], buffer);
+			}
+
+			// notify under the lock, the archive may be deleted as soon as it is released
+			std::lock_guard<spring::mutex> lock(prefetchMutex);
+			numPrefetchTasks -= 1;
+			prefetchCond.notify_all();
+		});
+	}
+}
+
+void CBufferedArchive::PrefetchFile(unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
+	std::lock_guard<spring::mutex> lck(fileLocks[fid % NUM_FILE_LOCKS]);
+
+	{
+		std::lock_guard<spring::mutex> lock(cacheMutex);
+
+		if (fileCache.empty())
+			fileCache.resize(NumFiles());
+
+		// already read (or failed to) since it was requested
+		if (fileCache[fid].populated)
+			return;
+	}
+
+	ExtractFile(fid, buffer);
+}
+
+void CBufferedArchive::StopPrefetch()
+{
+	std::unique_lock<spring::mutex> lock(prefetchMutex);
+
+	stopPrefetch = true;
+	prefetchCond.wait(lock, [&]() { return (numPrefetchTasks == 0); });
+}
+
+
+void CBufferedArchive::AddCacheEntry(unsigned int fid, bool exists, std::shared_ptr< const std::vector<std::uint8_t> >&& data)
+{
+	std::lock_guard<spring::mutex> lock(cacheMutex);
+
+	FileBuffer& fb = fileCache.at(fid);
+
+	cacheStats.misses += 1;
+
+	if (!exists) {
+		// remember that the file could not be extracted
+		fb.populated = true;
+		fb.exists = false;
+		return;
+	}
+
+	// too large, extracted again on each request
+	if (data == nullptr)
+		return;
+
+	cacheSize += data->size();
+	fileCount += 1;
+
+	cacheStats.numBytes += data->size();
+	cacheStats.numFiles += 1;
+
+	fb.populated = true;
+	fb.exists = true;
+	fb.data = std::move(data);
+	fb.cacheIter = cacheList.insert(cacheList.begin(), {this, fid});
+
+	EvictCacheEntries(globalConfig.vfsCacheMaxSize * size_t(1024 * 1024));
+}
+
+void CBufferedArchive::EvictCacheEntries(size_t maxCacheSize)
+{
+	if (maxCacheSize == 0)
+		return;
+
+	// never evict the entry that was just added
+	while (cacheStats.numBytes > maxCacheSize && cacheList.size() > 1) {
+		const CacheEntry& entry = cacheList.back();
+		FileBuffer& fb = entry.archive->fileCache[entry.fid];
+
+		cacheStats.numBytes -= fb.data->size();
+		cacheStats.numFiles -= 1;
+		cacheStats.evictions += 1;
+
+		fb.populated = false;
+		fb.data.reset();
+
+		cacheList.pop_back();
+	}
+}
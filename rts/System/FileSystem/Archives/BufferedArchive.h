@@ -3,12 +3,28 @@
 #ifndef _BUFFERED_ARCHIVE_H
 #define _BUFFERED_ARCHIVE_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <list>
+#include <memory>
+
 #include "IArchive.h"
 #include "System/Threading/SpringThreading.h"
 
 /**
  * Provides a helper implementation for archive types that can only uncompress
- * one file to memory at a time.
+ * one file to memory at a time (per read-handle).
+ *
+ * GetFile may be called from any number of threads; the same file is never
+ * extracted twice concurrently, different files are extracted in parallel as
+ * far as the subclass allows (see ReaderPool).
+ *
+ * Extracted files are kept in a cache shared by all buffered archives, which
+ * is limited to globalConfig.vfsCacheMaxSize and drops the least recently
+ * used files first. Files above vfsCacheMaxFileSize are not cached at all.
+ * PrefetchFiles fills this cache from ThreadPool workers in the background.
  */
 class CBufferedArchive : public IArchive
 {
@@ -22,33 +38,153 @@ public:
 	virtual int GetType() const override { return ARCHIVE_TYPE_BUF; }
 
 	bool GetFile(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	void PrefetchFiles(const std::vector<unsigned int>& fids) override;
+	/// reads around the cache, hashing would otherwise cycle the whole archive through it
+	bool CalcHash(uint32_t fid, uint8_t hash[sha512::SHA_LEN], std::vector<std::uint8_t>& fb) override;
+
+public:
+	struct CacheStats {
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t evictions = 0;
+
+		// currently cached
+		std::uint64_t numBytes = 0;
+		std::uint64_t numFiles = 0;
+	};
+
+	static CacheStats GetCacheStats();
 
 protected:
+	/// must be safe to call concurrently for different file-id's
 	virtual int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) = 0;
 
-	struct FileBuffer {
-		FileBuffer() = default;
-		FileBuffer(const FileBuffer& fb) = delete;
-		FileBuffer(FileBuffer&& fb) { *this = std::move(fb); }
+	/**
+	 * Cancels outstanding prefetches and waits for those in progress.
+	 * Must be called by subclass destructors before anything GetFileImpl
+	 * relies on is released.
+	 */
+	void StopPrefetch();
+
+	/**
+	 * Hands out up to <maxReaders> read-handles (e.g. minizip or 7z streams,
+	 * none of which are thread-safe) on one archive, creating them on demand
+	 * and blocking further readers while all are in use.
+	 */
+	template<typename Reader> class ReaderPool {
+	public:
+		void SetMaxReaders(unsigned int n) { maxReaders = std::max(n, 1u); }
+		void AddReader(std::unique_ptr<Reader> reader) {
+			std::lock_guard<spring::mutex> lock(poolMutex);
+
+			freeReaders.push_back(reader.get());
+			readers.emplace_back(std::move(reader));
+		}
+
+		/// returns nullptr if a new reader had to be created and <createReader> failed
+		template<typename CreateFunc> Reader* Acquire(CreateFunc&& createReader) {
+			{
+				std::unique_lock<spring::mutex> lock(poolMutex);
+
+				poolCond.wait(lock, [&]() { return (!freeReaders.empty() || readers.size() < maxReaders); });
+
+				if (!freeReaders.empty()) {
+					Reader* reader = freeReaders.back();
+					freeReaders.pop_back();
+					return reader;
+				}
+
+				// reserve the slot, opening happens outside the lock
+				readers.emplace_back(nullptr);
+			}
+
+			std::unique_ptr<Reader> reader = createReader();
+			Reader* readerPtr = reader.get();
+
+			std::lock_guard<spring::mutex> lock(poolMutex);
+
+			const auto iter = std::find(readers.begin(), readers.end(), nullptr);
+
+			if (readerPtr != nullptr) {
+				*iter = std::move(reader);
+			} else {
+				readers.erase(iter);
+				poolCond.notify_one();
+			}
+
+			return readerPtr;
+		}
+
+		void Release(Reader* reader) {
+			{
+				std::lock_guard<spring::mutex> lock(poolMutex);
+				freeReaders.push_back(reader);
+			}
+
+			poolCond.notify_one();
+		}
 
-		FileBuffer& operator = (const FileBuffer& fb) = delete;
-		FileBuffer& operator = (FileBuffer&& fb) = default;
+		/// destroys all readers, none may be in use
+		void Clear() {
+			std::lock_guard<spring::mutex> lock(poolMutex);
 
+			assert(freeReaders.size() == readers.size());
+
+			freeReaders.clear();
+			readers.clear();
+		}
+
+	private:
+		spring::mutex poolMutex;
+		spring::condition_variable poolCond;
+
+		std::vector< std::unique_ptr<Reader> > readers;
+		std::vector<Reader*> freeReaders;
+
+		unsigned int maxReaders = 1;
+	};
+
+private:
+	struct CacheEntry {
+		CBufferedArchive* archive;
+		unsigned int fid;
+	};
+
+	struct FileBuffer {
 		bool populated = false; // files may be empty (0 bytes)
 		bool exists = false;
 
-		std::vector<std::uint8_t> data;
+		std::shared_ptr< const std::vector<std::uint8_t> > data;
+		// position in cacheList if populated and exists
+		std::list<CacheEntry>::iterator cacheIter;
 	};
 
-	// indexed by file-id
-	std::vector<FileBuffer> fileCache;
-	// neither 7zip (.sd7) nor minizip (.sdz) are thread-safe
-	// zlib (used to extract pool archive .gz entries) should
-	// not need this, but currently each buffered GetFileImpl
-	// call is protected
-	static spring::mutex archiveLock;
+	bool ExtractFile(unsigned int fid, std::vector<std::uint8_t>& buffer);
+	void PrefetchFile(unsigned int fid, std::vector<std::uint8_t>& buffer);
+
+	void AddCacheEntry(unsigned int fid, bool exists, std::shared_ptr< const std::vector<std::uint8_t> >&& data);
+	static void EvictCacheEntries(size_t maxCacheSize);
 
 private:
+	// serialize requests for the same file (and only roughly those for others)
+	static constexpr size_t NUM_FILE_LOCKS = 16;
+
+	std::array<spring::mutex, NUM_FILE_LOCKS> fileLocks;
+
+	// indexed by file-id, only accessed under cacheMutex
+	std::vector<FileBuffer> fileCache;
+
+	// shared by all archives; most recently used entries are at the front
+	static spring::mutex cacheMutex;
+	static std::list<CacheEntry> cacheList;
+	static CacheStats cacheStats;
+
+	spring::mutex prefetchMutex;
+	spring::condition_variable prefetchCond;
+
+	unsigned int numPrefetchTasks = 0;
+	std::atomic<bool> stopPrefetch = {false};
+
 	uint32_t cacheSize = 0;
 	uint32_t fileCount = 0;
 
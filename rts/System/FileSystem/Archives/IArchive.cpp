@@ -2,6 +2,8 @@
 
 #include "IArchive.h"
 
+#include "System/FileSystem/FileSystem.h"
+#include "System/SpringRegex.h"
 #include "System/StringUtil.h"
 
 unsigned int IArchive::FindFile(const std::string& filePath) const
@@ -39,3 +41,23 @@ bool IArchive::GetFile(const std::string& name, std::vector<std::uint8_t>& buffe
 	return true;
 }
 
+
+void IArchive::PrefetchMatchingFiles(const std::string& pattern)
+{
+	const spring::regex regexPattern{FileSystem::ConvertGlobToRegex(pattern), spring::regex::icase};
+
+	std::vector<unsigned int> fids;
+	std::string name;
+	int size;
+
+	for (unsigned int fid = 0; fid < NumFiles(); fid++) {
+		FileInfo(fid, name, size);
+
+		if (!spring::regex_match(name, regexPattern))
+			continue;
+
+		fids.push_back(fid);
+	}
+
+	PrefetchFiles(fids);
+}
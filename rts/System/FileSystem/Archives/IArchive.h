@@ -82,6 +82,20 @@ public:
 	 */
 	bool GetFile(const std::string& name, std::vector<std::uint8_t>& buffer);
 
+	/**
+	 * Hints that the given files will be read soon. Archives that can do so
+	 * start extracting them in the background, such that a later GetFile
+	 * finds them in memory; the others ignore this.
+	 * @param fids file IDs in [0, NumFiles()), most urgent first
+	 */
+	virtual void PrefetchFiles(const std::vector<unsigned int>& fids) {}
+	/**
+	 * Prefetches all files whose VFS path matches a glob pattern.
+	 * @param pattern for example "luarules/gadgets/*.lua", case-insensitive
+	 * @see PrefetchFiles(const std::vector<unsigned int>& fids)
+	 */
+	void PrefetchMatchingFiles(const std::string& pattern);
+
 	std::pair<std::string, int> FileInfo(unsigned int fid) const {
 		std::pair<std::string, int> info;
 		FileInfo(fid, info.first, info.second);
@@ -100,6 +100,8 @@ CPoolArchive::CPoolArchive(const std::string& name): CBufferedArchive(name)
 
 CPoolArchive::~CPoolArchive()
 {
+	StopPrefetch();
+
 	const std::string& archiveFile = GetArchiveFile();
 	const std::pair<uint64_t, uint64_t>& sums = GetSums();
 
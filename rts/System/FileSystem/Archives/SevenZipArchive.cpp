@@ -67,7 +67,6 @@ static Bool Utf16_To_Utf8(char* dest, size_t* destLen, const UInt16* src, size_t
 
 int CSevenZipArchive::GetFileName(const CSzArEx* db, int i)
 {
-	// caller has archiveLock
 	const size_t len = SzArEx_GetFileNameUtf16(db, i, nullptr);
 
 	if (len >= sizeof(tempBuffer))
@@ -129,10 +128,32 @@ static inline const char* GetSystemErrorStr(WRes wres)
 
 
 
-CSevenZipArchive::CSevenZipArchive(const std::string& name): CBufferedArchive(name, false)
+CSevenZipArchive::SevenZipReader::~SevenZipReader()
+{
+	if (outBuffer != nullptr)
+		IAlloc_Free(allocImp, outBuffer);
+
+	if (isOpen)
+		File_Close(&archiveStream.file);
+}
+
+bool CSevenZipArchive::SevenZipReader::Open(const std::string& name, WRes* wres)
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
+	if ((*wres = InFile_Open(&archiveStream.file, name.c_str())) != 0)
+		return false;
 
+	FileInStream_CreateVTable(&archiveStream);
+	LookToRead_CreateVTable(&lookStream, False);
+
+	lookStream.realStream = &archiveStream.s;
+	LookToRead_Init(&lookStream);
+
+	return (isOpen = true);
+}
+
+
+CSevenZipArchive::CSevenZipArchive(const std::string& name): CBufferedArchive(name, false)
+{
 	allocImp.Alloc = SzAlloc;
 	allocImp.Free = SzFree;
 	allocTempImp.Alloc = SzAllocTemp;
@@ -140,21 +161,22 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name): CBufferedArchive(na
 
 	SzArEx_Init(&db);
 
-	const WRes wres = InFile_Open(&archiveStream.file, name.c_str());
-	if (wres) {
+	std::unique_ptr<SevenZipReader> reader = std::make_unique<SevenZipReader>(&allocImp);
+	WRes wres = 0;
+
+	if (!reader->Open(name, &wres)) {
 		LOG_L(L_ERROR, "[%s] error opening \"%s\": %s (%i)", __func__, name.c_str(), GetSystemErrorStr(wres), (int) wres);
 		return;
 	}
 
-	FileInStream_CreateVTable(&archiveStream);
-	LookToRead_CreateVTable(&lookStream, False);
+	CRC::InitTable();
 
-	lookStream.realStream = &archiveStream.s;
-	LookToRead_Init(&lookStream);
+	const SRes res = SzArEx_Open(&db, &reader->lookStream.s, &allocImp, &allocTempImp);
 
-	CRC::InitTable();
+	// the stream used for opening becomes the first reader
+	readerPool.SetMaxReaders(MAX_READERS);
+	readerPool.AddReader(std::move(reader));
 
-	const SRes res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
 	if (!(isOpen = (res == SZ_OK))) {
 		LOG_L(L_ERROR, "[%s] error opening \"%s\": %s", __func__, name.c_str(), GetErrorStr(res));
 		return;
@@ -224,13 +246,10 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name): CBufferedArchive(na
 
 CSevenZipArchive::~CSevenZipArchive()
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
+	StopPrefetch();
 
-	if (outBuffer != nullptr)
-		IAlloc_Free(&allocImp, outBuffer);
-
-	if (isOpen)
-		File_Close(&archiveStream.file);
+	// readers free their buffers through allocImp
+	readerPool.Clear();
 
 	SzArEx_Free(&db, &allocImp);
 }
@@ -238,18 +257,34 @@ CSevenZipArchive::~CSevenZipArchive()
 
 int CSevenZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
-	// assert(archiveLock.locked());
 	assert(IsFileId(fid));
 
+	SevenZipReader* reader = readerPool.Acquire([&]() {
+		std::unique_ptr<SevenZipReader> r = std::make_unique<SevenZipReader>(&allocImp);
+		WRes wres = 0;
+
+		if (!r->Open(archiveFile, &wres))
+			r.reset();
+
+		return r;
+	});
+
+	if (reader == nullptr)
+		return 0;
+
 	size_t offset = 0;
 	size_t outSizeProcessed = 0;
 
-	if (SzArEx_Extract(&db, &lookStream.s, fileEntries[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp) != SZ_OK)
-		return 0;
+	int ret = 0;
+
+	if (SzArEx_Extract(&db, &reader->lookStream.s, fileEntries[fid].fp, &reader->blockIndex, &reader->outBuffer, &reader->outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp) == SZ_OK) {
+		buffer.resize(outSizeProcessed);
+		memcpy(buffer.data(), reinterpret_cast<char*>(reader->outBuffer) + offset, outSizeProcessed);
+		ret = 1;
+	}
 
-	buffer.resize(outSizeProcessed);
-	memcpy(buffer.data(), reinterpret_cast<char*>(outBuffer) + offset, outSizeProcessed);
-	return 1;
+	readerPool.Release(reader);
+	return ret;
 }
 
 void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
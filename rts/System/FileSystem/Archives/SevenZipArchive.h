@@ -71,6 +71,30 @@ private:
 	 * @see FileEntry#unpackedSize
 	 */
 	static constexpr size_t COST_LIMIT_DISK_READ = 32 * 1024;
+	/**
+	 * Each reader keeps the last solid block it unpacked in memory, which
+	 * can be large; more readers than this are not worth that.
+	 */
+	static constexpr unsigned int MAX_READERS = 4;
+
+	/// a file-stream plus the solid block last extracted through it
+	struct SevenZipReader {
+		SevenZipReader(ISzAlloc* alloc): allocImp(alloc) {}
+		~SevenZipReader();
+
+		bool Open(const std::string& name, WRes* wres);
+
+		UInt32 blockIndex = 0xFFFFFFFF;
+		size_t outBufferSize = 0;
+
+		Byte* outBuffer = nullptr;
+
+		CFileInStream archiveStream;
+		CLookToRead lookStream;
+		ISzAlloc* allocImp;
+
+		bool isOpen = false;
+	};
 
 	// actual data is in BufferedArchive
 	struct FileEntry {
@@ -104,19 +128,16 @@ private:
 
 	std::vector<FileEntry> fileEntries;
 
-	UInt32 blockIndex = 0xFFFFFFFF;
-	size_t outBufferSize = 0;
-
-	Byte* outBuffer = nullptr;
 	// used for file names
 	UInt16 tempBuffer[2048];
 
-	CFileInStream archiveStream;
+	// read-only once opened, shared by all readers
 	CSzArEx db;
-	CLookToRead lookStream;
 	ISzAlloc allocImp;
 	ISzAlloc allocTempImp;
 
+	ReaderPool<SevenZipReader> readerPool;
+
 	bool isOpen = false;
 };
 
@@ -19,9 +19,9 @@ IArchive* CZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
 
 CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archiveName)
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
+	unzFile zip = unzOpen(archiveName.c_str());
 
-	if ((zip = unzOpen(archiveName.c_str())) == nullptr) {
+	if (zip == nullptr) {
 		LOG_L(L_ERROR, "[%s] error opening \"%s\"", __func__, archiveName.c_str());
 		return;
 	}
@@ -59,16 +59,18 @@ CZipArchive::CZipArchive(const std::string& archiveName): CBufferedArchive(archi
 		lcNameIndex.emplace(StringToLower(fd.origName), fileEntries.size());
 		fileEntries.emplace_back(std::move(fd));
 	}
+
+	// the handle used for listing becomes the first reader
+	readerPool.SetMaxReaders(spring::thread::hardware_concurrency());
+	readerPool.AddReader(std::make_unique<ZipReader>(zip));
+
+	isOpen = true;
 }
 
 CZipArchive::~CZipArchive()
 {
-	std::lock_guard<spring::mutex> lck(archiveLock);
-
-	if (zip != nullptr) {
-		unzClose(zip);
-		zip = nullptr;
-	}
+	StopPrefetch();
+	readerPool.Clear();
 }
 
 
@@ -83,16 +85,31 @@ void CZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 
 // To simplify things, files are always read completely into memory from
 // the zip-file, since zlib does not provide any way of reading more
-// than one file at a time
+// than one file at a time (per handle, hence the readerPool)
 int CZipArchive::GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer)
 {
 	// Prevent opening files on missing/invalid archives
-	if (zip == nullptr)
+	if (!isOpen)
 		return -4;
 
-	// assert(archiveLock.locked());
 	assert(IsFileId(fid));
 
+	ZipReader* reader = readerPool.Acquire([&]() {
+		unzFile file = unzOpen(archiveFile.c_str());
+		return ((file != nullptr)? std::make_unique<ZipReader>(file): nullptr);
+	});
+
+	if (reader == nullptr)
+		return -4;
+
+	const int ret = ReadFile(reader->file, fid, buffer);
+
+	readerPool.Release(reader);
+	return ret;
+}
+
+int CZipArchive::ReadFile(unzFile zip, unsigned int fid, std::vector<std::uint8_t>& buffer)
+{
 	unzGoToFilePos(zip, &fileEntries[fid].fp);
 
 	unz_file_info fi;
@@ -35,7 +35,7 @@ public:
 
 	int GetType() const override { return ARCHIVE_TYPE_SDZ; }
 
-	bool IsOpen() override { return (zip != nullptr); }
+	bool IsOpen() override { return isOpen; }
 
 	unsigned int NumFiles() const override { return (fileEntries.size()); }
 	void FileInfo(unsigned int fid, std::string& name, int& size) const override;
@@ -48,7 +48,15 @@ public:
 	#endif
 
 protected:
-	unzFile zip;
+	struct ZipReader {
+		ZipReader(unzFile f): file(f) {}
+		~ZipReader() { unzClose(file); }
+
+		unzFile file;
+	};
+
+	/// one minizip handle per concurrent reader
+	ReaderPool<ZipReader> readerPool;
 
 	// actual data is in BufferedArchive
 	struct FileEntry {
@@ -60,7 +68,10 @@ protected:
 
 	std::vector<FileEntry> fileEntries;
 
+	bool isOpen = false;
+
 	int GetFileImpl(unsigned int fid, std::vector<std::uint8_t>& buffer) override;
+	int ReadFile(unzFile zip, unsigned int fid, std::vector<std::uint8_t>& buffer);
 };
 
 #endif // _ZIP_ARCHIVE_H
@@ -283,6 +283,29 @@ bool FileSystemAbstraction::DeleteFile(const std::string& file)
 	return true;
 }
 
+bool FileSystemAbstraction::RenameFile(const std::string& src, const std::string& dst)
+{
+#ifdef _WIN32
+	// rename() refuses to replace an existing file on windows
+	if (!MoveFileExA(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		LPSTR messageBuffer = nullptr;
+		FormatMessageA(
+			FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+			nullptr, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPSTR) &messageBuffer, 0, nullptr);
+		LOG_L(L_WARNING, "[FSA::%s] error '%s' renaming file '%s' to '%s'", __func__, messageBuffer, src.c_str(), dst.c_str());
+		LocalFree(messageBuffer);
+		return false;
+	}
+#else
+	if (rename(src.c_str(), dst.c_str()) != 0) {
+		LOG_L(L_WARNING, "[FSA::%s] error '%s' renaming file '%s' to '%s'", __func__, strerror(errno), src.c_str(), dst.c_str());
+		return false;
+	}
+#endif
+
+	return true;
+}
+
 
 bool FileSystemAbstraction::FileExists(const std::string& file)
 {
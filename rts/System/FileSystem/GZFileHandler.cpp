@@ -47,6 +47,13 @@ bool CGZFileHandler::ReadToBuffer(const std::string& path)
 	while (true) {
 		int unzippedBytes = gzread(file, unzipBuffer, BUFFER_SIZE);
 		if (unzippedBytes < 0) {
+			int errnum = Z_OK;
+			gzerror(file, &errnum);
+
+			// truncated (e.g. a demo streamed by a crashed client), keep what was complete
+			if (errnum == Z_BUF_ERROR && !fileBuffer.empty())
+				break;
+
 			fileBuffer.clear();
 			fileSize = -1;
 			gzclose(file);
@@ -86,7 +93,8 @@ bool CGZFileHandler::UncompressBuffer()
 		zstream.avail_out = BUFFER_SIZE;
 		zstream.next_out = unzipBuffer;
 		const int ret = inflate(&zstream, Z_NO_FLUSH);
-		if (ret != Z_OK) {
+		if (ret != Z_OK && ret != Z_STREAM_END) {
+			inflateEnd(&zstream);
 			fileBuffer.clear();
 			fileSize = -1;
 			return false;
@@ -95,8 +103,13 @@ bool CGZFileHandler::UncompressBuffer()
 		const size_t unzippedBytes = BUFFER_SIZE - zstream.avail_out;
 		fileBuffer.insert(fileBuffer.end(), unzipBuffer, unzipBuffer + unzippedBytes);
 
-		if (ret == Z_STREAM_END)
+		if (ret != Z_STREAM_END)
+			continue;
+		// concatenated gzip members are one stream, as for gzread
+		if (zstream.avail_in == 0)
 			break;
+
+		inflateReset(&zstream);
 	}
 
 	inflateEnd(&zstream);
@@ -0,0 +1,94 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MappedFile.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <windows.h>
+#endif
+
+
+#ifndef _WIN32
+CMappedFile::CMappedFile(const std::string& fileName)
+{
+	const int fd = open(fileName.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return;
+
+	struct stat info;
+
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (addr != MAP_FAILED) {
+			data = reinterpret_cast<const uint8_t*>(addr);
+			size = info.st_size;
+		}
+	}
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+}
+
+CMappedFile::~CMappedFile()
+{
+	if (data == nullptr)
+		return;
+
+	munmap(const_cast<uint8_t*>(data), size);
+}
+
+#else
+
+CMappedFile::CMappedFile(const std::string& fileName)
+{
+	HANDLE file = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize;
+
+	// CreateFileMapping refuses empty files
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return;
+	}
+
+	void* addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (addr == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+
+	data = reinterpret_cast<const uint8_t*>(addr);
+	size = fileSize.QuadPart;
+
+	fileHandle = file;
+	mapHandle = mapping;
+}
+
+CMappedFile::~CMappedFile()
+{
+	if (data == nullptr)
+		return;
+
+	UnmapViewOfFile(data);
+	CloseHandle(mapHandle);
+	CloseHandle(fileHandle);
+}
+#endif
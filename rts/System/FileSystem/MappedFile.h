@@ -0,0 +1,39 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cinttypes>
+#include <string>
+
+/**
+ * Maps a file from the raw filesystem read-only into memory.
+ * The contents are paged in on access, which makes this the cheap way to
+ * look at (parts of) large files whose layout is known up front; nothing
+ * is copied. Empty and missing files are simply reported as not open.
+ */
+class CMappedFile
+{
+public:
+	CMappedFile(const std::string& fileName);
+	CMappedFile(const CMappedFile&) = delete;
+	~CMappedFile();
+
+	CMappedFile& operator = (const CMappedFile&) = delete;
+
+	bool IsOpen() const { return (data != nullptr); }
+
+	const uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+#endif
+};
+
+#endif // _MAPPED_FILE_H
@@ -10,11 +10,13 @@
 #include "ArchiveScanner.h"
 #include "FileSystem.h"
 #include "System/FileSystem/Archives/IArchive.h"
+#include "System/FileSystem/Archives/BufferedArchive.h"
 #include "System/FileSystem/Archives/DirArchive.h"
 #include "System/Threading/SpringThreading.h"
 #include "System/Exceptions.h"
 #include "System/Log/ILog.h"
 #include "System/SafeUtil.h"
+#include "System/SpringRegex.h"
 #include "System/StringUtil.h"
 
 
@@ -294,6 +296,12 @@ void CVFSHandler::DeleteArchives()
 	for (int section = Section::TempMod; section <= Section::TempMenu; section++) {
 		DeleteArchives(Section(section));
 	}
+
+	const CBufferedArchive::CacheStats& cacheStats = CBufferedArchive::GetCacheStats();
+
+	LOG_L(L_INFO, "[%s::%s<this=%p>] file-cache: %llu hits, %llu misses, %llu evictions, %llu bytes in %llu files still cached", vfsName, __func__, this,
+		(unsigned long long) cacheStats.hits, (unsigned long long) cacheStats.misses, (unsigned long long) cacheStats.evictions,
+		(unsigned long long) cacheStats.numBytes, (unsigned long long) cacheStats.numFiles);
 }
 
 void CVFSHandler::DeleteArchives(Section section)
@@ -458,6 +466,31 @@ int CVFSHandler::LoadFile(const std::string& filePath, std::vector<std::uint8_t>
 	return (fileData.ar->GetFile(normalizedPath, buffer));
 }
 
+void CVFSHandler::PrefetchFiles(const std::string& pattern, Section section)
+{
+	std::lock_guard<decltype(vfsMutex)> lck(vfsMutex);
+
+	assert(section < Section::Count);
+
+	LOG_L(L_DEBUG, "[%s::%s<this=%p>(pattern=\"%s\", section=%d)]", vfsName, __func__, this, pattern.c_str(), section);
+
+	const spring::regex regexPattern{FileSystem::ConvertGlobToRegex(pattern), spring::regex::icase};
+
+	// only ask the archive each file is actually loaded from
+	spring::unsynced_map<IArchive*, std::vector<unsigned int>> archiveFileIDs;
+
+	for (const FileEntry& entry: files[section]) {
+		if (!spring::regex_match(entry.first, regexPattern))
+			continue;
+
+		archiveFileIDs[entry.second.ar].push_back(entry.second.ar->FindFile(entry.first));
+	}
+
+	for (const auto& p: archiveFileIDs) {
+		p.first->PrefetchFiles(p.second);
+	}
+}
+
 int CVFSHandler::FileExists(const std::string& filePath, Section section)
 {
 	LOG_L(L_DEBUG, "[%s::%s<this=%p>(filePath=\"%s\", section=%d)]", vfsName, __func__, this, filePath.c_str(), section);
@@ -104,6 +104,15 @@ public:
 	 */
 	int LoadFile(const std::string& filePath, std::vector<std::uint8_t>& buffer, Section section);
 
+	/**
+	 * Lets the archives holding all files matching a pattern start reading
+	 * them in the background, to speed up later LoadFile calls.
+	 * @param pattern glob pattern, for example "luarules/*.lua",
+	 *   case-insensitive
+	 * @see IArchive::PrefetchFiles
+	 */
+	void PrefetchFiles(const std::string& pattern, Section section);
+
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
@@ -59,6 +59,14 @@ CONFIG(bool, UseNetMessageSmoothingBuffer).defaultValue(true);
 
 CONFIG(bool, LuaWritableConfigFile).defaultValue(true);
 CONFIG(bool, VFSCacheArchiveFiles).defaultValue(true);
+CONFIG(int, VFSCacheMaxSize)
+	.defaultValue(512)
+	.minimumValue(0)
+	.description("Memory budget in MB for archive files cached by the VFS, least recently used ones are dropped beyond it. 0 = no limit");
+CONFIG(int, VFSCacheMaxFileSize)
+	.defaultValue(16 * 1024)
+	.minimumValue(0)
+	.description("Size in KB above which archive files are not cached by the VFS. 0 = no limit");
 
 
 void GlobalConfig::Init()
@@ -87,6 +95,8 @@ void GlobalConfig::Init()
 	useNetMessageSmoothingBuffer = configHandler->GetBool("UseNetMessageSmoothingBuffer");
 	luaWritableConfigFile = configHandler->GetBool("LuaWritableConfigFile");
 	vfsCacheArchiveFiles = configHandler->GetBool("VFSCacheArchiveFiles");
+	vfsCacheMaxSize = configHandler->GetInt("VFSCacheMaxSize");
+	vfsCacheMaxFileSize = configHandler->GetInt("VFSCacheMaxFileSize");
 
 	teamHighlight = configHandler->GetInt("TeamHighlight");
 }
@@ -106,6 +106,21 @@ public:
 	 */
 	bool vfsCacheArchiveFiles = true;
 
+	/**
+	 * @brief vfsCacheMaxSize
+	 *
+	 * Memory budget in MB of the (BufferedArchive) file cache shared by all
+	 * archives, least recently used files are dropped beyond it; 0 = no limit
+	 */
+	int vfsCacheMaxSize = 512;
+
+	/**
+	 * @brief vfsCacheMaxFileSize
+	 *
+	 * Size in KB above which files are never put into the VFS cache; 0 = no limit
+	 */
+	int vfsCacheMaxFileSize = 16 * 1024;
+
 
 	/**
 	 * @brief teamHighlight
@@ -194,14 +194,10 @@ static void LoadLuaState(CSplitLuaHandle* handle, creg::CInputStreamSerializer&
 }
 
 
-void CCregLoadSaveHandler::SaveGame(const std::string& path)
+bool CCregLoadSaveHandler::SaveGameData(std::stringstream& oss)
 {
 #ifdef USING_CREG
-	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
-
 	try {
-		std::stringstream oss;
-
 		// write our own header. SavePackage() will add its own
 		WriteString(oss, SpringVersion::GetSync());
 		WriteString(oss, gameSetup->setupText);
@@ -240,27 +236,8 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
 		}
 
-		{
-			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
-
-			if (file == nullptr) {
-				LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
-				return;
-			}
-
-			std::string data = std::move(oss.str());
-			std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
-				gzwrite(file, data.c_str(), data.size());
-				gzflush(file, Z_FINISH);
-				gzclose(file);
-			};
-
-			// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
-			// need to keep a reference to the future around or its destructor will block
-			ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
-		}
-
 		//FIXME add lua state
+		return true;
 	} catch (const content_error& ex) {
 		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
 	} catch (const std::exception& ex) {
@@ -275,6 +252,36 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 #else //USING_CREG
 	LOG_L(L_ERROR, "[LSH::%s] creg is disabled", __func__);
 #endif //USING_CREG
+
+	return false;
+}
+
+void CCregLoadSaveHandler::SaveGame(const std::string& path)
+{
+	LOG("[LSH::%s] saving game to \"%s\"", __func__, path.c_str());
+
+	std::stringstream oss;
+
+	if (!SaveGameData(oss))
+		return;
+
+	gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
+
+	if (file == nullptr) {
+		LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
+		return;
+	}
+
+	std::string data = std::move(oss.str());
+	std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
+		gzwrite(file, data.c_str(), data.size());
+		gzflush(file, Z_FINISH);
+		gzclose(file);
+	};
+
+	// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
+	// need to keep a reference to the future around or its destructor will block
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
 }
 
 /// loads the data (map&mod-name,setup-script) needed by PreGame
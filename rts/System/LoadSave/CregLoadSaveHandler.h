@@ -17,6 +17,8 @@ public:
 	void LoadGame() override;
 	void LoadAIData() override;
 	void SaveGame(const std::string& path) override;
+	/// serializes the game without writing it out, same format as uncompressed .ssf files
+	bool SaveGameData(std::stringstream& oss);
 
 protected:
 	std::stringstream iss;
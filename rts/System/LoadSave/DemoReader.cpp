@@ -200,3 +200,71 @@ void CDemoReader::LoadStats()
 
 	playbackDemo->Seek(curPos);
 }
+
+
+void CDemoReader::LoadKeyframeIndex()
+{
+	keyframeIndex.clear();
+
+	// no trailing chunks if Spring crashed while writing the demo
+	if (fileHeader.demoStreamSize == 0)
+		return;
+
+	const int curPos = playbackDemo->GetPos();
+	const int trailerPos = playbackDemoSize - sizeof(DemoKeyframeIndexTrailer);
+
+	DemoKeyframeIndexTrailer trailer;
+	memset(&trailer, 0, sizeof(trailer));
+
+	if (trailerPos > (fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize)) {
+		playbackDemo->Seek(trailerPos);
+		playbackDemo->Read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+		trailer.swab();
+	}
+
+	const int indexPos = trailerPos - trailer.numKeyframes * sizeof(DemoKeyframeIndexEntry);
+
+	if (memcmp(trailer.magic, DEMOFILE_KEYFRAME_MAGIC, sizeof(trailer.magic)) != 0 || trailer.entrySize != sizeof(DemoKeyframeIndexEntry)) {
+		playbackDemo->Seek(curPos);
+		return;
+	}
+	if (trailer.numKeyframes < 0 || trailer.dataSize < 0 || (keyframeDataPos = indexPos - trailer.dataSize) < 0) {
+		LOG_L(L_WARNING, "[DemoReader::%s] corrupt keyframe index", __func__);
+		playbackDemo->Seek(curPos);
+		return;
+	}
+
+	keyframeIndex.resize(trailer.numKeyframes);
+	playbackDemo->Seek(indexPos);
+
+	for (DemoKeyframeIndexEntry& entry: keyframeIndex) {
+		playbackDemo->Read(reinterpret_cast<char*>(&entry), sizeof(entry));
+		entry.swab();
+
+		if (entry.dataOffset >= 0 && entry.dataSize > 0 && (entry.dataOffset + entry.dataSize) <= trailer.dataSize)
+			continue;
+
+		LOG_L(L_WARNING, "[DemoReader::%s] corrupt keyframe index", __func__);
+		keyframeIndex.clear();
+		break;
+	}
+
+	playbackDemo->Seek(curPos);
+}
+
+bool CDemoReader::LoadKeyframe(size_t index, std::vector<std::uint8_t>& data)
+{
+	if (index >= keyframeIndex.size())
+		return false;
+
+	const int curPos = playbackDemo->GetPos();
+	const DemoKeyframeIndexEntry& entry = keyframeIndex[index];
+
+	data.resize(entry.dataSize);
+	playbackDemo->Seek(keyframeDataPos + entry.dataOffset);
+
+	const bool ret = (playbackDemo->Read(reinterpret_cast<char*>(data.data()), data.size()) == entry.dataSize);
+
+	playbackDemo->Seek(curPos);
+	return ret;
+}
@@ -55,6 +55,13 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+	/// Reads the keyframe index (empty if the demo has none), not needed for normal demo watching
+	void LoadKeyframeIndex();
+	/// Reads the gzip-compressed save-state of keyframe <index> (see LoadKeyframeIndex)
+	bool LoadKeyframe(size_t index, std::vector<std::uint8_t>& data);
+
+	const std::vector<DemoKeyframeIndexEntry>& GetKeyframeIndex() const { return keyframeIndex; }
+
 private:
 	CFileHandler* playbackDemo;
 
@@ -70,6 +77,10 @@ private:
 	std::vector<PlayerStatistics> playerStats; // one stat per player
 	std::vector< std::vector<TeamStatistics> > teamStats; // many stats per team
 	std::vector<unsigned char> winningAllyTeams;
+
+	std::vector<DemoKeyframeIndexEntry> keyframeIndex;
+	/// file position of the keyframe data
+	int keyframeDataPos = 0;
 };
 
 #endif
@@ -2,7 +2,9 @@
 
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <deque>
 #include <memory>
 
 #include "DemoRecorder.h"
@@ -10,6 +12,7 @@
 #include "Sim/Misc/TeamStatistics.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
@@ -26,31 +29,221 @@
 #endif
 
 
-// server and client memory-streams
-static std::string demoStreams[2];
+CONFIG(int, DemoStreamBlockSize).defaultValue(0).minimumValue(0).description("If greater than 0, demos are compressed and written to disk in blocks of this many KB while the game runs instead of being kept in memory until it ends; a crash then loses at most the last few blocks.");
+CONFIG(int, DemoStreamFlushTime).defaultValue(60).minimumValue(1).description("Seconds of game time after which a partially filled demo block is written anyway (see DemoStreamBlockSize).");
+
+
 static spring::mutex demoMutex;
 
 
+
+static bool CompressGZipMember(const std::string& data, int level, std::string& member)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+
+	// +16 writes a gzip header and trailer
+	if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	member.resize(deflateBound(&zs, data.size()));
+
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	zs.avail_in = data.size();
+	zs.next_out = reinterpret_cast<Bytef*>(&member[0]);
+	zs.avail_out = member.size();
+
+	const int ret = deflate(&zs, Z_FINISH);
+
+	member.resize(zs.total_out);
+	deflateEnd(&zs);
+	return (ret == Z_STREAM_END);
+}
+
+static bool WriteGZipMember(FILE* file, const std::string& data, int level)
+{
+	std::string member;
+
+	if (!CompressGZipMember(data, level, member))
+		return false;
+
+	return (fwrite(member.data(), 1, member.size(), file) == member.size());
+}
+
+
+/**
+ * Writes a demo as a sequence of gzip members while it is being recorded,
+ * which zlib reads back as one stream. The first member holds only the file
+ * header and is stored uncompressed, so it keeps its size and can be
+ * rewritten in place when the header changes. Every following member is
+ * one compressed block of the demo stream (with the stats trailer as the
+ * last block), written by a background thread. A crash leaves a file with
+ * demoStreamSize 0 which is replayed up to its last complete block.
+ */
+class CDemoStreamWriter
+{
+public:
+	CDemoStreamWriter(FILE* file, size_t blockSize, float flushTime)
+		: state(std::make_shared<State>())
+		, blockSize(blockSize)
+		, flushTime(flushTime)
+	{
+		state->file = file;
+		thread = std::move(spring::thread([s = state]() { Run(*s); }));
+	}
+
+	~CDemoStreamWriter() {
+		if (!thread.joinable())
+			return;
+
+		Push({{}, Item::Close});
+		thread.join();
+	}
+
+	size_t GetBlockSize() const { return blockSize; }
+	bool WantsBlock(size_t size, float modGameTime) const { return (size >= blockSize || (modGameTime - blockTime) >= flushTime); }
+
+	void WriteBlock(std::string&& data, float modGameTime) {
+		blockTime = modGameTime;
+		Push({std::move(data), Item::Block});
+	}
+	void WriteHeader(const DemoFileHeader& header) {
+		Push({std::string(reinterpret_cast<const char*>(&header), sizeof(header)), Item::Header});
+	}
+
+	void Close() {
+		Push({{}, Item::Close});
+
+		// NOTE: workers are already gone when the recorder is destroyed
+		ThreadPool::AddExtJob(std::move(thread));
+	}
+
+private:
+	struct Item {
+		std::string data;
+		enum {Block, Header, Close} type;
+	};
+	struct State {
+		FILE* file = nullptr;
+
+		std::deque<Item> queue;
+
+		spring::mutex mutex;
+		spring::condition_variable_any cond;
+	};
+
+	// bounds the memory held by blocks which are not written yet
+	static constexpr size_t MAX_QUEUED_ITEMS = 4;
+
+	void Push(Item&& item) {
+		std::unique_lock<spring::mutex> lock(state->mutex);
+
+		state->cond.wait(lock, [&]() { return (state->queue.size() < MAX_QUEUED_ITEMS); });
+		state->queue.emplace_back(std::move(item));
+		state->cond.notify_all();
+	}
+
+	static void Run(State& s) {
+		bool error = false;
+
+		while (true) {
+			Item item;
+
+			{
+				std::unique_lock<spring::mutex> lock(s.mutex);
+
+				s.cond.wait(lock, [&]() { return (!s.queue.empty()); });
+				item = std::move(s.queue.front());
+				s.queue.pop_front();
+				s.cond.notify_all();
+			}
+
+			if (item.type == Item::Close)
+				break;
+			if (error)
+				continue;
+
+			if (item.type == Item::Header) {
+				fseek(s.file, 0, SEEK_SET);
+				error |= !WriteGZipMember(s.file, item.data, Z_NO_COMPRESSION);
+				fseek(s.file, 0, SEEK_END);
+			} else {
+				error |= !WriteGZipMember(s.file, item.data, Z_BEST_COMPRESSION);
+			}
+
+			error |= (fflush(s.file) != 0);
+
+			if (error)
+				LOG_L(L_ERROR, "[DemoStreamWriter::%s] error writing demo-stream (%s)", __func__, strerror(errno));
+		}
+
+		fclose(s.file);
+	}
+
+private:
+	std::shared_ptr<State> state;
+	spring::thread thread;
+
+	size_t blockSize;
+
+	float flushTime;
+	float blockTime = 0.0f;
+};
+
+
+
+// defined here since streamWriter's type is incomplete in the header
+CDemoRecorder::CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+CDemoRecorder::CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+
 CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
 {
 	std::lock_guard<spring::mutex> lock(demoMutex);
 
-	SetStream();
 	SetName(mapName, modName);
+
+	if (configHandler->GetInt("DemoStreamBlockSize") > 0) {
+		FILE* streamFile = fopen(demoName.c_str(), "wb");
+
+		if (streamFile != nullptr) {
+			streamWriter.reset(new CDemoStreamWriter(streamFile, configHandler->GetInt("DemoStreamBlockSize") * 1024, configHandler->GetInt("DemoStreamFlushTime")));
+		} else {
+			LOG_L(L_ERROR, "[DemoRecorder::%s] could not open \"%s\" for streaming (%s)", __func__, demoName.c_str(), strerror(errno));
+		}
+	}
+
+	SetStream();
 	SetFileHeader();
 	WriteFileHeader(false);
 
+	if (streamWriter != nullptr)
+		return;
+
 	file = gzopen(demoName.c_str(), "wb9");
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (!IsValid())
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
+	WriteKeyframes();
+
+	if (streamWriter != nullptr) {
+		// trailer goes first, the header must only claim a complete stream once it is
+		WriteStreamBlock(0.0f);
+		WriteFileHeader(true);
+
+		LOG("[DemoRecorder::%s] finished streaming %s-demo \"%s\"", __func__, (isServerDemo? "server": "client"), demoName.c_str());
+
+		streamWriter->Close();
+		streamWriter.reset();
+		return;
+	}
+
 	WriteFileHeader(true);
 	WriteDemoFile();
 }
@@ -58,8 +251,8 @@ CDemoRecorder::~CDemoRecorder()
 
 void CDemoRecorder::SetStream()
 {
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	demoStream.clear();
+	demoStream.reserve((streamWriter != nullptr)? streamWriter->GetBlockSize() + 64 * 1024: 8 * 1024 * 1024);
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -83,8 +276,8 @@ void CDemoRecorder::WriteDemoFile()
 	// functions use stdio library routines, and most of zlib's functions use the library memory
 	// allocation routines by default" (so code below should be OK)
 	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
+	// the job owns the data, the recorder (and demoStream) can be gone before it even starts
+	std::function<void(gzFile, std::string)> func = [](gzFile file, std::string data) {
 		std::lock_guard<spring::mutex> lock(demoMutex);
 
 		gzwrite(file, data.c_str(), data.size());
@@ -92,15 +285,23 @@ void CDemoRecorder::WriteDemoFile()
 		gzclose(file);
 	};
 
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
+	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), demoStream.size());
 
 	#ifndef _WIN32
 	// NOTE: can not use ThreadPool for this directly here, workers are already gone
 	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
+	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::move(demoStream)));
 	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(demoStream))));
 	#endif
+
+	demoStream.clear();
+}
+
+void CDemoRecorder::WriteStreamBlock(float modGameTime)
+{
+	streamWriter->WriteBlock(std::move(demoStream), modGameTime);
+	SetStream();
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -111,7 +312,7 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	demoStream.append(text.c_str(), length);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -121,9 +322,14 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+	demoStream.append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
+	demoStream.append(reinterpret_cast<const char*>(buf), length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+
+	if (streamWriter == nullptr || !streamWriter->WantsBlock(demoStream.size(), modGameTime))
+		return;
+
+	WriteStreamBlock(modGameTime);
 }
 
 void CDemoRecorder::SetName(const std::string& mapName, const std::string& modName)
@@ -229,28 +435,33 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
+	if (streamWriter != nullptr) {
+		streamWriter->WriteHeader(tmpHeader);
+		return 0;
+	}
+
+	if (demoStream.empty()) {
+		demoStream.append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
 	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
+		assert(demoStream.size() >= sizeof(tmpHeader));
+		memcpy(&demoStream[0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
 	}
 
-	return (demoStreams[isServerDemo].size());
+	return (demoStream.size());
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoStream.size();
 
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		demoStream.append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(demoStream.size() - pos);
 
 	playerStats.clear();
 }
@@ -263,38 +474,93 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoStream.size();
 
 	// Write the array of winningAllyTeams.
 	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
+		demoStream.append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
 	}
 
 	winningAllyTeams.clear();
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.winningAllyTeamsSize = int(demoStream.size() - pos);
+}
+
+/** @brief Queue a keyframe for WriteKeyframes, compressing it like a .ssf save-file. */
+void CDemoRecorder::AddKeyframe(int frameNum, std::string&& state)
+{
+	const auto compress = [](const std::string& data) {
+		std::string member;
+
+		if (!CompressGZipMember(data, 5, member))
+			member.clear();
+
+		return member;
+	};
+
+	keyframes.emplace_back(frameNum, std::async(std::launch::async, compress, std::move(state)));
+}
+
+/** @brief Write the keyframe chunk at the current position in the file. */
+void CDemoRecorder::WriteKeyframes()
+{
+	if (keyframes.empty())
+		return;
+
+	const size_t pos = demoStream.size();
+
+	std::vector<DemoKeyframeIndexEntry> index;
+	index.reserve(keyframes.size());
+
+	for (auto& keyframe: keyframes) {
+		const std::string data = keyframe.second.get();
+
+		if (data.empty()) {
+			LOG_L(L_WARNING, "[DemoRecorder::%s] could not compress keyframe %d", __func__, keyframe.first);
+			continue;
+		}
+
+		index.push_back({keyframe.first, int(demoStream.size() - pos), int(data.size())});
+		demoStream.append(data);
+	}
+
+	DemoKeyframeIndexTrailer trailer;
+	memset(&trailer, 0, sizeof(trailer));
+	strcpy(trailer.magic, DEMOFILE_KEYFRAME_MAGIC);
+	trailer.numKeyframes = index.size();
+	trailer.entrySize = sizeof(DemoKeyframeIndexEntry);
+	trailer.dataSize = int(demoStream.size() - pos);
+	trailer.swab();
+
+	for (DemoKeyframeIndexEntry& entry: index) {
+		entry.swab();
+		demoStream.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	}
+
+	demoStream.append(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+	keyframes.clear();
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = demoStream.size();
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		demoStream.append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			demoStream.append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(demoStream.size() - pos);
 
 	teamStats.clear();
 }
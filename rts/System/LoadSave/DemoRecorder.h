@@ -3,6 +3,8 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <future>
+#include <memory>
 #include <vector>
 #include <sstream>
 #include <zlib.h>
@@ -11,6 +13,7 @@
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
+class CDemoStreamWriter;
 
 /**
  * @brief Used to record demos
@@ -18,11 +21,11 @@
 class CDemoRecorder : public CDemo
 {
 public:
-	CDemoRecorder() { memset(&fileHeader, 0, sizeof(fileHeader)); }
+	CDemoRecorder();
 	CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo);
 
 	CDemoRecorder(const CDemoRecorder&) = delete;
-	CDemoRecorder(CDemoRecorder&& r) { *this = std::move(r); }
+	CDemoRecorder(CDemoRecorder&& r);
 
 	~CDemoRecorder();
 
@@ -33,18 +36,21 @@ public:
 		memset(&r.fileHeader, 0, sizeof(fileHeader));
 
 		std::swap(file, r.file);
+		std::swap(streamWriter, r.streamWriter);
 
 		std::swap(demoName, r.demoName);
+		std::swap(demoStream, r.demoStream);
 		std::swap(playerStats, r.playerStats);
 		std::swap(teamStats, r.teamStats);
 		std::swap(winningAllyTeams, r.winningAllyTeams);
+		std::swap(keyframes, r.keyframes);
 
 		std::swap(isServerDemo, r.isServerDemo);
 		return *this;
 	}
 
 
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (file != nullptr || streamWriter != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
@@ -62,21 +68,36 @@ public:
 	void SetTeamStats(int teamNum, const std::vector<TeamStatistics>& stats);
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
+	/// <state> is an uncompressed creg save-state made right after <frameNum>
+	void AddKeyframe(int frameNum, std::string&& state);
+
 private:
 	unsigned int WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
+	void WriteKeyframes();
 	void WriteDemoFile();
+	void WriteStreamBlock(float modGameTime);
 
 private:
 	gzFile file = nullptr;
 
+	// non-null if the demo is written to disk while recording
+	std::unique_ptr<CDemoStreamWriter> streamWriter;
+
+	// memory-stream of the demo, or of its current block if streaming
+	// (per recorder, a process can host several servers)
+	std::string demoStream;
+
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
 	std::vector<unsigned char> winningAllyTeams;
 
+	// compressed in the background, appended after the stats
+	std::vector< std::pair<int, std::future<std::string>> > keyframes;
+
 	bool isServerDemo = false;
 };
 
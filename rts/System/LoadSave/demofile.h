@@ -40,6 +40,7 @@
  *         CTeam::Statistics for each team.
  *       - Array of all CTeam::Statistics (total number of items is the
  *         sum of the elements in the array of dwords).
+ *     - Optional keyframe chunk (see DemoKeyframeIndexEntry)
  *
  * The header is designed to be extensible: it contains a version field and a
  * headerSize field to support this. The version field is a major version number
@@ -115,6 +116,48 @@ struct DemoStreamChunkHeader
 	}
 };
 
+/** The last 16 bytes of the keyframe index, if a demofile has one. */
+#define DEMOFILE_KEYFRAME_MAGIC "spring keyframe"
+
+/**
+ * @brief Spring demo keyframe index entry
+ *
+ * Demos recorded with DemoKeyframeInterval > 0 have a keyframe chunk after
+ * the team statistics (unstable, older readers ignore it):
+ *
+ * - Keyframe data, one gzip-compressed creg save-state (.ssf) per keyframe
+ * - DemoKeyframeIndexEntry for each keyframe, sorted by frameNum
+ * - DemoKeyframeIndexTrailer
+ */
+struct DemoKeyframeIndexEntry
+{
+	int frameNum;   ///< Frame after which the save-state was made.
+	int dataOffset; ///< Offset of the save-state from the start of the keyframe data.
+	int dataSize;   ///< Size of the save-state.
+
+	/// Change structure from host endian to little endian or vice versa.
+	void swab() {
+		swabDWordInPlace(frameNum);
+		swabDWordInPlace(dataOffset);
+		swabDWordInPlace(dataSize);
+	}
+};
+
+struct DemoKeyframeIndexTrailer
+{
+	int numKeyframes;   ///< Number of DemoKeyframeIndexEntry's preceding this trailer.
+	int entrySize;      ///< sizeof(DemoKeyframeIndexEntry)
+	int dataSize;       ///< Size of all keyframe data preceding the index.
+	char magic[16];     ///< DEMOFILE_KEYFRAME_MAGIC
+
+	/// Change structure from host endian to little endian or vice versa.
+	void swab() {
+		swabDWordInPlace(numKeyframes);
+		swabDWordInPlace(entrySize);
+		swabDWordInPlace(dataSize);
+	}
+};
+
 #pragma pack(pop)
 
 #endif // DEMO_FILE_H
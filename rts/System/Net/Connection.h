@@ -70,6 +70,18 @@ public:
 	virtual void Unmute() = 0;
 	virtual void Close(bool flush = false) = 0;
 	virtual void SetLossFactor(int factor) = 0;
+	/**
+	 * @brief allow compressing outgoing data
+	 * Only call this once the other end is known to run the same protocol.
+	 */
+	virtual void EnableCompression() {}
+
+	/**
+	 * @brief mark as serviced (sent to and updated) by a relay thread
+	 * Owners like UDPListener then skip it in their own Update.
+	 */
+	void SetRelayed(bool b) { relayed = b; }
+	bool IsRelayed() const { return relayed; }
 
 	/**
 	 * @brief update internals
@@ -81,6 +93,8 @@ protected:
 	unsigned int dataSent = 0;
 	unsigned int dataRecv = 0;
 	unsigned int numPings = 0;
+
+	bool relayed = false;
 };
 
 } // namespace netcode
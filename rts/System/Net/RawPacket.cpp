@@ -1,19 +1,111 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <string.h>
+#include <array>
 #include <stdexcept>
 
 #include "RawPacket.h"
 
 #include "System/Log/ILog.h"
+#include "System/Threading/SpringThreading.h"
 
 namespace netcode
 {
 
+// block sizes are MIN_BLOCK_SIZE << i for each class i, larger requests go to the heap
+static constexpr size_t NUM_SIZE_CLASSES = 9;
+static constexpr size_t MIN_BLOCK_SIZE = 32;
+static constexpr size_t SLAB_SIZE = 64 * 1024;
+// each block starts with its size-class index, data follows
+static constexpr size_t BLOCK_HEADER_SIZE = 8;
+
+static_assert(alignof(RawPacket) <= BLOCK_HEADER_SIZE, "");
+static_assert((MIN_BLOCK_SIZE << (NUM_SIZE_CLASSES - 1)) <= SLAB_SIZE, "");
+
+struct FreeBlock {
+	FreeBlock* next;
+};
+
+struct SizeClass {
+	spring::spinlock lock;
+	FreeBlock* freeList;
+};
+
+// trivially destructible on purpose: packets held by other statics
+// (e.g. CLocalConnection's queues) can outlive any pool destructor,
+// so slabs are simply kept until the process exits
+static SizeClass* GetSizeClasses()
+{
+	static std::array<SizeClass, NUM_SIZE_CLASSES> sizeClasses = {};
+	return sizeClasses.data();
+}
+
+
+uint8_t* RawPacket::AllocData(size_t size)
+{
+	const size_t blockSize = size + BLOCK_HEADER_SIZE;
+
+	size_t classIdx = 0;
+	uint8_t* block = nullptr;
+
+	while (classIdx < NUM_SIZE_CLASSES && (MIN_BLOCK_SIZE << classIdx) < blockSize) {
+		classIdx++;
+	}
+
+	if (classIdx == NUM_SIZE_CLASSES) {
+		block = new uint8_t[blockSize];
+	} else {
+		SizeClass& sc = GetSizeClasses()[classIdx];
+
+		std::lock_guard<spring::spinlock> lock(sc.lock);
+
+		if (sc.freeList == nullptr) {
+			// carve a new slab into blocks, memory is never returned
+			uint8_t* slab = new uint8_t[SLAB_SIZE];
+
+			for (size_t offset = 0; offset < SLAB_SIZE; offset += (MIN_BLOCK_SIZE << classIdx)) {
+				FreeBlock* fb = reinterpret_cast<FreeBlock*>(slab + offset);
+				fb->next = sc.freeList;
+				sc.freeList = fb;
+			}
+		}
+
+		block = reinterpret_cast<uint8_t*>(sc.freeList);
+		sc.freeList = sc.freeList->next;
+	}
+
+	block[0] = classIdx;
+	return (block + BLOCK_HEADER_SIZE);
+}
+
+void RawPacket::FreeData(void* p)
+{
+	if (p == nullptr)
+		return;
+
+	uint8_t* block = reinterpret_cast<uint8_t*>(p) - BLOCK_HEADER_SIZE;
+
+	const size_t classIdx = block[0];
+
+	if (classIdx == NUM_SIZE_CLASSES) {
+		delete[] block;
+		return;
+	}
+
+	SizeClass& sc = GetSizeClasses()[classIdx];
+
+	std::lock_guard<spring::spinlock> lock(sc.lock);
+
+	FreeBlock* fb = reinterpret_cast<FreeBlock*>(block);
+	fb->next = sc.freeList;
+	sc.freeList = fb;
+}
+
+
 RawPacket::RawPacket(const uint8_t* const tdata, const uint32_t newLength): length(newLength)
 {
 	if (length > 0) {
-		data = new uint8_t[length];
+		data = AllocData(length);
 		memcpy(data, tdata, length);
 	} else {
 		LOG_L(L_ERROR, "[%s] tried to pack a zero-length packet", __func__);
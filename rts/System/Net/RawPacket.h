@@ -19,6 +19,10 @@ namespace netcode
 
 /**
  * @brief simple structure to hold some data
+ *
+ * Packets and their data are allocated from a process-wide pool of
+ * size-classed slabs (see RawPacket.cpp) rather than the heap, since
+ * every network message creates at least one of each.
  */
 class RawPacket
 {
@@ -40,7 +44,7 @@ public:
 		if (length == 0)
 			return;
 
-		data = new uint8_t[length];
+		data = AllocData(length);
 	}
 
 	RawPacket(const uint32_t length, uint8_t msgID): RawPacket(length) {
@@ -52,6 +56,9 @@ public:
 
 	~RawPacket() { Delete(); }
 
+	static void* operator new(size_t size) { return AllocData(size); }
+	static void operator delete(void* p) { FreeData(p); }
+
 
 	RawPacket& operator = (const RawPacket&  p) = delete;
 	RawPacket& operator = (      RawPacket&& p) {
@@ -112,12 +119,16 @@ public:
 
 	uint8_t* GetWritingPos() { return (data + pos); }
 
+	/// blocks remember their size-class, <length> may shrink in between
+	static uint8_t* AllocData(size_t size);
+	static void FreeData(void* p);
+
 
 	void Delete() {
-		if (length == 0)
+		if (data == nullptr)
 			return;
 
-		delete[] data;
+		FreeData(data);
 		data = nullptr;
 
 		length = 0;
@@ -3,7 +3,7 @@
 #include "UDPConnection.h"
 
 #include <cinttypes>
-
+#include <zlib.h>
 
 #include "Socket.h"
 #include "ProtocolDef.h"
@@ -18,6 +18,7 @@
 
 #ifndef UNIT_TEST
 CONFIG(bool, UDPConnectionLogDebugMessages).defaultValue(false);
+CONFIG(bool, UDPConnectionCompression).defaultValue(false).description("Compress outgoing network traffic with zlib (hosts start once a client was accepted, clients once the host does).");
 #endif
 
 
@@ -28,6 +29,10 @@ static constexpr unsigned udpMaxPacketSize = 4096;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
 
+// smaller blocks rarely compress, larger ones would exceed NETMSG_COMPRESSED's size-field
+static constexpr unsigned minCompressedBlockInput = 64;
+static constexpr unsigned maxCompressedBlockInput = 8192;
+
 
 
 #if NETWORK_TEST
@@ -231,16 +236,22 @@ void Packet::Serialize(std::vector<std::uint8_t>& data)
 
 
 
-UDPConnection::UDPConnection(std::shared_ptr<ip::udp::socket> netSocket, const ip::udp::endpoint& myAddr)
+UDPConnection::UDPConnection(
+	std::shared_ptr<ip::udp::socket> netSocket,
+	std::shared_ptr<spring::mutex> netSocketMutex,
+	const ip::udp::endpoint& myAddr
+)
 	: addr(myAddr)
 	, sharedSocket(true)
 	, mySocket(netSocket)
+	, socketMutex(netSocketMutex)
 {
 	Init();
 }
 
 UDPConnection::UDPConnection(int sourcePort, const std::string& address, const unsigned port)
 	: sharedSocket(false)
+	, socketMutex(new spring::mutex())
 {
 	asio::error_code err;
 	addr = ResolveAddr(address, port, &err);
@@ -307,6 +318,11 @@ void UDPConnection::Init()
 	sentPackets = 0;
 	recvPackets = 0;
 	droppedChunks = 0;
+
+	sentUncompressed = 0;
+	recvUncompressed = 0;
+	sentCompressed = 0;
+	recvCompressed = 0;
 	mtu = globalConfig.mtu;
 	reconnectTime = globalConfig.reconnectTimeout;
 
@@ -314,8 +330,13 @@ void UDPConnection::Init()
 	closed = false;
 	resend = false;
 
+	allowCompression = false;
+	compressOutgoing = false;
+	expandFrameBatches = false;
+
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
+	allowCompression = configHandler->GetBool("UDPConnectionCompression");
 	#endif
 
 	netLossFactor = globalConfig.networkLossFactor;
@@ -330,12 +351,17 @@ void UDPConnection::ReconnectTo(CConnection& conn) {
 }
 
 void UDPConnection::CopyConnection(UDPConnection &conn) {
-	conn.InitConnection(addr, mySocket);
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
+	conn.InitConnection(addr, mySocket, socketMutex);
 }
 
-void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket) {
+void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket, std::shared_ptr<spring::mutex> socketMtx) {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	addr = address;
 	mySocket = socket;
+	socketMutex = socketMtx;
 }
 
 UDPConnection::~UDPConnection()
@@ -344,16 +370,25 @@ UDPConnection::~UDPConnection()
 	waitingPackets.clear();
 
 	Flush(true);
+
+	if (deflateStream != nullptr)
+		deflateEnd(deflateStream.get());
+	if (inflateStream != nullptr)
+		inflateEnd(inflateStream.get());
 }
 
 void UDPConnection::SendData(std::shared_ptr<const RawPacket> pkt)
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	assert(pkt->length > 0);
 	outgoingData.push_back(pkt);
 }
 
 std::shared_ptr<const RawPacket> UDPConnection::Peek(unsigned ahead) const
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	if (ahead >= msgQueue.size())
 		return {};
 
@@ -363,6 +398,8 @@ std::shared_ptr<const RawPacket> UDPConnection::Peek(unsigned ahead) const
 #ifdef ENABLE_DEBUG_STATS
 std::shared_ptr<const RawPacket> UDPConnection::GetData()
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	numTotalGetDataCalls++;
 
 	if (!msgQueue.empty()) {
@@ -382,6 +419,8 @@ std::shared_ptr<const RawPacket> UDPConnection::GetData()
 #else
 std::shared_ptr<const RawPacket> UDPConnection::GetData()
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	if (msgQueue.empty())
 		return {};
 
@@ -396,6 +435,8 @@ std::shared_ptr<const RawPacket> UDPConnection::GetData()
 
 void UDPConnection::DeleteBufferPacketAt(unsigned index)
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	if (index >= msgQueue.size())
 		return;
 
@@ -405,6 +446,8 @@ void UDPConnection::DeleteBufferPacketAt(unsigned index)
 
 void UDPConnection::Update()
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	spring_time curTime = spring_gettime();
 	outgoing.UpdateTime(spring_tomsecs(curTime));
 
@@ -443,15 +486,24 @@ void UDPConnection::Update()
 
 		size_t bytesAvailable = 0;
 
-		while ((bytesAvailable = mySocket->available()) > 0) {
-			recvBuffer.clear();
-			recvBuffer.resize(bytesAvailable, 0);
-
+		while (true) {
 			ip::udp::endpoint udpEndPoint;
 			ip::udp::socket::message_flags msgFlags = 0;
 			asio::error_code err;
 
-			const size_t bytesReceived = mySocket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+			size_t bytesReceived = 0;
+
+			{
+				std::lock_guard<spring::mutex> lock(*socketMutex);
+
+				if ((bytesAvailable = mySocket->available()) == 0)
+					break;
+
+				recvBuffer.clear();
+				recvBuffer.resize(bytesAvailable, 0);
+
+				bytesReceived = mySocket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+			}
 
 			if (CheckErrorCode(err))
 				break;
@@ -523,6 +575,8 @@ void UDPConnection::UpdateResendRequests()
 
 void UDPConnection::ProcessRawPacket(Packet& incoming)
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	#ifdef ENABLE_DEBUG_STATS
 	if (logMessages)
 		LOG_L(L_INFO, "\t[%s] checksum=(%u : %u) mtu=%u", __func__, incoming.GetChecksum(), incoming.checksum, mtu);
@@ -644,36 +698,13 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 
 			// this returns false for zero/invalid pktLength
 			if (ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
-				msgQueue.emplace_back(new RawPacket(bufp, pktLength));
-				std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
-
-				#ifdef ENABLE_DEBUG_STATS
-				// server sends both of these, clients send only keyframe messages
-				// TODO: would be easy to feed this data into a Q3A-style lagometer
-				//
-				if (msgPacket->data[0] == NETMSG_NEWFRAME || msgPacket->data[0] == NETMSG_KEYFRAME) {
-					const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
-
-					sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
-					minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
-					maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
-
-					numReceivedFramePackets += 1;
-					numEnqueuedFramePackets += 1;
-					lastFramePacketRecvTime = spring_gettime();
-
-					if (logMessages) {
-						LOG_L(L_INFO,
-							"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
-							__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
-							minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
-						);
-					}
+				if (bufp[0] == NETMSG_COMPRESSED) {
+					UncompressMessages(bufp, pktLength);
+				} else {
+					AddIncomingMessage(bufp, pktLength);
 				}
-				#endif
 
 				pos += pktLength;
-				numPings += (msgPacket->data[0] == NETMSG_PING); // incoming
 			} else {
 				if (pktLength >= 0) {
 					// partial packet in buffer
@@ -693,8 +724,182 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 	UpdateWaitingPackets();
 }
 
+void UDPConnection::AddIncomingMessage(const unsigned char* data, unsigned length)
+{
+	if (data[0] == NETMSG_NEWFRAMES && expandFrameBatches) {
+		// the server batched consecutive frames, the game consumes them one by one;
+		// anywhere else the message goes into the queue unchanged and the server
+		// rejects it like any other frame message a client sends
+		const unsigned char newFrame = NETMSG_NEWFRAME;
+
+		for (unsigned int n = 0; n < data[1]; n++) {
+			AddIncomingMessage(&newFrame, sizeof(newFrame));
+		}
+
+		return;
+	}
+
+	msgQueue.emplace_back(new RawPacket(data, length));
+	std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
+
+	#ifdef ENABLE_DEBUG_STATS
+	// server sends both of these, clients send only keyframe messages
+	// TODO: would be easy to feed this data into a Q3A-style lagometer
+	//
+	if (msgPacket->data[0] == NETMSG_NEWFRAME || msgPacket->data[0] == NETMSG_KEYFRAME) {
+		const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
+
+		sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
+		minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
+		maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
+
+		numReceivedFramePackets += 1;
+		numEnqueuedFramePackets += 1;
+		lastFramePacketRecvTime = spring_gettime();
+
+		if (logMessages) {
+			LOG_L(L_INFO,
+				"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
+				__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
+				minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
+			);
+		}
+	}
+	#endif
+
+	numPings += (msgPacket->data[0] == NETMSG_PING); // incoming
+}
+
+void UDPConnection::UncompressMessages(const unsigned char* data, unsigned length)
+{
+	constexpr unsigned headerSize = sizeof(std::uint8_t) + sizeof(std::uint16_t);
+
+	if (inflateStream == nullptr) {
+		inflateStream.reset(new z_stream_s());
+
+		if (inflateInit2(inflateStream.get(), -MAX_WBITS) != Z_OK) {
+			LOG_L(L_ERROR, "\t[%s] failed to initialize zlib", __func__);
+			inflateStream.reset();
+			return;
+		}
+	} else {
+		inflateReset(inflateStream.get());
+	}
+
+	zlibBuffer.clear();
+	zlibBuffer.resize(maxCompressedBlockInput);
+
+	z_stream_s* strm = inflateStream.get();
+	strm->next_in = const_cast<Bytef*>(data + headerSize);
+	strm->avail_in = length - headerSize;
+	strm->next_out = zlibBuffer.data();
+	strm->avail_out = zlibBuffer.size();
+
+	// blocks are independent, each has to be complete
+	const int ret = inflate(strm, Z_FINISH);
+
+	if (ret != Z_STREAM_END) {
+		LOG_L(L_ERROR, "\t[%s] discarding incoming corrupted block: LEN %u, zlib error %d", __func__, length, ret);
+		return;
+	}
+
+	zlibBuffer.resize(strm->total_out);
+
+	recvUncompressed += zlibBuffer.size();
+	recvCompressed += length;
+
+	// other end supports it, so reply in kind
+	compressOutgoing = allowCompression;
+
+	for (unsigned pos = 0; pos < zlibBuffer.size(); ) {
+		const unsigned char* bufp = &zlibBuffer[pos];
+		const unsigned int msgLength = zlibBuffer.size() - pos;
+
+		const int pktLength = ProtocolDef::GetInstance()->PacketLength(bufp, msgLength);
+
+		// blocks never contain partial messages
+		if (!ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
+			LOG_L(L_ERROR, "\t[%s] discarding rest of incoming block: ID %d, LEN %d", __func__, (int)*bufp, pktLength);
+			break;
+		}
+
+		AddIncomingMessage(bufp, pktLength);
+		pos += pktLength;
+	}
+}
+
+void UDPConnection::CompressOutgoingData()
+{
+	constexpr unsigned headerSize = sizeof(std::uint8_t) + sizeof(std::uint16_t);
+
+	unsigned int numMessages = 0;
+	unsigned int rawLength = 0;
+
+	// take the leading run of (valid) messages that fits into a block;
+	// chunking them as one also aggregates many small ones into fewer
+	for (const std::shared_ptr<const RawPacket>& packet: outgoingData) {
+		if ((rawLength + packet->length) > maxCompressedBlockInput)
+			break;
+		if (!ProtocolDef::GetInstance()->IsValidPacket(packet->data, packet->length))
+			break;
+
+		rawLength += packet->length;
+		numMessages += 1;
+	}
+
+	if (rawLength < minCompressedBlockInput)
+		return;
+
+	if (deflateStream == nullptr) {
+		deflateStream.reset(new z_stream_s());
+
+		if (deflateInit2(deflateStream.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			LOG_L(L_ERROR, "[UDPConnection::%s] failed to initialize zlib, not compressing", __func__);
+			deflateStream.reset();
+			compressOutgoing = false;
+			return;
+		}
+	} else {
+		deflateReset(deflateStream.get());
+	}
+
+	zlibBuffer.clear();
+	zlibBuffer.reserve(rawLength);
+
+	for (unsigned int i = 0; i < numMessages; i++) {
+		zlibBuffer.insert(zlibBuffer.end(), outgoingData[i]->data, outgoingData[i]->data + outgoingData[i]->length);
+	}
+
+	z_stream_s* strm = deflateStream.get();
+	RawPacket* block = new RawPacket(headerSize + deflateBound(strm, rawLength), NETMSG_COMPRESSED);
+	std::shared_ptr<const RawPacket> blockPtr(block);
+
+	strm->next_in = zlibBuffer.data();
+	strm->avail_in = rawLength;
+	strm->next_out = block->data + headerSize;
+	strm->avail_out = block->length - headerSize;
+
+	if (deflate(strm, Z_FINISH) != Z_STREAM_END)
+		return;
+
+	// not worth it, send the messages as they are
+	if ((headerSize + strm->total_out) >= rawLength)
+		return;
+
+	block->length = headerSize + strm->total_out;
+	*block << static_cast<std::uint16_t>(block->length);
+
+	sentUncompressed += rawLength;
+	sentCompressed += block->length;
+
+	outgoingData.erase(outgoingData.begin(), outgoingData.begin() + numMessages);
+	outgoingData.push_front(blockPtr);
+}
+
 void UDPConnection::Flush(const bool forced)
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	if (muted)
 		return;
 
@@ -714,8 +919,13 @@ void UDPConnection::Flush(const bool forced)
 	}
 
 	if (forced || (!waitMore && outgoingLength > requiredLength)) {
+		if (compressOutgoing)
+			CompressOutgoingData();
+
 		std::uint8_t buffer[udpMaxPacketSize];
 		unsigned pos = 0;
+		// bytes of the front packet already put into earlier chunks
+		unsigned packetPos = 0;
 
 		// Manually fragment packets to respect configured UDP_MTU.
 		// This is an attempt to fix the bug where players drop out
@@ -737,22 +947,21 @@ void UDPConnection::Flush(const bool forced)
 					);
 					outgoingData.pop_front();
 				} else {
-					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length);
+					const unsigned numBytes = std::min((unsigned)maxChunkSize - pos, packet->length - packetPos);
 
 					assert(packet->length > 0);
-					memcpy(buffer + pos, packet->data, numBytes);
+					memcpy(buffer + pos, packet->data + packetPos, numBytes);
 
 					pos += numBytes;
 					sentOverhead += Packet::headerSize;
 
 					outgoing.DataSent(numBytes, true);
 
-					if ((partialPacket = (numBytes != packet->length))) {
-						// partially transfered
-						packet.reset(new RawPacket(packet->data + numBytes, packet->length - numBytes));
-					} else {
+					// if partially transfered, the rest goes into the next chunk(s)
+					if (!(partialPacket = ((packetPos += numBytes) != packet->length))) {
 						// full packet copied
 						outgoingData.pop_front();
+						packetPos = 0;
 					}
 				}
 			}
@@ -767,6 +976,7 @@ void UDPConnection::Flush(const bool forced)
 }
 
 bool UDPConnection::CheckTimeout(int seconds, bool initial) const {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
 
 	int timeout;
 
@@ -784,6 +994,7 @@ bool UDPConnection::CheckTimeout(int seconds, bool initial) const {
 }
 
 bool UDPConnection::NeedsReconnect() {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
 
 	if (CanReconnect()) {
 		if (!CheckTimeout(-1)) {
@@ -803,12 +1014,15 @@ bool UDPConnection::CanReconnect() const {
 
 std::string UDPConnection::Statistics() const
 {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	const char* fmts[] = {
 		"\t%u bytes sent   in %u packets (%.3f bytes/packet)\n",
 		"\t%u bytes recv'd in %u packets (%.3f bytes/packet)\n",
 		"\t{%.3fx, %.3fx} relative protocol overhead {up, down}\n",
 		"\t%u incoming chunks dropped, %u outgoing chunks resent\n",
 		"\t%u incoming chunks processed\n",
+		"\t{%.3fx, %.3fx} compression ratio {up, down} of %u and %u message bytes\n",
 	};
 
 	std::string msg = "[UDPConnection::Statistics]\n";
@@ -817,6 +1031,7 @@ std::string UDPConnection::Statistics() const
 	msg += spring::format(fmts[2], spring::SafeDivide(sentOverhead * 1.0f, dataSent * 1.0f), spring::SafeDivide(recvOverhead * 1.0f, dataRecv * 1.0f));
 	msg += spring::format(fmts[3], droppedChunks, resentChunks);
 	msg += spring::format(fmts[4], lastInOrder + 1);
+	msg += spring::format(fmts[5], spring::SafeDivide(sentUncompressed * 1.0f, sentCompressed * 1.0f), spring::SafeDivide(recvUncompressed * 1.0f, recvCompressed * 1.0f), sentUncompressed, recvUncompressed);
 	return msg;
 }
 
@@ -1056,8 +1271,12 @@ void UDPConnection::SendPacket(Packet& pkt)
 	ip::udp::socket::message_flags flags = 0;
 	asio::error_code err;
 
-	EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
-		mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+	{
+		std::lock_guard<spring::mutex> lock(*socketMutex);
+
+		EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
+			mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+		}
 	}
 
 	if (CheckErrorCode(err))
@@ -1126,6 +1345,7 @@ float UDPConnection::BandwidthUsage::GetAverage(bool prel) const
 }
 
 void UDPConnection::Close(bool flush) {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
 
 	if (closed)
 		return;
@@ -1134,6 +1354,7 @@ void UDPConnection::Close(bool flush) {
 	muted = true;
 	if (!sharedSocket) {
 		try {
+			std::lock_guard<spring::mutex> lock(*socketMutex);
 			mySocket->close();
 		} catch (const asio::system_error& ex) {
 			LOG_L(L_ERROR, "[UDPConnection::%s] error \"%s\" closing socket", __func__, ex.what());
@@ -1143,6 +1364,8 @@ void UDPConnection::Close(bool flush) {
 }
 
 void UDPConnection::SetLossFactor(int factor) {
+	std::lock_guard<spring::recursive_mutex> lock(connMutex);
+
 	netLossFactor = factor;
 	netLossFactor = std::max(netLossFactor, int(MIN_LOSS_FACTOR));
 	netLossFactor = std::min(netLossFactor, int(MAX_LOSS_FACTOR));
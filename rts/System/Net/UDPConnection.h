@@ -9,9 +9,11 @@
 
 #include "Connection.h"
 #include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
 #include "System/UnorderedSet.hpp"
 
 class CRC;
+struct z_stream_s;
 
 
 namespace netcode {
@@ -81,7 +83,11 @@ public:
 class UDPConnection : public CConnection
 {
 public:
-	UDPConnection(std::shared_ptr<asio::ip::udp::socket> netSocket, const asio::ip::udp::endpoint& myAddr);
+	UDPConnection(
+		std::shared_ptr<asio::ip::udp::socket> netSocket,
+		std::shared_ptr<spring::mutex> netSocketMutex,
+		const asio::ip::udp::endpoint& myAddr
+	);
 	UDPConnection(int sourceport, const std::string& address, const unsigned port);
 	UDPConnection(CConnection& conn);
 	~UDPConnection();
@@ -94,7 +100,7 @@ public:
 
 	// START overriding CConnection
 	void SendData(std::shared_ptr<const RawPacket> pkt) override;
-	bool HasIncomingData() const override { return !msgQueue.empty(); }
+	bool HasIncomingData() const override { std::lock_guard<spring::recursive_mutex> lock(connMutex); return !msgQueue.empty(); }
 	std::shared_ptr<const RawPacket> Peek(unsigned ahead) const override;
 	std::shared_ptr<const RawPacket> GetData() override;
 	void DeleteBufferPacketAt(unsigned index) override;
@@ -105,7 +111,7 @@ public:
 	bool CanReconnect() const override;
 	bool NeedsReconnect() override;
 
-	unsigned int GetPacketQueueSize() const override { return msgQueue.size(); }
+	unsigned int GetPacketQueueSize() const override { std::lock_guard<spring::recursive_mutex> lock(connMutex); return msgQueue.size(); }
 
 	std::string Statistics() const override;
 	std::string GetFullAddress() const override;
@@ -128,15 +134,26 @@ public:
 	bool UseMinLossFactor() const { return (netLossFactor == MIN_LOSS_FACTOR); }
 
 	/// Connections are stealth by default, this allow them to send data
-	void Unmute() override { muted = false; }
+	void Unmute() override { std::lock_guard<spring::recursive_mutex> lock(connMutex); muted = false; }
 	void Close(bool flush) override;
 	void SetLossFactor(int factor) override;
+	void EnableCompression() override { std::lock_guard<spring::recursive_mutex> lock(connMutex); compressOutgoing = allowCompression; }
+	/// overrides UDPConnectionCompression (which is not read in unit-tests)
+	void SetAllowCompression(bool allow) { std::lock_guard<spring::recursive_mutex> lock(connMutex); compressOutgoing &= (allowCompression = allow); }
+
+	/// only a client's link to the server may expand NETMSG_NEWFRAMES, elsewhere it is passed on as-is
+	void SetExpandFrameBatches(bool expand) { std::lock_guard<spring::recursive_mutex> lock(connMutex); expandFrameBatches = expand; }
+
+	/// message bytes sent and received in NETMSG_COMPRESSED blocks
+	unsigned int GetSentUncompressed() const { std::lock_guard<spring::recursive_mutex> lock(connMutex); return sentUncompressed; }
+	unsigned int GetRecvUncompressed() const { std::lock_guard<spring::recursive_mutex> lock(connMutex); return recvUncompressed; }
 
 	const asio::ip::udp::endpoint& GetEndpoint() const { return addr; }
 
 private:
 	void InitConnection(asio::ip::udp::endpoint address,
-			std::shared_ptr<asio::ip::udp::socket> socket);
+			std::shared_ptr<asio::ip::udp::socket> socket,
+			std::shared_ptr<spring::mutex> socketMtx);
 
 	void CopyConnection(UDPConnection& conn);
 
@@ -152,6 +169,11 @@ private:
 	void RequestResend(ChunkPtr ptr, bool noSort);
 	void SendPacket(Packet& pkt);
 
+	/// merge queued outgoing messages into a NETMSG_COMPRESSED block, if that saves anything
+	void CompressOutgoingData();
+	void UncompressMessages(const unsigned char* data, unsigned length);
+	void AddIncomingMessage(const unsigned char* data, unsigned length);
+
 	void UpdateWaitingPackets();
 	void UpdateResendRequests();
 
@@ -179,6 +201,12 @@ private:
 	bool resend;
 	bool sharedSocket;
 	bool logMessages;
+	/// set by config (or SetAllowCompression), compression is used only if this is true
+	bool allowCompression;
+	/// set once the other end is known to support compression
+	bool compressOutgoing;
+	/// whether incoming NETMSG_NEWFRAMES are turned into NETMSG_NEWFRAME's
+	bool expandFrameBatches;
 
 	int netLossFactor;
 	int reconnectTime;
@@ -205,6 +233,11 @@ private:
 	std::vector<std::uint8_t> sendBuffer;
 	std::vector<std::uint8_t> recvBuffer;
 	std::vector<std::uint8_t> waitBuffer;
+	std::vector<std::uint8_t> zlibBuffer;
+
+	/// each block is compressed on its own, these only avoid re-allocating zlib state
+	std::unique_ptr<z_stream_s> deflateStream;
+	std::unique_ptr<z_stream_s> inflateStream;
 
 	std::vector<int> droppedPackets;
 
@@ -221,6 +254,12 @@ private:
 
 	/// Our socket
 	std::shared_ptr<asio::ip::udp::socket> mySocket;
+	/// guards every send and receive on mySocket, shared with the UDPListener and
+	/// all other connections on the same socket since asio sockets are not thread-safe
+	std::shared_ptr<spring::mutex> socketMutex;
+
+	/// held by every public method; a relayed connection is also used by the relay thread
+	mutable spring::recursive_mutex connMutex;
 
 	RawPacket fragmentBuffer;
 
@@ -244,6 +283,10 @@ private:
 	unsigned int sentOverhead, recvOverhead;
 	unsigned int sentPackets, recvPackets;
 
+	/// message bytes that went into (came out of) compressed blocks, and the blocks' sizes
+	unsigned int sentUncompressed, recvUncompressed;
+	unsigned int sentCompressed, recvCompressed;
+
 	class BandwidthUsage {
 	public:
 		BandwidthUsage() = default;
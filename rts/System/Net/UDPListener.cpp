@@ -25,7 +25,9 @@ namespace netcode
 {
 using namespace asio;
 
-UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(false)
+UDPListener::UDPListener(int port, const std::string& ip)
+	: acceptNewConnections(false)
+	, socketMutex(new spring::mutex())
 {
 	// resets socket on any exception
 	const std::string err = TryBindSocket(port, socket, ip);
@@ -112,15 +114,25 @@ void UDPListener::Update() {
 
 	size_t bytesAvailable = 0;
 
-	while ((bytesAvailable = socket->available()) > 0) {
-		recvBuffer.clear();
-		recvBuffer.resize(bytesAvailable, 0);
-
+	while (true) {
 		ip::udp::endpoint udpEndPoint;
 		asio::ip::udp::socket::message_flags msgFlags = 0;
 		asio::error_code err;
 
-		const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+		size_t bytesReceived = 0;
+
+		{
+			// relayed connections send on this socket from the relay thread
+			std::lock_guard<spring::mutex> lock(*socketMutex);
+
+			if ((bytesAvailable = socket->available()) == 0)
+				break;
+
+			recvBuffer.clear();
+			recvBuffer.resize(bytesAvailable, 0);
+
+			bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+		}
 
 		const auto ci = connMap.find(udpEndPoint);
 
@@ -145,7 +157,7 @@ void UDPListener::Update() {
 		// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
 		if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
 			if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
-				std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
+				std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, socketMutex, udpEndPoint));
 				waiting.push(incoming);
 				connMap[udpEndPoint] = incoming;
 				incoming->ProcessRawPacket(data);
@@ -180,7 +192,12 @@ void UDPListener::Update() {
 			i = connMap.erase(i);
 			continue;
 		}
-		i->second.lock()->Update();
+
+		const std::shared_ptr<UDPConnection> conn = i->second.lock();
+
+		if (!conn->IsRelayed())
+			conn->Update();
+
 		++i;
 	}
 }
@@ -188,7 +205,7 @@ void UDPListener::Update() {
 
 std::shared_ptr<UDPConnection> UDPListener::SpawnConnection(const std::string& ip, const unsigned port)
 {
-	std::shared_ptr<UDPConnection> newConn(new UDPConnection(socket, ip::udp::endpoint(WrapIP(ip), port)));
+	std::shared_ptr<UDPConnection> newConn(new UDPConnection(socket, socketMutex, ip::udp::endpoint(WrapIP(ip), port)));
 	connMap[newConn->GetEndpoint()] = newConn;
 	return newConn;
 }
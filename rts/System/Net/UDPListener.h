@@ -4,6 +4,7 @@
 #define _UDP_LISTENER_H
 
 #include "System/Misc/NonCopyable.h"
+#include "System/Threading/SpringThreading.h"
 #include <memory>
 #include <asio/ip/udp.hpp>
 #include <map>
@@ -51,7 +52,8 @@ public:
 	/**
 	 * @brief Run this from time to time
 	 * Recieve data from the socket and hand it to the associated UDPConnection,
-	 * or open a new UDPConnection. It also Updates all of its connections.
+	 * or open a new UDPConnection. It also Updates all of its connections,
+	 * except relayed ones.
 	 */
 	void Update();
 
@@ -84,6 +86,8 @@ private:
 
 	/// socket being listened on
 	std::shared_ptr<asio::ip::udp::socket> socket;
+	/// held around every use of socket, by us and by all connections on it
+	std::shared_ptr<spring::mutex> socketMutex;
 
 	std::vector<std::uint8_t> recvBuffer;
 
@@ -40,6 +40,7 @@
 #if !defined(_WIN32)
 #include <dlfcn.h> // for dladdr(), dlopen()
 #include <pwd.h> // for getpw*()
+#include <sys/resource.h> // for getrusage()
 #include <sys/statvfs.h>
 #include <sys/types.h>
 #include <sys/utsname.h> // for uname()
@@ -514,6 +515,27 @@ namespace Platform
 	}
 
 
+	uint64_t GetPeakMemoryUsage() {
+		#ifdef _WIN32
+		// would need psapi (GetProcessMemoryInfo), which we do not link
+		return 0;
+
+		#else
+
+		struct rusage ru;
+
+		if (getrusage(RUSAGE_SELF, &ru) != 0)
+			return 0;
+
+		#if defined(__APPLE__)
+		return (ru.ru_maxrss);
+		#else
+		return (ru.ru_maxrss * uint64_t(1024));
+		#endif
+		#endif
+	}
+
+
 	uint32_t NativeWordSize() { return (sizeof(void*)); }
 	uint32_t SystemWordSize() { return ((Is32BitEmulation())? 8: NativeWordSize()); }
 
@@ -132,6 +132,8 @@ DEFINE_bool     (isolation,                                false, "Limit the dat
 DEFINE_string_EX(isolation_dir,      "isolation-dir",      "",    "Specify the isolation-mode data-dir (see --isolation)");
 DEFINE_string_EX(write_dir,          "write-dir",          "",    "Specify where Spring writes to.");
 DEFINE_string   (game,                                     "",    "Specify the game that will be instantly loaded");
+DEFINE_string_EX(benchmark_report,   "benchmark-report",   "",    "Replay the given demo at unlimited speed, write a JSON timing report to this file and exit");
+DEFINE_string_EX(benchmark_limits,   "benchmark-limits",   "",    "Frame-time limits in ms for --benchmark-report (e.g. p50=5,p99=20,max=100), exceeding any fails with exit-code 1005");
 DEFINE_string   (map,                                      "",    "Specify the map that will be instantly loaded");
 DEFINE_string   (menu,                                     "",    "Specify a lua menu archive to be used by spring");
 DEFINE_string   (name,                                     "",    "Set your player name");
@@ -476,6 +478,12 @@ void SpringApp::ParseCmdLine(int argc, char* argv[])
 	// logOutput's init depends on configHandler
 	FileSystemInitializer::PreInitializeConfigHandler(FLAGS_config, FLAGS_name, FLAGS_safemode);
 	FileSystemInitializer::InitializeLogOutput();
+
+	// set in config overlay (not persisted)
+	if (!FLAGS_benchmark_report.empty()) {
+		configHandler->SetString("BenchmarkReportFile", FLAGS_benchmark_report, true);
+		configHandler->SetString("BenchmarkLimits", FLAGS_benchmark_limits, true);
+	}
 }
 
 
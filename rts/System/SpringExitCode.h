@@ -14,6 +14,7 @@ namespace spring {
 		EXIT_CODE_NOLOAD  =  1002, // Game::Load
 		EXIT_CODE_KILLED  =  1003, // CrashHandler::ForcedExit
 		EXIT_CODE_BADSAVE =  1004, // PreGame::LoadSaveFile
+		EXIT_CODE_REGRESS =  1005, // Benchmark::Finish
 	};
 
 	// only here for validation tests
@@ -0,0 +1,116 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "SubsystemChecksums.h"
+#include "HsiehHash.h"
+
+#include "Lua/LuaHandleSynced.h"
+#include "Sim/Features/Feature.h"
+#include "Sim/Features/FeatureHandler.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/Team.h"
+#include "Sim/Misc/TeamHandler.h"
+#include "Sim/MoveTypes/MoveType.h"
+#include "Sim/Projectiles/Projectile.h"
+#include "Sim/Projectiles/ProjectileHandler.h"
+#include "Sim/Units/CommandAI/CommandAI.h"
+#include "Sim/Units/Unit.h"
+#include "Sim/Units/UnitHandler.h"
+
+
+template<typename T> static uint32_t HashValue(const T& value, uint32_t hash) {
+	return (HsiehHash(&value, sizeof(T), hash));
+}
+
+static uint32_t HashParams(const LuaRulesParams::Params& params, uint32_t hash) {
+	uint32_t sum = 0;
+
+	// unordered; summing the per-param hashes makes iteration order irrelevant
+	for (const auto& p: params) {
+		uint32_t paramHash = HsiehHash(p.first.data(), p.first.size(), 0);
+
+		paramHash = HashValue(p.second.los, paramHash);
+		paramHash = HashValue(p.second.valueInt, paramHash);
+		paramHash = HsiehHash(p.second.valueString.data(), p.second.valueString.size(), paramHash);
+
+		sum += paramHash;
+	}
+
+	return (HashValue(sum, HashValue(uint32_t(params.size()), hash)));
+}
+
+
+void SubsystemChecksums::Calc(Checksums& checksums)
+{
+	checksums.fill(0);
+
+	uint32_t& unitHash = checksums[SUBSYS_UNITS];
+	uint32_t& featureHash = checksums[SUBSYS_FEATURES];
+	uint32_t& projectileHash = checksums[SUBSYS_PROJECTILES];
+	uint32_t& pathHash = checksums[SUBSYS_PATHING];
+	uint32_t& teamHash = checksums[SUBSYS_TEAMS];
+	uint32_t& rngHash = checksums[SUBSYS_RNG];
+	uint32_t& luaHash = checksums[SUBSYS_LUARULES];
+
+	luaHash = HashParams(CSplitLuaHandle::GetGameParams(), luaHash);
+
+	// units are updated in the order of this list, so it is hashed in order as well
+	for (const CUnit* u: unitHandler.GetActiveUnits()) {
+		unitHash = HashValue(u->id, unitHash);
+		unitHash = HashValue(u->pos, unitHash);
+		unitHash = HashValue(u->speed, unitHash);
+		unitHash = HashValue(short(u->heading), unitHash);
+		unitHash = HashValue(u->health, unitHash);
+		unitHash = HashValue(u->experience, unitHash);
+		unitHash = HashValue(u->physicalState, unitHash);
+		unitHash = HashValue(uint32_t(u->commandAI->commandQue.size()), unitHash);
+
+		const AMoveType* mt = u->moveType;
+
+		pathHash = HashValue(u->id, pathHash);
+		pathHash = HashValue(mt->goalPos, pathHash);
+		pathHash = HashValue(mt->oldSlowUpdatePos, pathHash);
+		pathHash = HashValue(mt->progressState, pathHash);
+
+		luaHash = HashParams(u->modParams, luaHash);
+	}
+
+	{
+		uint32_t featureSum = 0;
+		uint32_t paramSum = 0;
+
+		// the feature-set is unordered, sum the per-feature hashes
+		for (const int featureID: featureHandler.GetActiveFeatureIDs()) {
+			const CFeature* f = featureHandler.GetFeature(featureID);
+
+			uint32_t hash = HashValue(f->id, 0);
+
+			hash = HashValue(f->pos, hash);
+			hash = HashValue(f->health, hash);
+			hash = HashValue(f->reclaimLeft, hash);
+
+			featureSum += hash;
+			paramSum += HashParams(f->modParams, f->id);
+		}
+
+		featureHash = HashValue(featureSum, HashValue(uint32_t(featureHandler.GetActiveFeatureIDs().size()), featureHash));
+		luaHash = HashValue(paramSum, luaHash);
+	}
+
+	for (const CProjectile* p: projectileHandler.projectileContainers[true]) {
+		projectileHash = HashValue(p->id, projectileHash);
+		projectileHash = HashValue(p->pos, projectileHash);
+		projectileHash = HashValue(p->speed, projectileHash);
+	}
+
+	for (int a = 0; a < teamHandler.ActiveTeams(); ++a) {
+		const CTeam* t = teamHandler.Team(a);
+
+		teamHash = HashValue(t->res, teamHash);
+		teamHash = HashValue(t->resStorage, teamHash);
+
+		luaHash = HashParams(t->modParams, luaHash);
+	}
+
+	rngHash = HashValue(gsRNG.GetLastSeed(), rngHash);
+	rngHash = HashValue(gsRNG.GetGenState(), rngHash);
+}
@@ -0,0 +1,42 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SUBSYSTEM_CHECKSUMS_H
+#define SUBSYSTEM_CHECKSUMS_H
+
+#include <array>
+#include <cinttypes>
+
+/**
+ * Per-subsystem checksums over the synced state, taken between two frames.
+ *
+ * Unlike CSyncChecker's running checksum (which only tells that *something*
+ * went out of sync since the last reset) these are snapshots of the state of
+ * each subsystem, so the server can tell which one diverged first and when.
+ * They only cover the state that is cheap to reach from the outside, which
+ * is why they are sampled every few frames rather than after each one.
+ */
+namespace SubsystemChecksums
+{
+	enum {
+		SUBSYS_UNITS       = 0,
+		SUBSYS_FEATURES    = 1,
+		SUBSYS_PROJECTILES = 2,
+		SUBSYS_PATHING     = 3,
+		SUBSYS_TEAMS       = 4,
+		SUBSYS_RNG         = 5,
+		SUBSYS_LUARULES    = 6,
+		SUBSYS_COUNT       = 7,
+	};
+
+	typedef std::array<uint32_t, SUBSYS_COUNT> Checksums;
+
+	static inline const char* GetName(unsigned int subsys) {
+		constexpr const char* names[SUBSYS_COUNT] = {"units", "features", "projectiles", "pathing", "teams", "rng", "luarules"};
+		return ((subsys < SUBSYS_COUNT)? names[subsys]: "unknown");
+	}
+
+	/// computes the checksums of the current sim state (engine only)
+	void Calc(Checksums& checksums);
+}
+
+#endif // SUBSYSTEM_CHECKSUMS_H
@@ -75,6 +75,7 @@ static std::array<ThreadStats, ThreadPool::MAX_THREADS> threadStats[2];
 static spring::signal newTasksSignal[2];
 
 static _threadlocal int threadnum(0);
+static _threadlocal bool asyncthread(false);
 
 #ifndef UNITSYNC
 // if enabled, allows OpenGL calls from ThreadPool tasks
@@ -93,7 +94,8 @@ std::atomic_uint ITaskGroup::lastId(0);
 namespace ThreadPool {
 
 int GetThreadNum() { return threadnum; }
-static void SetThreadNum(const int idx) { threadnum = idx; }
+bool IsAsyncThread() { return asyncthread; }
+static void SetThreadNum(const int idx, const bool async) { threadnum = idx; asyncthread = async; }
 
 
 static int GetConfigNumWorkers() {
@@ -206,7 +208,7 @@ __FORCE_ALIGN_STACK__
 static void WorkerLoop(int tid, bool async)
 {
 	assert(tid != 0);
-	SetThreadNum(tid);
+	SetThreadNum(tid, async);
 	#ifndef UNIT_TEST
 	Threading::SetThreadName(IntToString(tid, "worker%i"));
 	#endif
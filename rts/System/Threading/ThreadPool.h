@@ -22,6 +22,7 @@ namespace ThreadPool {
 	static inline void SetDefaultThreadCount() {}
 	static inline void SetThreadCount(int num) {}
 	static inline int GetThreadNum() { return 0; }
+	static inline bool IsAsyncThread() { return false; }
 	static inline int GetMaxThreads() { return 1; }
 	static inline int GetNumThreads() { return 1; }
 	static inline void NotifyWorkerThreads(bool force, bool async) {}
@@ -104,6 +105,8 @@ namespace ThreadPool {
 	void SetDefaultThreadCount();
 	void SetThreadCount(int num);
 	int GetThreadNum();
+	/// async workers are numbered like the regular ones, this tells them apart
+	bool IsAsyncThread();
 	bool HasThreads();
 	int GetMaxThreads();
 	int GetNumThreads();
@@ -16,12 +16,49 @@
 
 using ProfileMutexType = spring::mutex; //spring::spinlock
 using HashNamMutexType = spring::mutex; //spring::spinlock
+using TraceMutexType = spring::mutex;
 
 static ProfileMutexType profileMutex;
 static HashNamMutexType hashToNameMutex;
 static spring::unordered_map<unsigned, std::string> hashToName;
 static spring::unordered_map<unsigned, int> refCounters;
 
+
+#ifdef THREADPOOL
+// async workers share their numbers with the regular ones, and come second
+static constexpr int MAX_TRACE_THREADS = ThreadPool::MAX_THREADS * 2;
+#else
+static constexpr int MAX_TRACE_THREADS = 1;
+#endif
+
+static constexpr size_t TRACE_BUFFER_SIZE = 4096;
+
+struct TraceEvent {
+	unsigned nameHash;
+	int threadNum;
+	int frameNum;
+	// microseconds since traceStartTime
+	int64_t ts;
+	int64_t dur;
+};
+
+// timers only ever lock the buffer of their own thread (threads outside
+// the pool share the first), and hand it over to the writer when full;
+// the index of the buffer is also the thread's tid in the trace
+struct TraceBuffer {
+	TraceMutexType mutex;
+	std::vector<TraceEvent> events;
+};
+
+// traceMutex is held by the writer (Start/StopTrace, SetTraceFrame) only
+static TraceMutexType traceMutex;
+static TraceMutexType fullTraceBuffersMutex;
+
+static std::array<TraceBuffer, MAX_TRACE_THREADS> traceBuffers;
+static std::vector< std::vector<TraceEvent> > fullTraceBuffers;
+// names resolved by the writer so far
+static spring::unordered_map<unsigned, std::string> traceNames;
+
 static CGlobalUnsyncedRNG profileColorRNG;
 
 
@@ -57,6 +94,9 @@ ScopedTimer::~ScopedTimer()
 	if (--(iter->second) == 0) {
 		profiler.AddTime(nameHash, startTime, GetDuration(), autoShowGraph, specialTimer, false);
 	}
+
+	if (profiler.IsTracing())
+		profiler.AddTrace(nameHash, startTime, spring_gettime());
 }
 
 
@@ -100,6 +140,9 @@ ScopedMtTimer::ScopedMtTimer(unsigned _nameHash, bool _autoShowGraph)
 ScopedMtTimer::~ScopedMtTimer()
 {
 	profiler.AddTime(nameHash, startTime, GetDuration(), autoShowGraph, false, true);
+
+	if (profiler.IsTracing())
+		profiler.AddTrace(nameHash, startTime, spring_gettime());
 }
 
 
@@ -121,7 +164,7 @@ CTimeProfiler::CTimeProfiler()
 }
 
 #if 1
-CTimeProfiler::~CTimeProfiler() = default;
+CTimeProfiler::~CTimeProfiler() { StopTrace(); }
 #else
 CTimeProfiler::~CTimeProfiler()
 {
@@ -414,3 +457,199 @@ void CTimeProfiler::PrintProfilingInfo() const
 	}
 }
 
+
+
+
+bool CTimeProfiler::StartTrace(const std::string& fileName)
+{
+	StopTrace();
+
+	std::lock_guard<TraceMutexType> lock(traceMutex);
+
+	if ((traceFile = fopen(fileName.c_str(), "w")) == nullptr) {
+		LOG_L(L_ERROR, "[TimeProfiler::%s] could not open \"%s\" for writing", __func__, fileName.c_str());
+		return false;
+	}
+
+	// the closing bracket is optional for trace viewers, so a
+	// trace cut short by a crash remains loadable up to the
+	// last flush
+	fputs("[\n", traceFile);
+
+	// drop whatever a previous trace left behind
+	for (TraceBuffer& buffer: traceBuffers) {
+		std::lock_guard<TraceMutexType> bufferLock(buffer.mutex);
+		buffer.events.clear();
+	}
+	{
+		std::lock_guard<TraceMutexType> fullLock(fullTraceBuffersMutex);
+		fullTraceBuffers.clear();
+	}
+
+	traceStartTime = spring_gettime();
+	numTracedEvents = 0;
+
+	tracing = true;
+
+	LOG("[TimeProfiler::%s] tracing timers to \"%s\"", __func__, fileName.c_str());
+	return true;
+}
+
+void CTimeProfiler::StopTrace()
+{
+	if (!tracing)
+		return;
+
+	std::lock_guard<TraceMutexType> lock(traceMutex);
+
+	if (traceFile == nullptr)
+		return;
+
+	tracing = false;
+
+	FlushTraceRaw();
+
+	fputs("\n]\n", traceFile);
+	fclose(traceFile);
+
+	traceFile = nullptr;
+
+	LOG("[TimeProfiler::%s] traced %u events", __func__, unsigned(numTracedEvents));
+}
+
+void CTimeProfiler::SetTraceFrame(int frameNum)
+{
+	traceFrame = frameNum;
+
+	if (!tracing)
+		return;
+
+	std::lock_guard<TraceMutexType> lock(traceMutex);
+
+	if (!tracing)
+		return;
+
+	// one flush per frame keeps the file current without stalling timers
+	FlushTraceRaw();
+
+	const char* sep = (numTracedEvents++ > 0)? ",\n": "";
+	const int64_t ts = spring_difftime(spring_gettime(), traceStartTime).toMicroSecsi();
+
+	fprintf(traceFile, "%s{\"name\":\"SimFrame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%lld,\"args\":{\"frame\":%d}}", sep, (long long) ts, frameNum);
+}
+
+void CTimeProfiler::AddTrace(unsigned nameHash, const spring_time startTime, const spring_time endTime)
+{
+	#ifdef THREADPOOL
+	const int threadNum = ThreadPool::GetThreadNum() + ThreadPool::MAX_THREADS * ThreadPool::IsAsyncThread();
+	#else
+	const int threadNum = 0;
+	#endif
+
+	const int64_t ts = spring_difftime(startTime, traceStartTime).toMicroSecsi();
+	const int64_t te = spring_difftime(  endTime, traceStartTime).toMicroSecsi();
+
+	TraceBuffer& buffer = traceBuffers[threadNum];
+
+	std::lock_guard<TraceMutexType> lock(buffer.mutex);
+
+	// tracing might have been stopped since the caller checked
+	if (!tracing)
+		return;
+
+	buffer.events.push_back({nameHash, threadNum, traceFrame, ts, te - ts});
+
+	if (buffer.events.size() < TRACE_BUFFER_SIZE)
+		return;
+
+	// handed over while still holding the buffer, so a flush that has been
+	// through all buffers is guaranteed to see it (see FlushTraceRaw)
+	std::lock_guard<TraceMutexType> fullLock(fullTraceBuffersMutex);
+	fullTraceBuffers.emplace_back(std::move(buffer.events));
+
+	buffer.events.clear();
+	buffer.events.reserve(TRACE_BUFFER_SIZE);
+}
+
+
+static void WriteTraceName(FILE* file, const char* name)
+{
+	fputc('"', file);
+
+	for (const char* c = name; *c != 0; ++c) {
+		switch (*c) {
+			case '"' : { fputs("\\\"", file); } break;
+			case '\\': { fputs("\\\\", file); } break;
+			default: {
+				if (static_cast<unsigned char>(*c) < 0x20) {
+					fprintf(file, "\\u%04x", *c);
+				} else {
+					fputc(*c, file);
+				}
+			} break;
+		}
+	}
+
+	fputc('"', file);
+}
+
+void CTimeProfiler::FlushTraceRaw()
+{
+	if (traceFile == nullptr)
+		return;
+
+	std::vector< std::vector<TraceEvent> > events;
+
+	// the partial buffers go first: a timer handing over a full one does so
+	// under its buffer's lock, so once all were taken the full ones include
+	// everything that was handed over before; when called from StopTrace no
+	// timer gets past its (!tracing) check after that
+	for (TraceBuffer& buffer: traceBuffers) {
+		events.emplace_back();
+
+		std::lock_guard<TraceMutexType> lock(buffer.mutex);
+		events.back().swap(buffer.events);
+	}
+
+	{
+		std::lock_guard<TraceMutexType> lock(fullTraceBuffersMutex);
+
+		for (std::vector<TraceEvent>& fullEvents: fullTraceBuffers) {
+			events.emplace_back(std::move(fullEvents));
+		}
+
+		fullTraceBuffers.clear();
+	}
+
+	char nameBuf[16];
+
+	for (const std::vector<TraceEvent>& threadEvents: events) {
+		for (const TraceEvent& e: threadEvents) {
+			auto iter = traceNames.find(e.nameHash);
+
+			if (iter == traceNames.end()) {
+				std::lock_guard<HashNamMutexType> lock(hashToNameMutex);
+
+				const auto nameIter = hashToName.find(e.nameHash);
+
+				if (nameIter != hashToName.end())
+					iter = traceNames.insert(e.nameHash, nameIter->second).first;
+			}
+
+			const char* name = nameBuf;
+
+			if (iter != traceNames.end()) {
+				name = iter->second.c_str();
+			} else {
+				// unregistered (e.g. SCOPED_TIMER_NOREG-only) names
+				snprintf(nameBuf, sizeof(nameBuf), "0x%08x", e.nameHash);
+			}
+
+			fputs((numTracedEvents++ > 0)? ",\n{\"name\":": "{\"name\":", traceFile);
+			WriteTraceName(traceFile, name);
+			fprintf(traceFile, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{\"frame\":%d}}", e.threadNum, (long long) e.ts, (long long) e.dur, e.frameNum);
+		}
+	}
+
+	fflush(traceFile);
+}
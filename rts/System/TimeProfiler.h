@@ -4,6 +4,8 @@
 #define TIME_PROFILER_H
 
 #include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <deque>
 #include <vector>
@@ -24,7 +26,7 @@
 #define SCOPED_SPECIAL_TIMER(      name)  static TimerNameRegistrar __stnr(name); ScopedTimer __scopedTimer(hashString(name), false, true);
 #define SCOPED_SPECIAL_TIMER_NOREG(name)                                          ScopedTimer __scopedTimer(hashString(name), false, true);
 
-#define SCOPED_MT_TIMER(name)  ScopedMtTimer __scopedTimer(hashString(name));
+#define SCOPED_MT_TIMER(name)  static TimerNameRegistrar __tnr(name); ScopedMtTimer __scopedTimer(hashString(name));
 
 
 class BasicTimer : public spring::noncopyable
@@ -167,6 +169,20 @@ public:
 	void SetEnabled(bool b) { enabled = b; }
 	void PrintProfilingInfo() const;
 
+	/**
+	 * Trace mode: every ScopedTimer and ScopedMtTimer scope is streamed to
+	 * <fileName> as a Chrome trace-event JSON array (chrome://tracing, Perfetto)
+	 * tagged with its thread and sim-frame, independently of SetEnabled.
+	 * Async pool workers are traced as tid ThreadPool::MAX_THREADS + n.
+	 */
+	bool StartTrace(const std::string& fileName);
+	void StopTrace();
+	bool IsTracing() const { return tracing; }
+	/// emits a frame marker; later events are tagged with <frameNum>
+	void SetTraceFrame(int frameNum);
+
+	void AddTrace(unsigned nameHash, const spring_time startTime, const spring_time endTime);
+
 	void AddTime(
 		unsigned nameHash,
 		const spring_time startTime,
@@ -197,6 +213,17 @@ private:
 
 	// if false, AddTime is a no-op for (almost) all timers
 	std::atomic<bool> enabled;
+
+private:
+	/// writes all events collected from the per-thread buffers so far
+	void FlushTraceRaw();
+
+	FILE* traceFile = nullptr;
+	spring_time traceStartTime;
+	size_t numTracedEvents = 0;
+
+	std::atomic<bool> tracing = {false};
+	std::atomic<int> traceFrame = {-1};
 };
 
 
@@ -1,6 +1,9 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <cstdio>
+#include <memory>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -16,6 +19,9 @@
 #include "System/GlobalRNG.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/DataDirLocater.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/FileSystemAbstraction.h"
 #include "System/FileSystem/FileSystemInitializer.h"
 #include "System/FileSystem/ArchiveScanner.h"
 #include "System/FileSystem/VFSHandler.h"
@@ -48,13 +54,14 @@ DEFINE_bool     (isolation,                            false, "Limit the data-di
 DEFINE_string_EX(isolation_dir,    "isolation-dir",    "",    "Specify the isolation-mode data-dir (see --isolation)");
 DEFINE_bool     (nocolor,                              false, "Disables colorized stdout");
 DEFINE_uint32   (sleeptime,                            1,     "Number of seconds to sleep between game-over checks");
+DEFINE_string_EX(spool_dir,        "spool-dir",        "",    "Host a game for every script (*.txt) put into this directory, renaming it to *.txt.running and later *.txt.done (or *.txt.failed)");
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
+void ParseCmdLine(int argc, char* argv[], std::vector<std::string>& scriptNames)
 {
 	#undef  LOG_SECTION_CURRENT
 	#define LOG_SECTION_CURRENT LOG_SECTION_DEFAULT
@@ -71,10 +78,12 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 		exit(0);
 	}
 
-	if (argc >= 2)
-		scriptName = argv[1];
+	// every script given is hosted by its own server, all sharing this process' VFS
+	for (int i = 1; i < argc; i++) {
+		scriptNames.emplace_back(argv[i]);
+	}
 
-	if (scriptName.empty() && !FLAGS_list_config_vars) {
+	if (scriptNames.empty() && FLAGS_spool_dir.empty() && !FLAGS_list_config_vars) {
 		gflags::ShowUsageWithFlags(argv[0]);
 		exit(1);
 	}
@@ -106,6 +115,163 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 
 
 
+static std::unique_ptr<CGameServer> StartServer(const std::string& scriptName)
+{
+	LOG("loading script from file: %s", scriptName.c_str());
+
+	// server will take ownership of these
+	std::shared_ptr<ClientSetup> dsClientSetup(new ClientSetup());
+	std::shared_ptr<GameData> dsGameData(new GameData());
+	std::shared_ptr<CGameSetup> dsGameSetup(new CGameSetup());
+
+	std::string scriptText;
+	CFileHandler fh(scriptName);
+
+	if (!fh.FileExists())
+		throw content_error("script does not exist in given location: " + scriptName);
+
+	if (!fh.LoadStringData(scriptText))
+		throw content_error("script cannot be read: " + scriptName);
+
+	dsClientSetup->LoadFromStartScript(scriptText);
+
+	if (!dsGameSetup->Init(scriptText)) {
+		// read the script provided by cmdline
+		LOG_L(L_ERROR, "failed to load script %s", scriptName.c_str());
+		return nullptr;
+	}
+
+	// create the server, it will run in a separate thread
+	CGlobalUnsyncedRNG rng;
+
+	const uint32_t randSeed = time(nullptr) % ((spring_gettime().toNanoSecsi() + 1) * 9007);
+
+	rng.Seed(randSeed);
+	dsGameData->SetRandomSeed(rng.NextInt());
+
+	{
+		sha512::raw_digest dsMapChecksum;
+		sha512::raw_digest dsModChecksum;
+		sha512::hex_digest dsMapChecksumHex;
+		sha512::hex_digest dsModChecksumHex;
+
+		std::memcpy(dsMapChecksum.data(), &dsGameSetup->dsMapHash[0], sizeof(dsGameSetup->dsMapHash));
+		std::memcpy(dsModChecksum.data(), &dsGameSetup->dsModHash[0], sizeof(dsGameSetup->dsModHash));
+		sha512::dump_digest(dsMapChecksum, dsMapChecksumHex);
+		sha512::dump_digest(dsModChecksum, dsModChecksumHex);
+
+		LOG("[script-checksums]\n\tmap=%s\n\tmod=%s", dsMapChecksumHex.data(), dsModChecksumHex.data());
+
+		// use script-provided hashes if any byte is non-zero; these
+		// are only used by some client-side (pregame) sanity checks
+		const auto hashPred = [](uint8_t byte) { return (byte != 0); };
+
+		if (std::find_if(dsMapChecksum.begin(), dsMapChecksum.end(), hashPred) != dsMapChecksum.end()) {
+			dsGameData->SetMapChecksum(dsMapChecksum.data());
+			dsGameSetup->LoadStartPositions(false); // reduced mode
+		} else {
+			dsGameData->SetMapChecksum(&archiveScanner->GetArchiveCompleteChecksumBytes(dsGameSetup->mapName)[0]);
+
+			// the map stays in the (shared) VFS for any later game on it
+			CFileHandler f("maps/" + dsGameSetup->mapName);
+			if (!f.FileExists())
+				vfsHandler->AddArchiveWithDeps(dsGameSetup->mapName, false);
+
+			dsGameSetup->LoadStartPositions(); // full mode
+		}
+
+		if (std::find_if(dsModChecksum.begin(), dsModChecksum.end(), hashPred) != dsModChecksum.end()) {
+			dsGameData->SetModChecksum(dsModChecksum.data());
+		} else {
+			const std::string& modArchive = archiveScanner->ArchiveFromName(dsGameSetup->modName);
+			const sha512::raw_digest& modCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(modArchive);
+
+			dsGameData->SetModChecksum(&modCheckSum[0]);
+		}
+	}
+
+	LOG("starting server...");
+
+	dsGameData->SetSetupText(dsGameSetup->setupText);
+	return std::unique_ptr<CGameServer>(new CGameServer(dsClientSetup, dsGameData, dsGameSetup));
+}
+
+
+static std::unique_ptr<CGameServer> TryStartServer(const std::string& scriptName)
+{
+	// one broken script must not take the other games down
+	try {
+		return (StartServer(scriptName));
+	} catch (const std::exception& e) {
+		LOG_L(L_ERROR, "[%s] could not host a game from \"%s\": %s", __func__, scriptName.c_str(), e.what());
+	}
+
+	return nullptr;
+}
+
+
+struct HostedGame {
+	std::string scriptName;
+	std::unique_ptr<CGameServer> server;
+
+	bool spooled;
+	bool printedData;
+};
+
+static void StartSpooledGames(std::vector<HostedGame>& games)
+{
+	const std::string spoolDir = FileSystemAbstraction::EnsurePathSepAtEnd(FLAGS_spool_dir);
+
+	std::vector<std::string> scripts;
+
+	FileSystemAbstraction::FindFiles(scripts, spoolDir, "", FileSystem::ConvertGlobToRegex("*.txt"), 0);
+
+	for (const std::string& script: scripts) {
+		const std::string scriptName = spoolDir + script;
+
+		// claim it, so it is not started twice
+		if (std::rename(scriptName.c_str(), (scriptName + ".running").c_str()) != 0)
+			continue;
+
+		std::unique_ptr<CGameServer> server = TryStartServer(scriptName + ".running");
+
+		if (server == nullptr) {
+			std::rename((scriptName + ".running").c_str(), (scriptName + ".failed").c_str());
+			continue;
+		}
+
+		games.push_back({scriptName, std::move(server), true, false});
+	}
+}
+
+static bool UpdateHostedGame(HostedGame& game)
+{
+	const std::unique_ptr<CGameServer>& server = game.server;
+
+	if (server->HasFinished()) {
+		LOG("game from script %s has finished", game.scriptName.c_str());
+		return false;
+	}
+
+	// wait until gameID has been generated (or the server quits if no clients connect)
+	if (game.printedData || !server->HasGameID())
+		return true;
+
+	if ((game.printedData = (server->GetDemoRecorder() != nullptr))) {
+		const std::unique_ptr<CDemoRecorder>& demoRec = server->GetDemoRecorder();
+		const std::shared_ptr<const CGameSetup> gameSetup = server->GetGameSetup();
+		const std::uint8_t* gameID = (demoRec->GetFileHeader()).gameID;
+
+		LOG("recording demo: %s", (demoRec->GetName()).c_str());
+		LOG("using mod: %s", (gameSetup->modName).c_str());
+		LOG("using map: %s", (gameSetup->mapName).c_str());
+		LOG("GameID: %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", gameID[0], gameID[1], gameID[2], gameID[3], gameID[4], gameID[5], gameID[6], gameID[7], gameID[8], gameID[9], gameID[10], gameID[11], gameID[12], gameID[13], gameID[14], gameID[15]);
+	}
+
+	return true;
+}
+
+
 int main(int argc, char* argv[])
 {
 	Threading::SetMainThread();
@@ -117,16 +283,16 @@ int main(int argc, char* argv[])
 
 		CLogOutput::LogSystemInfo();
 
-		std::string scriptName;
-		std::string scriptText;
+		std::vector<std::string> scriptNames;
 		std::string binaryName = argv[0];
 
-		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt");
+		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt [more_scripts.txt ...]");
 		gflags::SetVersionString(SpringVersion::GetFull());
 		gflags::ParseCommandLineFlags(&argc, &argv, true);
-		ParseCmdLine(argc, argv, scriptName);
+		ParseCmdLine(argc, argv, scriptNames);
 
 		globalConfig.Init();
+		// archives are scanned once, all games share the scanner and VFS
 		FileSystemInitializer::InitializeLogOutput();
 		FileSystemInitializer::Initialize();
 
@@ -134,110 +300,51 @@ int main(int argc, char* argv[])
 		CrashHandler::Install();
 
 		LOG("report any errors to Mantis or the forums.");
-		LOG("loading script from file: %s", scriptName.c_str());
-
-		// server will take ownership of these
-		std::shared_ptr<ClientSetup> dsClientSetup(new ClientSetup());
-		std::shared_ptr<GameData> dsGameData(new GameData());
-		std::shared_ptr<CGameSetup> dsGameSetup(new CGameSetup());
-
-		CFileHandler fh(scriptName);
-
-		if (!fh.FileExists())
-			throw content_error("script does not exist in given location: " + scriptName);
-
-		if (!fh.LoadStringData(scriptText))
-			throw content_error("script cannot be read: " + scriptName);
-
-		dsClientSetup->LoadFromStartScript(scriptText);
-
-		if (!dsGameSetup->Init(scriptText)) {
-			// read the script provided by cmdline
-			LOG_L(L_ERROR, "failed to load script %s", scriptName.c_str());
-			return 1;
-		}
-
-		// create the server, it will run in a separate thread
-		CGlobalUnsyncedRNG rng;
 
 		const uint32_t sleepTime = FLAGS_sleeptime;
-		const uint32_t randSeed = time(nullptr) % ((spring_gettime().toNanoSecsi() + 1) * 9007);
-
-		rng.Seed(randSeed);
-		dsGameData->SetRandomSeed(rng.NextInt());
-
-		{
-			sha512::raw_digest dsMapChecksum;
-			sha512::raw_digest dsModChecksum;
-			sha512::hex_digest dsMapChecksumHex;
-			sha512::hex_digest dsModChecksumHex;
-
-			std::memcpy(dsMapChecksum.data(), &dsGameSetup->dsMapHash[0], sizeof(dsGameSetup->dsMapHash));
-			std::memcpy(dsModChecksum.data(), &dsGameSetup->dsModHash[0], sizeof(dsGameSetup->dsModHash));
-			sha512::dump_digest(dsMapChecksum, dsMapChecksumHex);
-			sha512::dump_digest(dsModChecksum, dsModChecksumHex);
-
-			LOG("[script-checksums]\n\tmap=%s\n\tmod=%s", dsMapChecksumHex.data(), dsModChecksumHex.data());
 
-			// use script-provided hashes if any byte is non-zero; these
-			// are only used by some client-side (pregame) sanity checks
-			const auto hashPred = [](uint8_t byte) { return (byte != 0); };
+		std::vector<HostedGame> games;
+		games.reserve(scriptNames.size());
 
-			if (std::find_if(dsMapChecksum.begin(), dsMapChecksum.end(), hashPred) != dsMapChecksum.end()) {
-				dsGameData->SetMapChecksum(dsMapChecksum.data());
-				dsGameSetup->LoadStartPositions(false); // reduced mode
-			} else {
-				dsGameData->SetMapChecksum(&archiveScanner->GetArchiveCompleteChecksumBytes(dsGameSetup->mapName)[0]);
+		if (scriptNames.size() == 1 && FLAGS_spool_dir.empty()) {
+			// single game, a broken script is fatal
+			games.push_back({scriptNames[0], StartServer(scriptNames[0]), false, false});
 
-				CFileHandler f("maps/" + dsGameSetup->mapName);
-				if (!f.FileExists())
-					vfsHandler->AddArchiveWithDeps(dsGameSetup->mapName, false);
+			if (games.back().server == nullptr)
+				return 1;
+		} else {
+			for (const std::string& scriptName: scriptNames) {
+				std::unique_ptr<CGameServer> server = TryStartServer(scriptName);
 
-				dsGameSetup->LoadStartPositions(); // full mode
-			}
-
-			if (std::find_if(dsModChecksum.begin(), dsModChecksum.end(), hashPred) != dsModChecksum.end()) {
-				dsGameData->SetModChecksum(dsModChecksum.data());
-			} else {
-				const std::string& modArchive = archiveScanner->ArchiveFromName(dsGameSetup->modName);
-				const sha512::raw_digest& modCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(modArchive);
+				if (server == nullptr)
+					continue;
 
-				dsGameData->SetModChecksum(&modCheckSum[0]);
+				games.push_back({scriptName, std::move(server), false, false});
 			}
 		}
 
-		LOG("starting server...");
-
-		{
-			dsGameData->SetSetupText(dsGameSetup->setupText);
-			CGameServer server(dsClientSetup, dsGameData, dsGameSetup);
-
-			while (!server.HasGameID()) {
-				// wait until gameID has been generated or
-				// a timeout occurs (if no clients connect)
-				if (server.HasFinished())
-					break;
-
-				spring_sleep(spring_secs(sleepTime));
-			}
+		// each server runs in its own thread; finished ones are destroyed
+		// (which writes their demo) while the others keep going
+		while (!games.empty() || !FLAGS_spool_dir.empty()) {
+			if (!FLAGS_spool_dir.empty())
+				StartSpooledGames(games);
 
-			while (!server.HasFinished()) {
-				static bool printData = (server.GetDemoRecorder() != nullptr);
+			for (size_t i = 0; i < games.size(); ) {
+				if (UpdateHostedGame(games[i])) {
+					i++;
+					continue;
+				}
 
-				if (printData) {
-					printData = false;
+				games[i].server.reset();
 
-					const std::unique_ptr<CDemoRecorder>& demoRec = server.GetDemoRecorder();
-					const std::uint8_t* gameID = (demoRec->GetFileHeader()).gameID;
+				if (games[i].spooled)
+					std::rename((games[i].scriptName + ".running").c_str(), (games[i].scriptName + ".done").c_str());
 
-					LOG("recording demo: %s", (demoRec->GetName()).c_str());
-					LOG("using mod: %s", (dsGameSetup->modName).c_str());
-					LOG("using map: %s", (dsGameSetup->mapName).c_str());
-					LOG("GameID: %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", gameID[0], gameID[1], gameID[2], gameID[3], gameID[4], gameID[5], gameID[6], gameID[7], gameID[8], gameID[9], gameID[10], gameID[11], gameID[12], gameID[13], gameID[14], gameID[15]);
-				}
-
-				spring_secs(sleepTime).sleep(true);
+				std::swap(games[i], games.back());
+				games.pop_back();
 			}
+
+			spring_secs(sleepTime).sleep(true);
 		}
 
 		LOG("exiting");
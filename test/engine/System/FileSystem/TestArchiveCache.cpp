@@ -0,0 +1,201 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirLocater.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+static const char* modInfoFmt =
+	"return {\n"
+	"\tname = \"%s\",\n"
+	"\tshortname = \"ACT\",\n"
+	"\tversion = \"v1.0\",\n"
+	"\tdescription = \"archive cache test\",\n"
+	"\tmodtype = 1,\n"
+	"\tonlyLocal = true,\n"
+	"\tmaxplayers = 8.5,\n"
+	"\tdepend = {\"Some Base Game v2\"},\n"
+	"}\n";
+
+static void WriteFile(const std::string& filePath, const std::string& content)
+{
+	FILE* file = fopen(filePath.c_str(), "wb");
+	REQUIRE(file != nullptr);
+	fwrite(content.data(), 1, content.size(), file);
+	fclose(file);
+}
+
+static std::string ReadFile(const std::string& filePath)
+{
+	std::string content;
+	FILE* file = fopen(filePath.c_str(), "rb");
+
+	if (file == nullptr)
+		return content;
+
+	char buf[4096];
+
+	for (size_t n = 0; (n = fread(buf, 1, sizeof(buf), file)) > 0; ) {
+		content.append(buf, n);
+	}
+
+	fclose(file);
+	return content;
+}
+
+static std::string ModInfo(const char* name)
+{
+	char buf[1024];
+	snprintf(buf, sizeof(buf), modInfoFmt, name);
+	return buf;
+}
+
+
+namespace {
+	struct PrepareDataDir {
+		PrepareDataDir() {
+			// scanning logs its progress with timestamps
+			spring_clock::PushTickRate(true);
+			spring_time::setstarttime(spring_time::gettime(true));
+
+			oldDir = FileSystem::GetCwd();
+			dataDir = FileSystem::EnsurePathSepAtEnd(oldDir + tmpnam(nullptr));
+
+			FileSystem::CreateDirectory(dataDir + "games/cachetest.sdd");
+			WriteFile(dataDir + "games/cachetest.sdd/modinfo.lua", ModInfo("Archive Cache Test"));
+			WriteFile(dataDir + "games/cachetest.sdd/readme.txt", "some content to hash");
+			// not an archive, ends up in the cache's broken list
+			WriteFile(dataDir + "games/broken.sdz", "garbage");
+
+			// the scanner reads SpringDataRoot, keep the user's config out of it
+			ConfigHandler::Instantiate(dataDir + "springsettings.cfg");
+
+			dataDirLocater.SetIsolationMode(true);
+			dataDirLocater.SetIsolationModeDir(dataDir);
+			dataDirLocater.LocateDataDirs();
+			dataDirLocater.Check();
+		}
+		~PrepareDataDir() {
+			ConfigHandler::Deallocate();
+			FileSystem::ChDir(oldDir);
+		}
+
+		std::string oldDir;
+		std::string dataDir;
+	};
+}
+
+
+static void CheckSameArchives(const std::vector<CArchiveScanner::ArchiveData>& a, const std::vector<CArchiveScanner::ArchiveData>& b)
+{
+	REQUIRE(a.size() == b.size());
+
+	for (size_t i = 0; i < a.size(); i++) {
+		const auto& ai = a[i].GetInfo();
+		const auto& bi = b[i].GetInfo();
+
+		INFO(a[i].GetNameVersioned());
+		REQUIRE(ai.size() == bi.size());
+
+		for (size_t j = 0; j < ai.size(); j++) {
+			CHECK(ai[j].first == bi[j].first);
+			CHECK(ai[j].second.valueType == bi[j].second.valueType);
+			CHECK(ai[j].second.GetValueAsString() == bi[j].second.GetValueAsString());
+		}
+
+		CHECK(a[i].GetDependencies() == b[i].GetDependencies());
+	}
+}
+
+
+TEST_CASE("ArchiveCacheRoundTrip")
+{
+	PrepareDataDir dd;
+
+	std::vector<CArchiveScanner::ArchiveData> scanned;
+	sha512::raw_digest checksum;
+	std::string cacheFile;
+
+	{
+		// scans everything, hashing the archive marks the cache dirty again
+		CArchiveScanner scanner;
+
+		scanned = scanner.GetAllArchives();
+		checksum = scanner.GetArchiveSingleChecksumBytes(scanner.GetArchivePath("cachetest.sdd") + "cachetest.sdd");
+		// relative to the write-dir, which is the cwd
+		cacheFile = scanner.GetFilepath();
+	}
+
+	REQUIRE(scanned.size() == 1);
+	CHECK(scanned[0].GetNameVersioned() == "Archive Cache Test v1.0");
+	CHECK(scanned[0].GetOnlyLocal());
+	CHECK(scanned[0].GetModType() == 1);
+
+	const std::string image = ReadFile(cacheFile);
+
+	REQUIRE(!image.empty());
+	CHECK(!FileSystem::FileExists(cacheFile + ".tmp"));
+
+	// change the archive without touching its timestamps; only a scanner that
+	// takes the archive from the cache still sees the old contents
+	const std::string modInfoFile = dd.dataDir + "games/cachetest.sdd/modinfo.lua";
+
+	struct stat info;
+	REQUIRE(stat(modInfoFile.c_str(), &info) == 0);
+
+	WriteFile(modInfoFile, ModInfo("Changed Name"));
+
+	struct utimbuf times = {info.st_atime, info.st_mtime};
+	REQUIRE(utime(modInfoFile.c_str(), &times) == 0);
+
+	{
+		CArchiveScanner scanner;
+
+		CheckSameArchives(scanner.GetAllArchives(), scanned);
+		CHECK(scanner.GetArchiveSingleChecksumBytes(scanner.GetArchivePath("cachetest.sdd") + "cachetest.sdd") == checksum);
+	}
+
+	// nothing changed, so nothing was written
+	CHECK(ReadFile(cacheFile) == image);
+	CHECK(!FileSystem::FileExists(cacheFile + ".tmp"));
+
+	// a damaged cache is ignored, everything is scanned again and the cache replaced
+	std::string damaged = image;
+	damaged[damaged.size() / 2] ^= 0x55;
+	WriteFile(cacheFile, damaged);
+
+	{
+		CArchiveScanner scanner;
+		const std::vector<CArchiveScanner::ArchiveData>& rescanned = scanner.GetAllArchives();
+
+		REQUIRE(rescanned.size() == 1);
+		CHECK(rescanned[0].GetNameVersioned() == "Changed Name v1.0");
+	}
+
+	const std::string rewritten = ReadFile(cacheFile);
+
+	CHECK(!rewritten.empty());
+	CHECK(rewritten != damaged);
+	CHECK(!FileSystem::FileExists(cacheFile + ".tmp"));
+
+	{
+		CArchiveScanner scanner;
+		const std::vector<CArchiveScanner::ArchiveData>& cached = scanner.GetAllArchives();
+
+		REQUIRE(cached.size() == 1);
+		CHECK(cached[0].GetNameVersioned() == "Changed Name v1.0");
+	}
+}
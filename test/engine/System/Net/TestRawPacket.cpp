@@ -0,0 +1,131 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/RawPacket.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using netcode::RawPacket;
+
+
+TEST_CASE("RawPacketSizeClasses")
+{
+	// every size up to and past the largest class has to be usable and aligned
+	for (uint32_t size = 1; size <= (16 * 1024); size += ((size < 600)? 1: 97)) {
+		RawPacket pkt(size);
+
+		REQUIRE(pkt.data != nullptr);
+		REQUIRE(pkt.length == size);
+		CHECK((reinterpret_cast<uintptr_t>(pkt.data) % alignof(uint64_t)) == 0);
+
+		memset(pkt.data, 0xAB, size);
+	}
+
+	CHECK(RawPacket(0u).data == nullptr);
+}
+
+TEST_CASE("RawPacketReuse")
+{
+	// blocks of the same class are recycled, most recently freed first
+	uint8_t* ptr = nullptr;
+
+	{
+		RawPacket pkt(100u);
+		ptr = pkt.data;
+	}
+	{
+		RawPacket pkt(90u);
+		CHECK(pkt.data == ptr);
+	}
+	{
+		// shrinking the length does not change the class the block is freed to
+		RawPacket pkt(100u);
+		pkt.length = 10;
+		CHECK(pkt.data == ptr);
+	}
+	{
+		RawPacket pkt(100u);
+		CHECK(pkt.data == ptr);
+	}
+
+	// packets themselves come from the pool as well
+	void* mem = nullptr;
+
+	{
+		std::unique_ptr<RawPacket> pkt(new RawPacket(8u));
+		mem = pkt.get();
+	}
+	{
+		std::unique_ptr<RawPacket> pkt(new RawPacket(8u));
+		CHECK(pkt.get() == mem);
+	}
+}
+
+TEST_CASE("RawPacketData")
+{
+	const uint8_t src[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+	RawPacket a(src, sizeof(src));
+	REQUIRE(a.length == sizeof(src));
+	CHECK(std::equal(src, src + sizeof(src), a.data));
+
+	RawPacket b(std::move(a));
+	CHECK(a.data == nullptr);
+	CHECK(a.length == 0);
+	CHECK(std::equal(src, src + sizeof(src), b.data));
+
+	RawPacket c(1 + sizeof(uint32_t) + 6, 42);
+	c << uint32_t(0xDEADBEEF);
+	c << std::string("hello");
+	CHECK(c.data[0] == 42);
+	CHECK(c.pos == c.length);
+	CHECK(std::string(reinterpret_cast<const char*>(c.data + 5)) == "hello");
+}
+
+TEST_CASE("RawPacketThreads")
+{
+	// packets are created by the network threads and freed by the game
+	constexpr int numThreads = 4;
+	constexpr int numIters = 20000;
+
+	std::vector<std::thread> threads;
+	std::vector<int> errors(numThreads, 0);
+
+	for (int t = 0; t < numThreads; t++) {
+		threads.emplace_back([t, &errors]() {
+			std::vector< std::unique_ptr<RawPacket> > held;
+
+			for (int i = 0; i < numIters; i++) {
+				const uint32_t size = 1 + ((i * 37 + t * 101) % 3000);
+				const uint8_t mark = uint8_t(t * 31 + i);
+
+				held.emplace_back(new RawPacket(size));
+				memset(held.back()->data, mark, size);
+
+				// keep some alive for a while so frees interleave with other threads' allocs
+				if (held.size() < 64)
+					continue;
+
+				for (const auto& pkt: held) {
+					const uint8_t m = pkt->data[0];
+					errors[t] += !std::all_of(pkt->data, pkt->data + pkt->length, [m](uint8_t b) { return (b == m); });
+				}
+
+				held.clear();
+			}
+		});
+	}
+
+	for (std::thread& t: threads) {
+		t.join();
+	}
+
+	for (int t = 0; t < numThreads; t++) {
+		CHECK(errors[t] == 0);
+	}
+}
@@ -1,6 +1,15 @@
 
 #include "System/Net/UDPListener.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/ProtocolDef.h"
+#include "System/Net/RawPacket.h"
 #include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "Net/SpectatorRelay.h"
+
+#include <cstring>
+#include <vector>
 
 
 #define CATCH_CONFIG_MAIN
@@ -89,3 +98,301 @@ TEST_CASE("TryBindSocket")
 	t.TestPort(-1, false);
 }
 
+
+
+
+static void InitSpringTime()
+{
+	static bool inited = false;
+
+	if (inited)
+		return;
+
+	spring_clock::PushTickRate(true);
+	spring_time::setstarttime(spring_time::gettime(true));
+	inited = true;
+}
+
+static std::vector<uint8_t> LuaMsgData(unsigned int size, unsigned int seed)
+{
+	// words from a small vocabulary, compressible like real traffic but not trivially
+	static const char* words[] = {"move", "attack", "guard", "patrol", "reclaim", "repair", "unit", "feature"};
+
+	std::vector<uint8_t> data;
+	data.reserve(size + 8);
+
+	while (data.size() < size) {
+		seed = seed * 1103515245 + 12345;
+
+		for (const char* c = words[(seed >> 16) & 7]; *c != 0; ++c)
+			data.push_back(*c);
+
+		// plus a unit-id
+		for (unsigned int n = (seed >> 8) & 0xfff; n != 0; n /= 10)
+			data.push_back('0' + (n % 10));
+
+		data.push_back(' ');
+	}
+
+	data.resize(size);
+	return data;
+}
+
+static void Transfer(netcode::UDPConnection& sender, netcode::UDPConnection& receiver, const std::vector< std::vector<uint8_t> >& msgs)
+{
+	for (const std::vector<uint8_t>& msg: msgs) {
+		sender.SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendLuaMsg(0, 0, 0, msg)));
+	}
+
+	sender.Flush(true);
+
+	const spring_time startTime = spring_gettime();
+
+	for (size_t i = 0; i < msgs.size(); ) {
+		receiver.Update();
+		sender.Update();
+
+		std::shared_ptr<const netcode::RawPacket> pkt = receiver.GetData();
+
+		if (pkt == nullptr) {
+			REQUIRE((spring_gettime() - startTime) < spring_secs(5));
+			spring_msecs(1).sleep();
+			continue;
+		}
+
+		// NETMSG_LUAMSG: id, size, player, script, mode, data
+		constexpr unsigned int headerSize = 1 + 2 + 1 + 2 + 1;
+
+		REQUIRE(pkt->data[0] == NETMSG_LUAMSG);
+		REQUIRE(pkt->length == (headerSize + msgs[i].size()));
+		CHECK(std::equal(msgs[i].begin(), msgs[i].end(), pkt->data + headerSize));
+		i++;
+	}
+}
+
+TEST_CASE("UDPConnectionCompression")
+{
+	InitSpringTime();
+
+	// two ends talking over loopback, each with its own socket
+	netcode::UDPConnection host(23451, "127.0.0.1", 23452);
+	netcode::UDPConnection client(23452, "127.0.0.1", 23451);
+
+	host.Unmute();
+	client.Unmute();
+	host.SetAllowCompression(true);
+	client.SetAllowCompression(true);
+
+	// many small messages merged into one block
+	std::vector< std::vector<uint8_t> > msgs;
+
+	for (unsigned int i = 0; i < 40; i++) {
+		msgs.push_back(LuaMsgData(50 + i, i));
+	}
+
+	// only the host starts compressing, the client has to follow suit
+	host.EnableCompression();
+	Transfer(host, client, msgs);
+
+	CHECK(host.GetSentUncompressed() > 0);
+	CHECK(client.GetRecvUncompressed() == host.GetSentUncompressed());
+
+	Transfer(client, host, msgs);
+
+	CHECK(client.GetSentUncompressed() > 0);
+	CHECK(host.GetRecvUncompressed() == client.GetSentUncompressed());
+
+	// a block larger than a chunk and the MTU, split across several packets
+	msgs.clear();
+	msgs.push_back(LuaMsgData(8000, 7));
+	msgs.push_back(LuaMsgData(100, 8));
+
+	const unsigned int sentBefore = host.GetSentUncompressed();
+
+	Transfer(host, client, msgs);
+
+	CHECK(host.GetSentUncompressed() > sentBefore);
+	CHECK(client.GetRecvUncompressed() == host.GetSentUncompressed());
+
+	// disallowed, messages go out as they are
+	host.SetAllowCompression(false);
+	msgs.clear();
+	msgs.push_back(LuaMsgData(500, 9));
+
+	const unsigned int sentDisabled = host.GetSentUncompressed();
+
+	Transfer(host, client, msgs);
+
+	CHECK(host.GetSentUncompressed() == sentDisabled);
+}
+
+
+static std::shared_ptr<const netcode::RawPacket> Receive(netcode::UDPConnection& sender, netcode::UDPConnection& receiver)
+{
+	const spring_time startTime = spring_gettime();
+
+	while (!receiver.HasIncomingData()) {
+		REQUIRE((spring_gettime() - startTime) < spring_secs(5));
+		spring_msecs(1).sleep();
+
+		receiver.Update();
+		sender.Update();
+	}
+
+	return receiver.GetData();
+}
+
+TEST_CASE("UDPConnectionFrameBatches")
+{
+	InitSpringTime();
+
+	netcode::UDPConnection server(23453, "127.0.0.1", 23454);
+	netcode::UDPConnection client(23454, "127.0.0.1", 23453);
+
+	server.Unmute();
+	client.Unmute();
+	// as done by CNetProtocol
+	client.SetExpandFrameBatches(true);
+
+	// the client gets the batched frames one by one
+	server.SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendNewFrames(3)));
+	server.SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendKeyFrame(4)));
+	server.Flush(true);
+
+	for (unsigned int i = 0; i < 3; i++) {
+		const std::shared_ptr<const netcode::RawPacket> pkt = Receive(server, client);
+
+		CHECK(pkt->data[0] == NETMSG_NEWFRAME);
+		CHECK(pkt->length == 1);
+	}
+
+	CHECK(Receive(server, client)->data[0] == NETMSG_KEYFRAME);
+
+	// a client can not inject frames into the server's queue
+	client.SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendNewFrames(200)));
+	client.Flush(true);
+
+	const std::shared_ptr<const netcode::RawPacket> pkt = Receive(client, server);
+
+	CHECK(pkt->data[0] == NETMSG_NEWFRAMES);
+	CHECK(!server.HasIncomingData());
+}
+
+
+
+static int32_t KeyFrameNum(const netcode::RawPacket* pkt)
+{
+	int32_t frameNum = -1;
+	REQUIRE(pkt->data[0] == NETMSG_KEYFRAME);
+	memcpy(&frameNum, pkt->data + 1, sizeof(frameNum));
+	return frameNum;
+}
+
+TEST_CASE("SpectatorRelay")
+{
+	InitSpringTime();
+
+	constexpr unsigned int numClients = 4;
+	constexpr unsigned int numRelayed = 3;
+	constexpr unsigned int numFrames = 2000;
+
+	// the server side, all links share the listener's socket
+	netcode::UDPListener listener(23461, "127.0.0.1");
+
+	std::vector< std::shared_ptr<netcode::UDPConnection> > clients;
+	std::vector< std::shared_ptr<netcode::UDPConnection> > links;
+
+	for (unsigned int i = 0; i < numClients; i++) {
+		clients.emplace_back(new netcode::UDPConnection(23462 + i, "127.0.0.1", 23461));
+		clients.back()->Unmute();
+		clients.back()->SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendKeyFrame(i)));
+		clients.back()->Flush(true);
+	}
+
+	const spring_time startTime = spring_gettime();
+
+	while (links.size() < numClients) {
+		REQUIRE((spring_gettime() - startTime) < spring_secs(5));
+
+		listener.Update();
+
+		if (!listener.HasIncomingConnections()) {
+			spring_msecs(1).sleep();
+			continue;
+		}
+
+		links.push_back(listener.AcceptConnection());
+		links.back()->Unmute();
+
+		// the hello-packet
+		REQUIRE(links.back()->GetData() != nullptr);
+	}
+
+	// all but the first link are handed to the relay thread, which sends on
+	// the shared socket while this thread keeps receiving and sending on it
+	CSpectatorRelay relay;
+	relay.Init(1);
+
+	for (unsigned int i = numClients - numRelayed; i < numClients; i++) {
+		relay.AddLink(links[i]);
+	}
+
+	std::vector<unsigned int> numRecvFrames(numClients, 0);
+	std::vector<unsigned int> numSentPings(numClients, 0);
+	std::vector<unsigned int> numRecvPings(numClients, 0);
+
+	unsigned int frameNum = 0;
+
+	while (true) {
+		REQUIRE((spring_gettime() - startTime) < spring_secs(30));
+
+		// a few frames per iteration so packets pile up on both threads
+		for (unsigned int n = 0; n < 4 && frameNum < numFrames; n++, frameNum++) {
+			std::shared_ptr<const netcode::RawPacket> pkt(CBaseNetProtocol::Get().SendKeyFrame(frameNum));
+
+			relay.Broadcast(pkt);
+
+			for (unsigned int i = 0; i < (numClients - numRelayed); i++) {
+				links[i]->SendData(pkt);
+			}
+		}
+
+		listener.Update();
+
+		bool done = (frameNum == numFrames);
+
+		for (unsigned int i = 0; i < numClients; i++) {
+			netcode::UDPConnection* client = clients[i].get();
+
+			// clients talk back, so the listener keeps reading while the relay sends
+			if (numSentPings[i] < numFrames) {
+				client->SendData(std::shared_ptr<const netcode::RawPacket>(CBaseNetProtocol::Get().SendKeyFrame(numSentPings[i]++)));
+			}
+
+			client->Update();
+
+			for (std::shared_ptr<const netcode::RawPacket> pkt; (pkt = client->GetData()) != nullptr; ) {
+				REQUIRE(KeyFrameNum(pkt.get()) == int32_t(numRecvFrames[i]++));
+			}
+
+			for (std::shared_ptr<const netcode::RawPacket> pkt; (pkt = links[i]->GetData()) != nullptr; ) {
+				REQUIRE(KeyFrameNum(pkt.get()) == int32_t(numRecvPings[i]++));
+			}
+
+			done &= (numRecvFrames[i] == numFrames);
+			done &= (numRecvPings[i] == numFrames);
+		}
+
+		if (done)
+			break;
+
+		spring_msecs(1).sleep();
+	}
+
+	for (unsigned int i = numClients - numRelayed; i < numClients; i++) {
+		relay.RemoveLink(links[i]);
+		CHECK(!links[i]->IsRelayed());
+	}
+
+	relay.Kill();
+}
@@ -0,0 +1,303 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "DemoIndex.h"
+
+#include "Net/Protocol/NetMessageTypes.h"
+#include "System/Exceptions.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/LoadSave/DemoReader.h"
+#include "System/Net/RawPacket.h"
+
+
+template<typename T> static T ReadAt(const netcode::RawPacket* packet, uint32_t pos)
+{
+	T value = T(0);
+
+	if ((pos + sizeof(T)) <= packet->length)
+		memcpy(&value, packet->data + pos, sizeof(T));
+
+	return value;
+}
+
+static uint8_t GetPacketPlayer(const netcode::RawPacket* packet)
+{
+	uint32_t pos = 0;
+
+	// the sender follows the message-size, if any (see NetMessageTypes.h)
+	switch (packet->data[0]) {
+		case NETMSG_SETPLAYERNUM:
+		case NETMSG_PATH_CHECKSUM:
+		case NETMSG_PAUSE:
+		case NETMSG_USER_SPEED:
+		case NETMSG_DIRECT_CONTROL:
+		case NETMSG_DC_UPDATE:
+		case NETMSG_SHARE:
+		case NETMSG_SETSHARE:
+		case NETMSG_PLAYERSTAT:
+		case NETMSG_SYNCRESPONSE:
+		case NETMSG_STARTPOS:
+		case NETMSG_PLAYERINFO:
+		case NETMSG_PLAYERLEFT:
+		case NETMSG_TEAM:
+		case NETMSG_ALLIANCE:
+		case NETMSG_AI_STATE_CHANGED:
+		case NETMSG_PING: {
+			pos = 1;
+		} break;
+
+		case NETMSG_PLAYERNAME:
+		case NETMSG_CHAT:
+		case NETMSG_GAMEOVER:
+		case NETMSG_MAPDRAW:
+		case NETMSG_AI_CREATED: {
+			pos = 2;
+		} break;
+
+		case NETMSG_COMMAND:
+		case NETMSG_SELECT:
+		case NETMSG_AICOMMAND:
+		case NETMSG_AICOMMAND_TRACKED:
+		case NETMSG_AICOMMANDS:
+		case NETMSG_AISHARE:
+		case NETMSG_SYSTEMMSG:
+		case NETMSG_LOGMSG:
+		case NETMSG_LUAMSG:
+		case NETMSG_CREATE_NEWPLAYER:
+		case NETMSG_CLIENTDATA: {
+			pos = 3;
+		} break;
+
+		case NETMSG_CCOMMAND: {
+			// int32, unlike everywhere else
+			const int32_t playerNum = ReadAt<int32_t>(packet, 3);
+			return ((playerNum >= 0 && playerNum < DemoIndex::NO_PLAYER)? playerNum: DemoIndex::NO_PLAYER);
+		} break;
+
+		default: {
+			return DemoIndex::NO_PLAYER;
+		} break;
+	}
+
+	return ((pos < packet->length)? packet->data[pos]: DemoIndex::NO_PLAYER);
+}
+
+static uint32_t GetPacketCommands(const netcode::RawPacket* packet)
+{
+	switch (packet->data[0]) {
+		case NETMSG_COMMAND:
+		case NETMSG_AICOMMAND:
+		case NETMSG_AICOMMAND_TRACKED: {
+			return 1;
+		} break;
+
+		case NETMSG_AICOMMANDS: {
+			// the command-count follows the unit-ID list
+			const int16_t numUnitIDs = ReadAt<int16_t>(packet, 13);
+			const int16_t numCommands = ReadAt<int16_t>(packet, 15 + std::max(int16_t(0), numUnitIDs) * sizeof(int16_t));
+
+			return std::max(int16_t(0), numCommands);
+		} break;
+
+		default: {
+		} break;
+	}
+
+	return 0;
+}
+
+
+void DemoIndex::Build(CDemoReader& reader)
+{
+	// counts, bytes and commands of the current frame, keyed by (msgType << 8) | player
+	std::map<uint16_t, std::array<uint32_t, 3>> frameStats;
+
+	const auto AddFrameRows = [&]() {
+		for (const auto& p: frameStats) {
+			msgTypes.push_back(p.first >> 8);
+			players.push_back(p.first & 0xFF);
+			counts.push_back(p.second[0]);
+			bytes.push_back(p.second[1]);
+			commands.push_back(p.second[2]);
+		}
+
+		frameRows.push_back(msgTypes.size());
+		frameStats.clear();
+	};
+
+	const uint64_t streamSize = reader.GetFileHeader().demoStreamSize;
+
+	// size of the chunks read so far, headers included (as in demoStreamSize)
+	uint64_t numStreamBytes = 0;
+	float prevModGameTime = 0.0f;
+
+	while (!reader.ReachedEnd()) {
+		// the reader has already read the header of the chunk GetData returns next;
+		// a non-finite time would also keep it from ever returning that chunk
+		const float modGameTime = reader.GetModGameTime();
+
+		if (!std::isfinite(modGameTime) || modGameTime < prevModGameTime)
+			throw content_error("corrupt chunk header at stream offset " + std::to_string(numStreamBytes));
+
+		std::unique_ptr<netcode::RawPacket> packet(reader.GetData(std::numeric_limits<float>::max()));
+
+		// only happens on a short read of a chunk or of the header after it
+		if (packet == nullptr)
+			throw content_error("demo stream truncated at offset " + std::to_string(numStreamBytes));
+
+		numStreamBytes += (sizeof(DemoStreamChunkHeader) + packet->length);
+		prevModGameTime = modGameTime;
+
+		if (packet->length == 0)
+			continue;
+
+		const uint8_t msgType = packet->data[0];
+
+		// a frame-packet starts the frame it belongs to
+		if (msgType == NETMSG_NEWFRAME || msgType == NETMSG_KEYFRAME)
+			AddFrameRows();
+
+		std::array<uint32_t, 3>& stats = frameStats[(msgType << 8) | GetPacketPlayer(packet.get())];
+
+		stats[0] += 1;
+		stats[1] += packet->length;
+		stats[2] += GetPacketCommands(packet.get());
+	}
+
+	// the stream can also end cleanly on a chunk boundary if the file was cut there
+	// (a demoStreamSize of 0 means the recording never finished, there is no size)
+	if (streamSize != 0 && numStreamBytes != streamSize)
+		throw content_error("demo stream truncated at offset " + std::to_string(numStreamBytes) + " of " + std::to_string(streamSize));
+
+	AddFrameRows();
+}
+
+bool DemoIndex::Write(const std::string& file) const
+{
+	std::ofstream out(file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!out.is_open())
+		return false;
+
+	const auto WriteColumn = [&](const void* data, size_t size) { out.write(reinterpret_cast<const char*>(data), size); };
+
+	const uint32_t header[] = {VERSION, GetNumFrames(), GetNumRows()};
+
+	WriteColumn("sdfzidx", 8);
+	WriteColumn(header, sizeof(header));
+	WriteColumn(frameRows.data(), frameRows.size() * sizeof(frameRows[0]));
+	WriteColumn(msgTypes.data(), msgTypes.size() * sizeof(msgTypes[0]));
+	WriteColumn(players.data(), players.size() * sizeof(players[0]));
+	WriteColumn(counts.data(), counts.size() * sizeof(counts[0]));
+	WriteColumn(bytes.data(), bytes.size() * sizeof(bytes[0]));
+	WriteColumn(commands.data(), commands.size() * sizeof(commands[0]));
+
+	return out.good();
+}
+
+std::string DemoIndex::GetSummary(const std::string& demoFile) const
+{
+	uint64_t numPackets = 0;
+	uint64_t numBytes = 0;
+	uint64_t numCommands = 0;
+
+	uint32_t peakFrame = 0;
+	uint32_t peakCommands = 0;
+
+	for (uint32_t frame = 0, numFrames = GetNumFrames(); frame < numFrames; frame++) {
+		uint32_t frameCommands = 0;
+
+		for (uint32_t row = frameRows[frame]; row < frameRows[frame + 1]; row++) {
+			numPackets += counts[row];
+			numBytes += bytes[row];
+			frameCommands += commands[row];
+		}
+
+		numCommands += frameCommands;
+
+		if (frameCommands <= peakCommands)
+			continue;
+
+		peakFrame = frame;
+		peakCommands = frameCommands;
+	}
+
+	std::ostringstream buf;
+	buf << demoFile << ";" << GetNumFrames() << ";" << numPackets << ";" << numBytes << ";" << numCommands << ";" << peakFrame << ";" << peakCommands;
+	return buf.str();
+}
+
+
+
+unsigned IndexDemos(const std::vector<std::string>& demoFiles, const std::string& outDir, unsigned numThreads)
+{
+	std::atomic<size_t> nextDemo = {0};
+	std::atomic<unsigned> numFailures = {0};
+	std::mutex outMutex;
+
+	const auto IndexDemo = [&](const std::string& demoFile) {
+		const std::string indexFile = (outDir.empty()? demoFile: (outDir + "/" + FileSystem::GetFilename(demoFile))) + ".idx";
+
+		std::string summary;
+		std::string error;
+
+		try {
+			CDemoReader reader(demoFile, 0.0f);
+			DemoIndex index;
+
+			index.Build(reader);
+
+			if (index.Write(indexFile)) {
+				summary = index.GetSummary(demoFile);
+			} else {
+				error = "could not write " + indexFile;
+			}
+		} catch (const std::exception& e) {
+			error = e.what();
+		}
+
+		std::lock_guard<std::mutex> lock(outMutex);
+
+		if (error.empty()) {
+			std::cout << summary << std::endl;
+		} else {
+			std::cerr << "[" << demoFile << "] " << error << std::endl;
+			numFailures += 1;
+		}
+	};
+	const auto IndexNextDemos = [&]() {
+		for (size_t i = nextDemo++; i < demoFiles.size(); i = nextDemo++) {
+			IndexDemo(demoFiles[i]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+
+	std::cout << "file;frames;packets;bytes;commands;peakCommandsFrame;peakCommands" << std::endl;
+
+	for (unsigned i = 1; i < std::max(1u, numThreads); i++) {
+		threads.emplace_back(IndexNextDemos);
+	}
+
+	IndexNextDemos();
+
+	for (std::thread& t: threads) {
+		t.join();
+	}
+
+	return numFailures;
+}
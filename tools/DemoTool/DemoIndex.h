@@ -0,0 +1,65 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_INDEX_H
+#define DEMO_INDEX_H
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+class CDemoReader;
+
+/**
+ * Compact columnar index of the traffic in a demo, built in a single pass
+ * over its packet stream.
+ *
+ * There is one row per (frame, message-type, player) combination that
+ * occurs; the rows of frame f are [frameRows[f], frameRows[f + 1]), where
+ * frame f starts with the f-th NEWFRAME/KEYFRAME (so f matches the sim's
+ * frame-number) and frame 0 holds everything received before the first.
+ * Messages without a sender use player NO_PLAYER.
+ *
+ * On-disk layout (native byte-order, columns stored back to back):
+ *   char     magic[8]            "sdfzidx"
+ *   uint32   version, numFrames, numRows
+ *   uint32   frameRows[numFrames + 1]
+ *   uint8    msgTypes[numRows]
+ *   uint8    players[numRows]
+ *   uint32   counts[numRows]     number of messages
+ *   uint32   bytes[numRows]      their total size
+ *   uint32   commands[numRows]   unit commands they carry
+ */
+struct DemoIndex
+{
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint8_t NO_PLAYER = 0xFF;
+
+	/// throws content_error if the stream is truncated or has a corrupt chunk header
+	void Build(CDemoReader& reader);
+	bool Write(const std::string& file) const;
+
+	uint32_t GetNumFrames() const { return (frameRows.size() - 1); }
+	uint32_t GetNumRows() const { return msgTypes.size(); }
+
+	/// one line of "file;frames;packets;bytes;commands;peakCommandsFrame;peakCommands"
+	std::string GetSummary(const std::string& demoFile) const;
+
+	std::vector<uint32_t> frameRows = {0};
+
+	std::vector<uint8_t> msgTypes;
+	std::vector<uint8_t> players;
+
+	std::vector<uint32_t> counts;
+	std::vector<uint32_t> bytes;
+	std::vector<uint32_t> commands;
+};
+
+
+/**
+ * Indexes each of <demoFiles> on <numThreads> threads, writing the index of
+ * "x.sdfz" to "<outDir>/x.sdfz.idx" (or next to the demo if outDir is empty)
+ * and a summary line per demo to stdout. Returns the number of failures.
+ */
+unsigned IndexDemos(const std::vector<std::string>& demoFiles, const std::string& outDir, unsigned numThreads);
+
+#endif // DEMO_INDEX_H
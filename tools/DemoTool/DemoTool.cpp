@@ -3,9 +3,13 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <thread>
 #include <gflags/gflags.h>
 #include <iomanip> //hex
 
+#include "DemoIndex.h"
 #include "StringSerializer.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
@@ -17,6 +21,9 @@
 Usage:
 Start with the full! path to the demofile as the only argument
 
+With --index every demo given (as arguments and/or listed one per line in
+the --batch file) is indexed in parallel instead, see DemoIndex.h
+
 Please note that not all NETMSG's are implemented, expand if needed.
 
 When compiling for windows with MinGW, make sure to use the
@@ -32,10 +39,15 @@ no console output (you still could use this.exe > z.tzt though).
 	DEFINE_bool  (teamstats,    false, "Print teamstats");
 	DEFINE_int32 (team,         -1,    "Select team");
 	DEFINE_string(teamsstatcsv, "",    "Write teamstats in a csv file");
+	DEFINE_bool  (index,        false, "Write a <demo>.idx traffic index per demo and print a summary line for each");
+	DEFINE_string(indexdir,     "",    "Directory to write the indices to instead of next to the demos");
+	DEFINE_string(batch,        "",    "File listing the demos to index, one path per line");
+	DEFINE_int32 (jobs,         0,     "Number of demos to index in parallel (0: one per core)");
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
 void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string& file);
+int IndexDemoFiles(int argc, char* argv[]);
 
 int main (int argc, char* argv[])
 {
@@ -43,6 +55,9 @@ int main (int argc, char* argv[])
 
 	gflags::SetUsageMessage(std::string("Usage: ") + argv[0] + " [options] path_to_demo.sdfz");
 	gflags::ParseCommandLineFlags(&argc, &argv, true);
+	if (FLAGS_index)
+		return IndexDemoFiles(argc, argv);
+
 	if (!FLAGS_demofile.empty()) {
 		filename = FLAGS_demofile;
 	} else if (argc >= 2) {
@@ -114,6 +129,38 @@ int main (int argc, char* argv[])
 }
 
 
+int IndexDemoFiles(int argc, char* argv[])
+{
+	std::vector<std::string> demoFiles;
+
+	if (!FLAGS_demofile.empty())
+		demoFiles.push_back(FLAGS_demofile);
+
+	for (int i = 1; i < argc; ++i)
+		demoFiles.push_back(argv[i]);
+
+	if (!FLAGS_batch.empty())
+	{
+		std::ifstream batch(FLAGS_batch.c_str());
+		std::string line;
+
+		if (!batch.is_open())
+		{
+			std::cout << "Could not open batch file " << FLAGS_batch << std::endl;
+			return 1;
+		}
+		while (std::getline(batch, line))
+		{
+			if (!line.empty())
+				demoFiles.push_back(line);
+		}
+	}
+
+	const unsigned numThreads = (FLAGS_jobs > 0)? FLAGS_jobs: std::thread::hardware_concurrency();
+	return (IndexDemos(demoFiles, FLAGS_indexdir, std::min(numThreads, unsigned(demoFiles.size()))) != 0);
+}
+
+
 static std::map<int, std::string> cmdIdToName;
 
 void InitCommandNames()
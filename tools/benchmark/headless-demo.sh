@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# replays a demo with spring-headless at unlimited speed and writes
+# a JSON report (per-frame sim-times, percentiles, peak memory and
+# profiler totals); exits with 1005 if any of the limits is exceeded
+#
+# usage: headless-demo.sh <demofile> [report.json] [limits]
+#   e.g. headless-demo.sh demos/game.sdfz report.json p50=5,p99=20,max=100
+
+set -e
+
+SPRING=${SPRING:-./spring-headless}
+DEMOFILE="$1"
+REPORT="${2:-benchmark.json}"
+LIMITS="$3"
+
+if [ -z "$DEMOFILE" ]; then
+	echo "usage: $0 <demofile> [report.json] [limits]" >&2
+	exit 1
+fi
+
+exec "$SPRING" --benchmark-report "$REPORT" --benchmark-limits "$LIMITS" "$DEMOFILE"